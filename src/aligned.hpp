@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Allocator returning storage aligned to 'Align' bytes (a cache line, and wide
+// enough for the largest SIMD register), so SoA arrays start on a vector boundary.
+template <class T, std::size_t Align = 64>
+struct AlignedAllocator {
+    using value_type = T;
+    template <class U> struct rebind { using other = AlignedAllocator<U, Align>; };
+
+    AlignedAllocator() noexcept = default;
+    template <class U> AlignedAllocator(const AlignedAllocator<U, Align>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Align)));
+    }
+    void deallocate(T* p, std::size_t) noexcept {
+        ::operator delete(p, std::align_val_t(Align));
+    }
+
+    template <class U> bool operator==(const AlignedAllocator<U, Align>&) const noexcept { return true; }
+    template <class U> bool operator!=(const AlignedAllocator<U, Align>&) const noexcept { return false; }
+};
+
+// std::vector whose data() is 64-byte aligned
+template <class T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// AlignedAllocator whose resize() leaves new elements uninitialized (default-init),
+// for arrays that are always written before they are read. The pages are then
+// committed by the first write, on the NUMA node of the thread doing it, so a
+// parallel loop that fills the array places every thread's share next to it.
+template <class T, std::size_t Align = 64>
+struct FirstTouchAllocator : AlignedAllocator<T, Align> {
+    template <class U> struct rebind { using other = FirstTouchAllocator<U, Align>; };
+
+    FirstTouchAllocator() noexcept = default;
+    template <class U> FirstTouchAllocator(const FirstTouchAllocator<U, Align>&) noexcept {}
+
+    template <class U> void construct(U* p) noexcept { ::new (static_cast<void*>(p)) U; }
+    template <class U, class... Args> void construct(U* p, Args&&... args) {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+};
+
+// AlignedVector that is placed by first touch instead of zeroed by resize()
+template <class T>
+using FirstTouchVector = std::vector<T, FirstTouchAllocator<T>>;
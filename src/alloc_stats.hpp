@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+
+// Process-wide heap allocation counter. alloc_stats.cpp replaces the global
+// operator new/delete, so every allocation through new (std::vector, std::string,
+// AlignedAllocator, ...) is counted with one relaxed atomic increment.
+namespace allocStats {
+
+// Allocations since program start
+uint64_t allocations();
+
+// Bytes requested since program start
+uint64_t bytes();
+
+} // namespace allocStats
@@ -0,0 +1,97 @@
+#include "batch.hpp"
+#include "flock.hpp"
+#include <algorithm>
+#include <cmath>
+#include "trace.hpp"
+
+void BoidBatch::draw(SDL_Renderer* renderer, const BoidState& state, const uint8_t* colors,
+                     const RGBA* palette, const SpeciesTable& species, bool dark,
+                     const BoidState* prev, size_t prevCount, float alpha, float maxJump,
+                     const uint32_t* drawSlot) {
+    TRACE_SCOPE("render.boids");
+    const size_t n = state.size();
+    if (n == 0) return;
+    vertices.resize(3 * n);
+
+    tinted.resize(PALETTE_SIZE);
+    for (int k = 0; k < PALETTE_SIZE; ++k) {
+        RGBA col = palette[k];
+        if (dark) {
+            col.r = (Uint8)(col.r * 0.35f);
+            col.g = (Uint8)(col.g * 0.35f);
+            col.b = (Uint8)(col.b * 0.45f);
+        }
+        tinted[k] = {col.r, col.g, col.b, col.a};
+    }
+    const SDL_Color* lut = tinted.data();
+
+    if (!prev || alpha >= 1.f) prevCount = 0;
+    prevCount = std::min(prevCount, n);
+    const float* qx = prev ? prev->px.data() : nullptr;
+    const float* qy = prev ? prev->py.data() : nullptr;
+
+    const float* px = state.px.data();
+    const float* py = state.py.data();
+    const float* vx = state.vx.data();
+    const float* vy = state.vy.data();
+    SDL_Vertex* out = vertices.data();
+
+    if (detail == BoidDetail::Dots) {
+        #pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < n; ++i) {
+            float x = px[i], y = py[i];
+            if (i < prevCount) {
+                const float dx = x - qx[i], dy = y - qy[i];
+                if (std::fabs(dx) < maxJump && std::fabs(dy) < maxJump) {
+                    x = qx[i] + dx * alpha;
+                    y = qy[i] + dy * alpha;
+                }
+            }
+            const SDL_Color sc = lut[colors[i]];
+            SDL_Vertex* v = out + 3 * (drawSlot ? drawSlot[i] : i);
+            v[0] = {{x - 1.f, y - 1.f}, sc, {0.f, 0.f}};
+            v[1] = {{x + 2.f, y - 1.f}, sc, {0.f, 0.f}};
+            v[2] = {{x - 1.f, y + 2.f}, sc, {0.f, 0.f}};
+        }
+        TRACE_SCOPE("render.boids.submit");
+        SDL_RenderGeometry(renderer, nullptr, out, (int)vertices.size(), nullptr, 0);
+        return;
+    }
+
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n; ++i) {
+        // Same triangle as Bird::render, rotated by heading + PI/2:
+        // cos(h + PI/2) = -vy/|v|, sin(h + PI/2) = vx/|v|, so no trig is needed
+        const float v2 = vx[i] * vx[i] + vy[i] * vy[i];
+        float c = 0.f, s = 1.f;            // atan2(0, 0) = 0
+        if (v2 > 0.f) {
+            const float inv = 1.f / std::sqrt(v2);
+            c = -vy[i] * inv;
+            s =  vx[i] * inv;
+        }
+
+        // Local vertices (0, -2r), (-r, 2r), (r, 2r) rotated and translated
+        const float r = species.params[species.of(i)].r;
+        float x = px[i], y = py[i];
+        if (i < prevCount) {
+            const float dx = x - qx[i], dy = y - qy[i];
+            if (std::fabs(dx) < maxJump && std::fabs(dy) < maxJump) {
+                x = qx[i] + dx * alpha;
+                y = qy[i] + dy * alpha;
+            }
+        }
+        const float ax =  2.f * r * s,             ay = -2.f * r * c;
+        const float bx = -r * c - 2.f * r * s,     by = -r * s + 2.f * r * c;
+        const float cx =  r * c - 2.f * r * s,     cy =  r * s + 2.f * r * c;
+
+        const SDL_Color sc = lut[colors[i]];
+
+        SDL_Vertex* v = out + 3 * (drawSlot ? drawSlot[i] : i);
+        v[0] = {{x + ax, y + ay}, sc, {0.f, 0.f}};
+        v[1] = {{x + bx, y + by}, sc, {0.f, 0.f}};
+        v[2] = {{x + cx, y + cy}, sc, {0.f, 0.f}};
+    }
+
+    TRACE_SCOPE("render.boids.submit");
+    SDL_RenderGeometry(renderer, nullptr, out, (int)vertices.size(), nullptr, 0);
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+struct RGBA;
+struct BoidState;
+struct SpeciesTable;
+
+// How boids are drawn: the rotated Bird::render triangle, or a small unrotated dot
+// (a 3 px triangle: no heading math and far fewer pixels to fill)
+enum class BoidDetail { Full, Dots };
+
+// Draws the whole flock as filled triangles with a single SDL_RenderGeometry call.
+// The vertex buffer persists between frames and only grows, so steady-state
+// frames do not allocate; vertices are computed in parallel.
+class BoidBatch {
+public:
+    // Rebuilds the vertices for every boid of 'state' and submits them.
+    // Boid i is drawn in palette[colors[i]] (PALETTE_SIZE entries) with the size r
+    // of its species; dark applies the same tint as Bird::render.
+    // The first prevCount boids are drawn at prev + (state - prev) * alpha, except
+    // when they moved more than maxJump (wrapped around the window border).
+    // With drawSlot (a permutation of the boids), boid i is drawn at position drawSlot[i]
+    // instead of i, so the stacking of overlapping boids does not follow the array order.
+    void draw(SDL_Renderer* renderer, const BoidState& state, const uint8_t* colors,
+              const RGBA* palette, const SpeciesTable& species, bool dark,
+              const BoidState* prev = nullptr, size_t prevCount = 0,
+              float alpha = 1.f, float maxJump = 0.f, const uint32_t* drawSlot = nullptr);
+
+    size_t vertexCount() const { return vertices.size(); }
+
+    void setDetail(BoidDetail d) { detail = d; }
+    BoidDetail getDetail() const { return detail; }
+
+private:
+    // 3 vertices per boid; triangles share no vertices, so no index buffer
+    std::vector<SDL_Vertex> vertices;
+    std::vector<SDL_Color> tinted;   // palette after the dark tint, resolved once per draw
+    BoidDetail detail = BoidDetail::Full;
+};
@@ -1,58 +1,39 @@
 #include "cat.hpp"
 
-// Destructor: frees textures
-Cat::~Cat() {
-    for (auto& [_, s] : strips) {
-        if (s.tex) SDL_DestroyTexture(s.tex);
-        s.tex = nullptr;
-    }
-}
-
 // Loads a strip from a sprite sheet image
-bool Cat::loadStrip(SDL_Renderer* r, CatState st, const char* path,
-                    int fw, int fh, int frames, float frameDur,
-                    int marginX, int marginY, int spacingX) {
-    SDL_Surface* s = IMG_Load(path);
-    if (!s) { std::cerr << "IMG_Load(" << path << "): " << IMG_GetError() << "\n"; return false; }
-    SDL_Texture* tex = SDL_CreateTextureFromSurface(r, s);
-    if (!tex) { std::cerr << "SDL_CreateTextureFromSurface: " << SDL_GetError() << "\n"; SDL_FreeSurface(s); return false; }
-    Strip stp;
-    stp.tex = tex;
-    stp.texW = s->w; stp.texH = s->h;
+bool CatSprites::loadStrip(CatState st, const char* path,
+                           int fw, int fh, int frames, float frameDur,
+                           int marginX, int marginY, int spacingX) {
+    const int sheet = atlas.addSheet(path);
+    if (sheet < 0) return false;
+    SpriteStrip stp;
+    stp.sheet = sheet;
     stp.fw = fw; stp.fh = fh;
     stp.frames = frames;
     stp.frameDur = frameDur;
     stp.marginX = marginX; stp.marginY = marginY;
     stp.spacingX = spacingX;
-    SDL_FreeSurface(s);
-    strips[st] = stp;
+    strips[(int)st] = stp;
     return true;
 }
 
-// Returns the strip of the current state, or IdleBack if not found
-const Cat::Strip& Cat::cur() const {
-    auto it = strips.find(state);
-    if (it != strips.end() && it->second.tex) return it->second;
-
-    auto itIdle = strips.find(CatState::IdleBack);
-    if (itIdle != strips.end()) return itIdle->second;
-
-    static Strip dummy;
-    return dummy;
+// Uploads the atlas and resolves where each strip landed
+bool CatSprites::build(SDL_Renderer* r) {
+    if (!atlas.build(r)) return false;
+    for (SpriteStrip& s : strips) s.resolve(atlas);
+    return true;
 }
 
-// Returns the number of frames in a strip
-int Cat::frameCount(const Strip& s) const {
-    if (s.frames > 0) return s.frames;
-
-    int usableW = s.texW - s.marginX;
-    int perRow  = std::max(0, usableW + s.spacingX) / (s.fw + s.spacingX);
-    return std::max(1, perRow);
+// Returns the strip of the current state, or IdleBack if not found
+const SpriteStrip& Cat::cur() const {
+    if (sprites) return sprites->strip(state);
+    static SpriteStrip dummy;
+    return dummy;
 }
 
 // Places the cat at the bottom of the window
 void Cat::placeAtBottom(int /*W*/, int H) {
-    const Strip& s = cur();
+    const SpriteStrip& s = cur();
     y = H - s.fh * scale - 20.f;
 }
 
@@ -60,7 +41,7 @@ void Cat::placeAtBottom(int /*W*/, int H) {
 void Cat::goTo(float px, float /*py*/) {
     tx = px;
 
-    const Strip& s = cur();
+    const SpriteStrip& s = cur();
     ty = y + s.fh * scale * 0.5f;
     moving = true;
     pickWalkState();
@@ -69,7 +50,7 @@ void Cat::goTo(float px, float /*py*/) {
 
 // Picks walking state based on target position
 void Cat::pickWalkState() {
-    const Strip& s = cur();
+    const SpriteStrip& s = cur();
     float cx = x + s.fw * scale * 0.5f;
     float cy = y + s.fh * scale * 0.5f;
     float dx = tx - cx, dy = ty - cy;
@@ -82,7 +63,7 @@ void Cat::pickWalkState() {
 
 // Updates the cat's position and animation
 void Cat::update(float dt) {
-    const Strip& s = cur();
+    const SpriteStrip& s = cur();
     if (moving) {
         float cx = x + s.fw * scale * 0.5f;
         float cy = y + s.fh * scale * 0.5f;
@@ -101,38 +82,29 @@ void Cat::update(float dt) {
         state = CatState::IdleBack;
     }
 
-    const Strip& s2 = cur();
-    int fcount = frameCount(s2);
+    const SpriteStrip& s2 = cur();
+    if (!s2.loaded()) return;
     tAcc += dt;
     while (tAcc >= s2.frameDur) {
         tAcc -= s2.frameDur;
-        frame = (frame + 1) % fcount;
+        frame = (frame + 1) % s2.frames;
     }
 }
 
-// Renders the cat at its current position
-void Cat::render(SDL_Renderer* r) {
-    const Strip& s = cur();
-    if (!s.tex) return;
-    int fcount = frameCount(s);
-    int col = frame % fcount;
-
-    int sx = s.marginX + col * (s.fw + s.spacingX);
-    int sy = s.marginY; 
-    SDL_Rect src{ sx, sy, s.fw, s.fh };
-
-    int dw = int(s.fw * scale), dh = int(s.fh * scale);
-    SDL_Rect dst{ int(x), int(y), dw, dh };
-
-    SDL_RenderCopy(r, s.tex, &src, &dst);
+// Queues the cat at its current position
+void Cat::render(SpriteBatch& batch) const {
+    const SpriteStrip& s = cur();
+    if (!s.loaded()) return;
+    const SDL_FRect dst{ std::floor(x), std::floor(y), std::floor(s.fw * scale), std::floor(s.fh * scale) };
+    batch.add(s.frame(frame), dst);
 }
 
 // Clamps the cat's position to stay within the window
 void Cat::clampToWindow(int W, int H) {
-    const Strip& s = cur();
+    const SpriteStrip& s = cur();
     float dw = s.fw * scale, dh = s.fh * scale;
     if (x < 0) x = 0;
     if (y < 0) y = 0;
     if (x + dw > W) x = W - dw;
     if (y + dh > H) y = H - dh;
-}
\ No newline at end of file
+}
@@ -1,29 +1,39 @@
 #pragma once
 #include <SDL2/SDL.h>
-#include <SDL2/SDL_image.h>
-#include <map>
+#include <array>
 #include <iostream>
 #include <cmath>
 #include <algorithm>
+#include "sprites.hpp"
 
 // Possible states of the cat
-enum class CatState { IdleBack, WalkLeft, WalkRight, WalkUp };
+enum class CatState { IdleBack, WalkLeft, WalkRight, WalkUp, Count };
+constexpr int CAT_STATES = (int)CatState::Count;
+
+// Animation strips of every cat state, packed in one atlas and shared by all cats
+struct CatSprites {
+    SpriteAtlas atlas;
+    std::array<SpriteStrip, CAT_STATES> strips;   // indexed by CatState
+
+    // Adds the strip of a state from a sprite sheet image (uploaded by build())
+    bool loadStrip(CatState st, const char* path,
+                   int fw, int fh, int frames = -1, float frameDur = 0.12f,
+                   int marginX = 0, int marginY = 0, int spacingX = 0);
+    // State st uses the strip of 'from'
+    void alias(CatState st, CatState from) { strips[(int)st] = strips[(int)from]; }
+    // Packs the sheets into the atlas texture and locates every strip in it
+    bool build(SDL_Renderer* r);
+
+    // Strip of state st, or IdleBack if st has none
+    const SpriteStrip& strip(CatState st) const {
+        const SpriteStrip& s = strips[(int)st];
+        return s.loaded() ? s : strips[(int)CatState::IdleBack];
+    }
+};
 
 // Cat class representing the animated character
 class Cat {
-
-// Structure representing a sprite strip
 public:
-    struct Strip {
-        SDL_Texture* tex = nullptr;
-        int texW = 0, texH = 0;   // texture size
-        int fw = 31, fh = 36;     // frame size
-        int frames = -1;          // number of frames (-1 = auto)
-        float frameDur = 0.05f;   // seg x frame
-        int marginX = 0, marginY = 0; // margin in texture
-        int spacingX = 0;         // horizontal spacing between frames
-    };
-
     // Transform
     float x = 40.f, y = 0.f; // position
     float scale = 3.f; // scale factor
@@ -37,27 +47,20 @@ public:
     bool moving = false; // is the cat currently moving?
     float tx = 0.f, ty = 0.f; // target position
 
-    // Sprites for each state
-    std::map<CatState, Strip> strips;
+    // Sprites for each state (not owned)
+    const CatSprites* sprites = nullptr;
 
 public:
-    Cat() = default; // default constructor
-    ~Cat(); // destructor
-
-    // Loads a strip from a sprite sheet image
-    bool loadStrip(SDL_Renderer* r, CatState st, const char* path,
-                   int fw, int fh, int frames = -1, float frameDur = 0.12f,
-                   int marginX = 0, int marginY = 0, int spacingX = 0);
+    explicit Cat(const CatSprites* s = nullptr) : sprites(s) {}
 
     void placeAtBottom(int W, int H); // places the cat at the bottom of the window
     void goTo(float px, float py); // sets a target position for the cat to walk to
     void pickWalkState(); // picks walking state based on target position
 
     void update(float dt); // updates the cat's position and animation
-    void render(SDL_Renderer* r); // renders the cat at its current position
+    void render(SpriteBatch& batch) const; // queues the cat at its current position
     void clampToWindow(int W, int H); // clamps the cat's position to stay within the window
 
 private:
-    const Strip& cur() const;      // strip of actual state
-    int frameCount(const Strip& s) const; // number of frames in a strip
-};
\ No newline at end of file
+    const SpriteStrip& cur() const;      // strip of actual state
+};
@@ -0,0 +1,134 @@
+#include "dashboard.hpp"
+#include "alloc_stats.hpp"
+#include "perf_counters.hpp"
+#include "trace.hpp"
+#include "imgui.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <omp.h>
+
+void PerfDashboard::addFrame(float simMs, float renderMs, float presentMs) {
+    const uint64_t total = allocStats::allocations();
+    allocs[head]  = lastAllocs ? (float)(total - lastAllocs) : 0.f;
+    lastAllocs    = total;
+    if (perfCounters::available()) {
+        const uint64_t m = perfCounters::read().misses;
+        misses[head] = lastMisses ? (float)(m - lastMisses) / 1000.f : 0.f;
+        lastMisses = m;
+    }
+    sim[head]     = simMs;
+    render[head]  = renderMs;
+    present[head] = presentMs;
+    head = (head + 1) % HISTORY;
+}
+
+void PerfDashboard::hide() {
+    trace::collectBusy(false);
+    busyMs.clear();
+}
+
+// Neighbors within the cohesion radius for every boid, counted on a private grid.
+// A full neighbor pass, so it runs only a few times per second.
+void PerfDashboard::updateHistogram(const BoidState& boids, const BoidParams& params, int width, int height) {
+    const size_t n = boids.size();
+    std::fill(hist, hist + HIST_BINS, 0.f);
+    meanNeighbors = 0.f;
+    if (n == 0) return;
+
+    const float radius = params.cohesionRadius;
+    const float r2 = radius * radius;
+    grid.build(boids.px.data(), boids.py.data(), boids.vx.data(), boids.vy.data(), n, radius, width, height);
+    counts.resize(n);
+
+    const float* spx = grid.spx.data();
+    const float* spy = grid.spy.data();
+    #pragma omp parallel for schedule(static)
+    for (size_t k = 0; k < n; ++k) {
+        const int c = grid.cellOf[grid.order[k]];
+        const int cx = c % grid.cols, cy = c / grid.cols;
+        const int x0 = std::max(cx - 1, 0), x1 = std::min(cx + 1, grid.cols - 1);
+        int count = 0;
+        for (int row = std::max(cy - 1, 0); row <= std::min(cy + 1, grid.rows - 1); ++row) {
+            int b, e;
+            grid.rowRange(row, x0, x1, b, e);
+            for (int j = b; j < e; ++j) {
+                const float dx = spx[k] - spx[j], dy = spy[k] - spy[j];
+                const float d2 = dx*dx + dy*dy;
+                count += (d2 > 0.f && d2 < r2);
+            }
+        }
+        counts[k] = count;
+    }
+
+    double sum = 0.0;
+    for (int c : counts) {
+        hist[std::min(c, HIST_BINS - 1)] += 1.f;
+        sum += c;
+    }
+    meanNeighbors = (float)(sum / n);
+}
+
+bool PerfDashboard::draw(const BoidState& boids, const BoidParams& params, int width, int height,
+                         DashboardKnobs& knobs) {
+    trace::collectBusy(true);
+    const int last = (head + HISTORY - 1) % HISTORY;
+
+    // Rolling frame times (values_offset = head so the newest sample is on the right)
+    char label[64];
+    const ImVec2 plotSize(0, 50);
+    std::snprintf(label, sizeof(label), "%.2f ms", sim[last]);
+    ImGui::PlotLines("Sim", sim, HISTORY, head, label, 0.f, FLT_MAX, plotSize);
+    std::snprintf(label, sizeof(label), "%.2f ms", render[last]);
+    ImGui::PlotLines("Render", render, HISTORY, head, label, 0.f, FLT_MAX, plotSize);
+    std::snprintf(label, sizeof(label), "%.2f ms", present[last]);
+    ImGui::PlotLines("Present", present, HISTORY, head, label, 0.f, FLT_MAX, plotSize);
+    std::snprintf(label, sizeof(label), "%.0f / frame", allocs[last]);
+    ImGui::PlotHistogram("Allocs", allocs, HISTORY, head, label, 0.f, FLT_MAX, ImVec2(0, 30));
+    if (perfCounters::available()) {
+        std::snprintf(label, sizeof(label), "%.0fk / frame", misses[last]);
+        ImGui::PlotLines("LLC misses", misses, HISTORY, head, label, 0.f, FLT_MAX, ImVec2(0, 30));
+    }
+
+    // Busy time of each OpenMP thread in the step's worksharing loops, smoothed
+    const int nthreads = std::max(knobs.threads, 1);
+    trace::takeBusy(takenMs, nthreads);
+    busyMs.resize(nthreads, 0.0);
+    double maxBusy = 1e-6;
+    for (int t = 0; t < nthreads; ++t) {
+        busyMs[t] = 0.9 * busyMs[t] + 0.1 * takenMs[t];
+        maxBusy = std::max(maxBusy, busyMs[t]);
+    }
+    ImGui::Text("Thread busy (flock loops, per frame):");
+    for (int t = 0; t < nthreads; ++t) {
+        std::snprintf(label, sizeof(label), "t%d %.2f ms", t, busyMs[t]);
+        ImGui::ProgressBar((float)(busyMs[t] / maxBusy), ImVec2(-1, 0), label);
+    }
+
+    if (++framesSinceHist >= 15) {
+        updateHistogram(boids, params, width, height);
+        framesSinceHist = 0;
+    }
+    std::snprintf(label, sizeof(label), "mean %.1f", meanNeighbors);
+    ImGui::PlotHistogram("Neighbors", hist, HIST_BINS, 0, label, 0.f, FLT_MAX, ImVec2(0, 60));
+
+    // Live knobs
+    bool changed = false;
+    changed |= ImGui::SliderInt("Threads", &knobs.threads, 1, std::max(omp_get_num_procs() * 2, knobs.threads));
+    static const char* schedules[] = {"static", "dynamic", "guided", "steal"};
+    int sched = (int)knobs.schedule;
+    if (ImGui::Combo("Schedule", &sched, schedules, 4)) {
+        knobs.schedule = (LoopSchedule)sched;
+        changed = true;
+    }
+    changed |= ImGui::SliderInt("Chunk", &knobs.chunk, 0, 1024, knobs.chunk == 0 ? "default" : "%d");
+    const float maxRadius = std::max({params.separationRadius, params.alignmentRadius, params.cohesionRadius});
+    changed |= ImGui::SliderFloat("Cell size", &knobs.cellSize, 0.f, 2.f * maxRadius,
+                                  knobs.cellSize <= 0.f ? "auto" : "%.0f px");
+    // Tiny cells would only blow up the cell count
+    if (knobs.cellSize > 0.f && knobs.cellSize < 8.f) knobs.cellSize = 8.f;
+    changed |= ImGui::SliderInt("Re-sort", &knobs.sortInterval, 0, 120,
+                                knobs.sortInterval == 0 ? "off" : "every %d steps");
+    changed |= ImGui::SliderFloat("Theta", &knobs.theta, 0.f, 1.5f, knobs.theta <= 0.f ? "exact" : "%.2f");
+    return changed;
+}
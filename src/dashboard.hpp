@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "engine.hpp"
+#include "grid.hpp"
+
+// Settings the performance panel can change while running
+struct DashboardKnobs {
+    int threads = 1;                               // omp_set_num_threads for the flock step
+    LoopSchedule schedule = LoopSchedule::Static;  // per-boid loop schedule
+    int chunk = 0;                                 // schedule chunk (0 = default)
+    float cellSize = 0.f;                          // grid cell side (0 = largest radius)
+    int sortInterval = 0;                          // steps between spatial re-sorts (0 = never)
+    float theta = 0.5f;                            // quadtree opening angle (0 = exact)
+};
+
+// Performance panel of the ImGui overlay: rolling frame-time plots, per-thread
+// busy time of the flock step, a neighbor-count histogram, heap allocations and
+// (with hardware counters) last-level cache misses per frame.
+class PerfDashboard {
+public:
+    static constexpr int HISTORY = 240;   // frames kept in the plots
+    static constexpr int HIST_BINS = 32;  // neighbor-count bins (last one is "and more")
+
+    // Records one frame's timings (milliseconds) and its allocation count
+    void addFrame(float simMs, float renderMs, float presentMs);
+
+    // Draws the panel inside the current ImGui window. 'boids' and 'params' feed the
+    // neighbor histogram; knobs are edited in place and true is returned when any changed.
+    bool draw(const BoidState& boids, const BoidParams& params, int width, int height,
+              DashboardKnobs& knobs);
+
+    // Turns per-thread busy collection off (call when the panel is not drawn)
+    void hide();
+
+private:
+    void updateHistogram(const BoidState& boids, const BoidParams& params, int width, int height);
+
+    float sim[HISTORY] = {}, render[HISTORY] = {}, present[HISTORY] = {}, allocs[HISTORY] = {};
+    float misses[HISTORY] = {};   // LLC misses of the whole process, in thousands
+    int head = 0;                 // next slot to write (also the plot offset)
+    uint64_t lastAllocs = 0, lastMisses = 0;
+
+    std::vector<double> busyMs;   // smoothed busy time per thread
+    std::vector<double> takenMs;
+
+    NeighborGrid grid;            // private grid for the histogram pass
+    std::vector<int> counts;      // neighbors per boid
+    float hist[HIST_BINS] = {};
+    float meanNeighbors = 0.f;
+    int framesSinceHist = 0;
+};
@@ -0,0 +1,338 @@
+#include "distributed.hpp"
+#include "flock.hpp"
+#include "rng.hpp"
+#include "trace.hpp"
+#include <mpi.h>
+#include <omp.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+// Wire format of a boid handed to another rank (ghost or migration)
+struct BoidRecord {
+    float px, py, vx, vy;
+    int32_t species;
+};
+
+// Per-rank time and traffic of the steps run so far
+struct StripCounters {
+    double haloS = 0, stepS = 0, migrateS = 0;
+    long long ghosts = 0, migrated = 0;
+};
+
+// Species of a distributed flock: the birds, plus predators when asked for
+SpeciesTable makeSpecies(const DistributedConfig& cfg) {
+    SpeciesTable species;
+    species.params[0].flock = cfg.flock;
+    if (cfg.predatorsPerRank > 0) species.params.push_back(predatorParams());
+    species.start.assign(species.count() + 1, 0);
+    species.updateRadii();
+    return species;
+}
+
+// One rank's strip of the world
+class StripFlock {
+    MPI_Comm comm;
+    int rank = 0, ranks = 1;
+    int worldWidth, height;
+    float stripWidth;
+    float halo;                          // ghost band: the largest interaction radius
+    SpeciesTable species;                // start[] describes 'state' of the current step
+    std::unique_ptr<FlockEngine> engine;
+    NeighborKernelSet kernels;
+
+    std::vector<BoidRecord> owned;
+    std::vector<BoidRecord> toLeft, toRight, fromLeft, fromRight;
+    FlockState state;                    // owned boids and ghosts of this step, bucketed by species
+    std::vector<int32_t> source;         // index in 'state' -> index in 'owned' (-1 = ghost)
+    std::vector<size_t> cursor;
+    FlockStats global;                   // of the whole world
+
+    int ownerOf(float x) const {
+        return std::clamp((int)std::floor(x / stripWidth), 0, ranks - 1);
+    }
+
+    // Sends 'out' to rank 'to' while receiving 'in' from rank 'from' (MPI_PROC_NULL = nobody)
+    void exchange(const std::vector<BoidRecord>& out, int to, std::vector<BoidRecord>& in, int from) {
+        int sendCount = (int)out.size(), recvCount = 0;
+        MPI_Sendrecv(&sendCount, 1, MPI_INT, to, 0, &recvCount, 1, MPI_INT, from, 0, comm, MPI_STATUS_IGNORE);
+        in.resize(recvCount);
+        MPI_Sendrecv(out.data(), sendCount * (int)sizeof(BoidRecord), MPI_BYTE, to, 1,
+                     in.data(), recvCount * (int)sizeof(BoidRecord), MPI_BYTE, from, 1, comm, MPI_STATUS_IGNORE);
+    }
+
+    void assemble(const std::vector<BoidRecord>& ghostsLeft, const std::vector<BoidRecord>& ghostsRight) {
+        const int ns = species.count();
+        std::vector<size_t>& start = species.start;
+        start.assign(ns + 1, 0);
+        const std::vector<BoidRecord>* lists[] = { &owned, &ghostsLeft, &ghostsRight };
+        for (const auto* list : lists)
+            for (const BoidRecord& b : *list) start[b.species + 1]++;
+        for (int s = 0; s < ns; ++s) start[s + 1] += start[s];
+
+        const size_t n = start[ns];
+        state.cur.resize(n);
+        source.resize(n);
+        cursor.assign(start.begin(), start.end() - 1);
+        auto put = [&](const BoidRecord& b, int32_t from) {
+            const size_t i = cursor[b.species]++;
+            state.cur.px[i] = b.px; state.cur.py[i] = b.py;
+            state.cur.vx[i] = b.vx; state.cur.vy[i] = b.vy;
+            source[i] = from;
+        };
+        for (size_t j = 0; j < owned.size(); ++j) put(owned[j], (int32_t)j);
+        for (const BoidRecord& b : ghostsLeft) put(b, -1);
+        for (const BoidRecord& b : ghostsRight) put(b, -1);
+        ++state.edits;
+        // Coherence is measured against the centroid of the whole world
+        state.stats = global;
+    }
+
+    void reduceStats() {
+        StatsAccum acc;
+        float cx = worldWidth * 0.5f, cy = height * 0.5f;
+        if (global.count > 0) { cx = global.centerX; cy = global.centerY; }
+        for (const BoidRecord& b : owned) acc.add(b.px, b.py, b.vx, b.vy, 0, cx, cy);
+
+        double sums[5] = { acc.sumSpeed, acc.sumDist, acc.sumX, acc.sumY, (double)acc.count };
+        float maxima[5] = { acc.maxSpeed, -acc.minX, -acc.minY, acc.maxX, acc.maxY };
+        MPI_Allreduce(MPI_IN_PLACE, sums, 5, MPI_DOUBLE, MPI_SUM, comm);
+        MPI_Allreduce(MPI_IN_PLACE, maxima, 5, MPI_FLOAT, MPI_MAX, comm);
+        acc.sumSpeed = sums[0]; acc.sumDist = sums[1]; acc.sumX = sums[2]; acc.sumY = sums[3];
+        acc.count = (size_t)sums[4];
+        acc.maxSpeed = maxima[0];
+        acc.minX = -maxima[1]; acc.minY = -maxima[2]; acc.maxX = maxima[3]; acc.maxY = maxima[4];
+        global = acc.finish(false);
+    }
+
+public:
+    StripFlock(MPI_Comm c, const DistributedConfig& cfg)
+        : comm(c), species(makeSpecies(cfg)), engine(createEngine(cfg.engine)),
+          kernels(selectNeighborKernels(cfg.simd)) {
+        MPI_Comm_rank(comm, &rank);
+        MPI_Comm_size(comm, &ranks);
+        worldWidth = cfg.width * ranks;
+        height = cfg.height;
+        stripWidth = (float)cfg.width;
+        halo = species.maxRadius();
+        if (!engine) engine = createEngine("grid");
+
+        // Every rank walks the same spawn keys as a single FlockingSystem of the whole
+        // world would (birds first, then predators) and keeps the boids of its strip
+        const CounterRng rng{cfg.seed};
+        const uint64_t birds = (uint64_t)cfg.boidsPerRank * ranks;
+        const uint64_t total = birds + (uint64_t)cfg.predatorsPerRank * ranks;
+        for (uint64_t k = 0; k < total; ++k) {
+            const int s = k < birds ? 0 : 1;
+            BoidRecord b;
+            b.species = s;
+            randomSpawn(rng, k, worldWidth, height, species.params[s].maxSpeed, b.px, b.py, b.vx, b.vy);
+            if (ownerOf(b.px) == rank) owned.push_back(b);
+        }
+        engine->reserve(owned.size() * 2);
+    }
+
+    void step(StripCounters& c) {
+        TRACE_SCOPE("mpi.step");
+        double t0 = MPI_Wtime();
+
+        // Ghosts: boids within 'halo' of an inner strip border. Forces do not reach
+        // across the world border (as in a single flock), so the ends have one neighbor.
+        const float x0 = rank * stripWidth, x1 = x0 + stripWidth;
+        const int left = rank > 0 ? rank - 1 : MPI_PROC_NULL;
+        const int right = rank < ranks - 1 ? rank + 1 : MPI_PROC_NULL;
+        toLeft.clear(); toRight.clear();
+        for (const BoidRecord& b : owned) {
+            if (left != MPI_PROC_NULL && b.px < x0 + halo) toLeft.push_back(b);
+            if (right != MPI_PROC_NULL && b.px >= x1 - halo) toRight.push_back(b);
+        }
+        exchange(toRight, right, fromLeft, left);
+        exchange(toLeft, left, fromRight, right);
+        c.ghosts += (long long)(fromLeft.size() + fromRight.size());
+        assemble(fromLeft, fromRight);
+        double t1 = MPI_Wtime();
+        c.haloS += t1 - t0;
+
+        StepParams sp;
+        sp.species = &species;
+        sp.width = worldWidth;
+        sp.height = height;
+        sp.kernels = kernels;
+        engine->step(state, sp);
+        for (size_t i = 0; i < source.size(); ++i) {
+            if (source[i] < 0) continue;
+            BoidRecord& b = owned[source[i]];
+            b.px = state.cur.px[i]; b.py = state.cur.py[i];
+            b.vx = state.cur.vx[i]; b.vy = state.cur.vy[i];
+        }
+        t0 = MPI_Wtime();
+        c.stepS += t0 - t1;
+
+        // Migration: a step moves a boid less than a strip, so it only ever lands in a
+        // neighbor strip, and wrapping around the world border makes rank 0 and the
+        // last rank neighbors (a ring)
+        const int ringLeft = (rank + ranks - 1) % ranks, ringRight = (rank + 1) % ranks;
+        toLeft.clear(); toRight.clear();
+        size_t kept = 0;
+        for (const BoidRecord& b : owned) {
+            const int o = ownerOf(b.px);
+            if (o == rank) owned[kept++] = b;
+            else if (o == ringRight) toRight.push_back(b);
+            else toLeft.push_back(b);
+        }
+        owned.resize(kept);
+        if (ranks > 1) {
+            exchange(toRight, ringRight, fromLeft, ringLeft);
+            exchange(toLeft, ringLeft, fromRight, ringRight);
+            owned.insert(owned.end(), fromLeft.begin(), fromLeft.end());
+            owned.insert(owned.end(), fromRight.begin(), fromRight.end());
+        }
+        c.migrated += (long long)(toLeft.size() + toRight.size());
+        reduceStats();
+        c.migrateS += MPI_Wtime() - t0;
+    }
+
+    size_t ownedCount() const { return owned.size(); }
+    const FlockStats& stats() const { return global; }
+    int worldW() const { return worldWidth; }
+};
+
+// Ghost exchange needs every interaction radius to fit in a strip
+bool checkStrip(const DistributedConfig& cfg, int rank) {
+    const float radius = makeSpecies(cfg).maxRadius();
+    if (cfg.width >= radius) return true;
+    if (rank == 0)
+        std::cerr << "[Error] --width " << cfg.width << " por rank es menor que el radio de interacción ("
+                  << radius << " px)\n";
+    return false;
+}
+
+// Max over the ranks of comm, on its rank 0
+double reduceMax(double v, MPI_Comm comm) {
+    double out = v;
+    MPI_Reduce(&v, &out, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+    return out;
+}
+
+} // namespace
+
+int runDistributed(const DistributedConfig& cfg, int& argc, char**& argv) {
+    MPI_Init(&argc, &argv);
+    int rank = 0, ranks = 1;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+    if (cfg.threads > 0) omp_set_num_threads(cfg.threads);
+    if (!checkStrip(cfg, rank)) {
+        MPI_Finalize();
+        return 1;
+    }
+
+    StripFlock flock(MPI_COMM_WORLD, cfg);
+    StripCounters c;
+    MPI_Barrier(MPI_COMM_WORLD);
+    const double start = MPI_Wtime();
+    for (int f = 0; f < cfg.frames; ++f) flock.step(c);
+    const double elapsed = reduceMax(MPI_Wtime() - start, MPI_COMM_WORLD);
+    const double halo = reduceMax(c.haloS, MPI_COMM_WORLD);
+    const double step = reduceMax(c.stepS, MPI_COMM_WORLD);
+    const double migrate = reduceMax(c.migrateS, MPI_COMM_WORLD);
+    long long traffic[2] = { c.ghosts, c.migrated }, total[2] = { 0, 0 };
+    MPI_Reduce(traffic, total, 2, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    long long count = (long long)flock.ownedCount(), minOwned = 0, maxOwned = 0;
+    MPI_Reduce(&count, &minOwned, 1, MPI_LONG_LONG, MPI_MIN, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&count, &maxOwned, 1, MPI_LONG_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        const FlockStats& s = flock.stats();
+        const int frames = std::max(cfg.frames, 1);
+        std::cerr << "[mpi] " << ranks << " ranks, mundo " << flock.worldW() << "x" << cfg.height << ", "
+                  << s.count << " boids, motor " << cfg.engine << ": " << cfg.frames << " pasos en " << elapsed
+                  << " s (" << elapsed * 1e3 / frames << " ms/paso)\n";
+        std::cerr << "[mpi] por paso (máximo entre ranks): fantasmas " << halo * 1e6 / frames
+                  << " us, paso local " << step * 1e6 / frames << " us, migración " << migrate * 1e6 / frames
+                  << " us; " << total[0] / frames << " fantasmas y " << total[1] / frames << " migraciones por paso\n";
+        std::cerr << "[mpi] boids por rank: min " << minOwned << ", max " << maxOwned
+                  << " | velocidad media " << s.avgSpeed << ", coherencia " << s.coherence
+                  << ", centro (" << s.centerX << ", " << s.centerY << ")\n";
+    }
+    MPI_Finalize();
+    return 0;
+}
+
+int runDistributedBench(const DistributedConfig& cfg, int& argc, char**& argv) {
+    MPI_Init(&argc, &argv);
+    int rank = 0, ranks = 1;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+    if (cfg.threads > 0) omp_set_num_threads(cfg.threads);
+    if (!checkStrip(cfg, rank)) {
+        MPI_Finalize();
+        return 1;
+    }
+
+    std::vector<int> rankCounts;
+    for (int r = 1; r < ranks; r *= 2) rankCounts.push_back(r);
+    rankCounts.push_back(ranks);
+
+    std::ofstream csv;
+    if (rank == 0 && !cfg.csvPath.empty()) csv.open(cfg.csvPath);
+    std::ostream& out = cfg.csvPath.empty() ? std::cout : csv;
+    if (rank == 0) {
+        out << "ranks,boids,width,height,frames,seed,trial_idx,usec,halo_us,step_us,migrate_us\n";
+        std::cerr << "[bench] escalado débil MPI: ranks=";
+        for (size_t k = 0; k < rankCounts.size(); ++k) std::cerr << (k ? "," : "") << rankCounts[k];
+        std::cerr << ", " << cfg.boidsPerRank << " boids y " << cfg.width << "x" << cfg.height
+                  << " por rank, motor " << cfg.engine << ", frames=" << cfg.frames << ", trials=" << cfg.trials << "\n";
+    }
+
+    std::vector<double> means;
+    for (int r : rankCounts) {
+        MPI_Comm sub;
+        MPI_Comm_split(MPI_COMM_WORLD, rank < r ? 0 : MPI_UNDEFINED, rank, &sub);
+        double sum = 0;
+        if (sub != MPI_COMM_NULL) {
+            for (int t = -cfg.warmup; t < cfg.trials; ++t) {
+                DistributedConfig trial = cfg;
+                trial.seed = cfg.seed + (unsigned)std::max(t, 0);
+                StripFlock flock(sub, trial);
+                StripCounters c;
+                MPI_Barrier(sub);
+                const double start = MPI_Wtime();
+                for (int f = 0; f < cfg.frames; ++f) flock.step(c);
+                const double us = reduceMax(MPI_Wtime() - start, sub) * 1e6;
+                const double halo = reduceMax(c.haloS, sub) * 1e6;
+                const double step = reduceMax(c.stepS, sub) * 1e6;
+                const double migrate = reduceMax(c.migrateS, sub) * 1e6;
+                if (t < 0 || rank != 0) continue;   // warmup: discarded
+                sum += us;
+                out << r << "," << (long long)cfg.boidsPerRank * r << "," << cfg.width * r << "," << cfg.height
+                    << "," << cfg.frames << "," << trial.seed << "," << (t + 1) << "," << (long long)us << ","
+                    << (long long)halo << "," << (long long)step << "," << (long long)migrate << "\n";
+            }
+            MPI_Comm_free(&sub);
+        }
+        if (rank == 0) {
+            means.push_back(sum / std::max(cfg.trials, 1));
+            std::cerr << "[bench] ranks=" << r << " mean_us=" << (long long)means.back() << "\n";
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+
+    // Weak scaling: ideal is a flat time as ranks and world grow together
+    if (rank == 0) {
+        out << "# weak scaling (boids/rank=" << cfg.boidsPerRank << ", strip " << cfg.width << "x" << cfg.height
+            << ", base ranks=1)\n";
+        for (size_t k = 0; k < rankCounts.size(); ++k)
+            out << "# ranks=" << rankCounts[k] << " boids=" << (long long)cfg.boidsPerRank * rankCounts[k]
+                << " mean_us=" << (long long)means[k]
+                << " efficiency=" << (means[k] > 0 ? means[0] / means[k] : 0.0) << "\n";
+        if (!cfg.csvPath.empty()) std::cerr << "[bench] Resultados escritos en: " << cfg.csvPath << "\n";
+    }
+    MPI_Finalize();
+    return 0;
+}
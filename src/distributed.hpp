@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include "engine.hpp"
+#include "kernels.hpp"
+
+// Multi-node flock (MPI): the world is split into vertical strips, one per rank,
+// each --width pixels wide, so a wall of N screens runs on N ranks. A rank owns
+// the boids inside its strip, steps them with a regular engine together with
+// the ghost boids within the largest interaction radius of its neighbors, and
+// hands boids that cross a strip border (or wrap around the world, which makes
+// the strips a ring) to the neighbor that now owns them.
+struct DistributedConfig {
+    int width = 1280, height = 720;   // strip of one rank (world = ranks * width x height)
+    int boidsPerRank = 150;
+    int predatorsPerRank = 0;
+    int frames = 600;
+    int trials = 10, warmup = 1;      // --bench only
+    int threads = 0;                  // OpenMP threads per rank (0 = runtime default)
+    unsigned seed = 12345;
+    std::string engine = "grid";
+    SimdLevel simd = SimdLevel::Scalar;
+    FlockParams flock;
+    std::string csvPath;              // --bench CSV (empty = stdout)
+};
+
+// Steps cfg.frames frames on every rank of MPI_COMM_WORLD and prints a summary on rank 0.
+// Initializes and finalizes MPI itself; returns the process exit code.
+int runDistributed(const DistributedConfig& cfg, int& argc, char**& argv);
+
+// Weak scaling: the world grows with the ranks (1, 2, 4, ..., all), boids per rank fixed.
+// Each point runs on the first ranks of MPI_COMM_WORLD while the rest wait.
+int runDistributedBench(const DistributedConfig& cfg, int& argc, char**& argv);
@@ -0,0 +1,128 @@
+#include "engine.hpp"
+#include <cstring>
+#include <omp.h>
+
+// Built-in engines, defined in engine_*.cpp
+std::unique_ptr<FlockEngine> makeSerialEngine();
+std::unique_ptr<FlockEngine> makeParallelEngine();
+std::unique_ptr<FlockEngine> makeGridEngine();
+std::unique_ptr<FlockEngine> makeTiledEngine();
+std::unique_ptr<FlockEngine> makeQuadtreeEngine();
+#ifdef FLOCK_HAVE_OPENCL
+std::unique_ptr<FlockEngine> makeOpenCLEngine();
+#endif
+
+static std::vector<EngineInfo>& registry() {
+    static std::vector<EngineInfo> engines = {
+        {"serial",   "Reference Bird methods, one thread",           makeSerialEngine},
+        {"parallel", "OpenMP brute force over the SoA buffers",      makeParallelEngine},
+        {"grid",     "OpenMP with uniform-grid neighbor search",     makeGridEngine},
+        {"tiled",    "Cache-tiled brute force, each pair once",      makeTiledEngine},
+        {"quadtree", "Barnes-Hut quadtree, far alignment/cohesion from node aggregates (--theta)", makeQuadtreeEngine},
+#ifdef FLOCK_HAVE_OPENCL
+        {"gpu",      "OpenCL kernels, boids resident on the GPU (grid engine without a device)", makeOpenCLEngine},
+#endif
+    };
+    return engines;
+}
+
+const std::vector<EngineInfo>& engineRegistry() {
+    return registry();
+}
+
+bool registerEngine(const EngineInfo& info) {
+    auto& engines = registry();
+    for (const auto& e : engines)
+        if (std::strcmp(e.name, info.name) == 0) return false;
+    engines.push_back(info);
+    return true;
+}
+
+std::unique_ptr<FlockEngine> createEngine(const std::string& name) {
+    for (const auto& e : registry())
+        if (name == e.name) return e.create();
+    return nullptr;
+}
+
+std::string engineNames() {
+    std::string names;
+    for (const auto& e : registry()) {
+        if (!names.empty()) names += ",";
+        names += e.name;
+    }
+    return names;
+}
+
+const char* scheduleName(LoopSchedule s) {
+    switch (s) {
+        case LoopSchedule::Static:  return "static";
+        case LoopSchedule::Dynamic: return "dynamic";
+        case LoopSchedule::Guided:  return "guided";
+        case LoopSchedule::Steal:   return "steal";
+    }
+    return "?";
+}
+
+bool parseSchedule(const char* name, LoopSchedule& out) {
+    if (std::strcmp(name, "static") == 0)  { out = LoopSchedule::Static;  return true; }
+    if (std::strcmp(name, "dynamic") == 0) { out = LoopSchedule::Dynamic; return true; }
+    if (std::strcmp(name, "guided") == 0)  { out = LoopSchedule::Guided;  return true; }
+    if (std::strcmp(name, "steal") == 0)   { out = LoopSchedule::Steal;   return true; }
+    return false;
+}
+
+void applySchedule(LoopSchedule s, int chunk) {
+    omp_sched_t kind = omp_sched_static;
+    if (s == LoopSchedule::Dynamic || s == LoopSchedule::Steal) kind = omp_sched_dynamic;
+    if (s == LoopSchedule::Guided)  kind = omp_sched_guided;
+    omp_set_schedule(kind, chunk);
+}
+
+// Combines the neighbor sums and the environmental bias into the acceleration of one boid
+void steerBoid(const NeighborSums& s, float pix, float piy, float vix, float viy,
+               const BoidParams& b, const StepParams& p, float& outX, float& outY) {
+    // Combine into a local "acc" using fast limit version
+
+    // (d) Otra optimización algorítmica documentable:
+    //     `fastLimit`: limita por norma sin normalizaciones intermedias ni cálculos extra.
+    //     Razón: evita trabajo cuando el vector ya está bajo el umbral y usa una sola sqrt
+    //            en el caso de reescalado, reduciendo costo en la ruta crítica.
+
+    const FlockParams& f = b.flock;
+    const float maxSpeed = b.maxSpeed;
+    const float maxForce = b.maxForce;
+    float acc_x = 0.f, acc_y = 0.f;
+    float fx, fy;
+
+    // Separation (disabled rules leave their sums at zero, see NeighborKernelSet)
+    if (s.sep_c > 0 &&
+        steerToward(s.sep_x / s.sep_c, s.sep_y / s.sep_c, vix, viy, maxSpeed, maxForce, fx, fy)) {
+        acc_x += f.separationWeight * fx;
+        acc_y += f.separationWeight * fy;
+    }
+
+    // Alignment
+    if (s.ali_c > 0 &&
+        steerToward(s.ali_x / s.ali_c, s.ali_y / s.ali_c, vix, viy, maxSpeed, maxForce, fx, fy)) {
+        acc_x += f.alignmentWeight * fx;
+        acc_y += f.alignmentWeight * fy;
+    }
+
+    // Cohesion
+    if (s.coh_c > 0 &&
+        steerToward(s.coh_x / s.coh_c - pix, s.coh_y / s.coh_c - piy, vix, viy, maxSpeed, maxForce, fx, fy)) {
+        acc_x += f.cohesionWeight * fx;
+        acc_y += f.cohesionWeight * fy;
+    }
+
+    // Environmental bias
+    if ((f.rules & RULE_BIAS) &&
+        biasSteer(f, piy, (float)p.height, vix, viy, maxSpeed, maxForce, fx, fy)) {
+        acc_x += f.biasWeight * fx;
+        acc_y += f.biasWeight * fy;
+    }
+
+    outX = acc_x;
+    outY = acc_y;
+}
+
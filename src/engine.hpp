@@ -0,0 +1,373 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "aligned.hpp"
+#include "kernels.hpp"
+
+// ===========================
+//  SIMULATION STATE
+// ==========================
+
+// Rules beyond the neighbor ones of NeighborRule
+constexpr unsigned RULE_BIAS = 8u;
+
+// Force weights and shape of the environmental bias, tunable at runtime (--weights, --rules, ImGui).
+// A disabled rule (or a zero weight) is dropped from the neighbor pass at compile time (NeighborKernelSet).
+struct FlockParams {
+    unsigned rules = RULE_ALL | RULE_BIAS;  // enabled rules
+    float separationWeight = 1.5f;  // Avoid collisions (highest priority)
+    float alignmentWeight = 1.0f;   // Match neighbors
+    float cohesionWeight = 1.0f;    // Stay together
+    float biasWeight = 0.8f;        // Environmental preference
+
+    // Environmental bias: rightward drift (like migrating birds) and a preferred flight corridor
+    float driftX = 0.5f;            // rightward component
+    float climbBand = 0.3f;         // below this fraction of the height, climb back up
+    float climb = 0.8f;             // upward component at the bottom (stronger the lower you are)
+    float sink = 0.15f;             // downward component above the band (prevents clustering at the top)
+    float corridorY = 0.2f;         // preferred height, as a fraction of the height
+    float biasSpeed = 0.3f;         // bias speed on the corridor, as a fraction of maxSpeed
+    float corridorGain = 0.5f;      // extra speed fraction per half height away from the corridor
+    float biasForce = 0.5f;         // force limit as a fraction of maxForce (gentler than other forces)
+
+    // Enabled rules with a non-zero weight
+    unsigned activeRules() const {
+        unsigned r = rules;
+        if (separationWeight == 0.f) r &= ~(unsigned)RULE_SEPARATION;
+        if (alignmentWeight == 0.f)  r &= ~(unsigned)RULE_ALIGNMENT;
+        if (cohesionWeight == 0.f)   r &= ~(unsigned)RULE_COHESION;
+        if (biasWeight == 0.f)       r &= ~RULE_BIAS;
+        return r;
+    }
+};
+
+// Physical and flocking parameters, identical for every boid of a species
+struct BoidParams {
+    float r = 4.0f;                 // Size
+    float maxSpeed = 2.0f;          // Maximum speed
+    float maxForce = 0.03f;         // Maximum steering force
+    float separationRadius = 25.0f;
+    float alignmentRadius = 50.0f;
+    float cohesionRadius = 50.0f;
+
+    // Interaction with other species (0 = none)
+    float avoidRadius = 0.f;        // other species separate from this one within it
+    float chaseRadius = 0.f;        // this species steers to other species' centroid within it
+
+    FlockParams flock;
+};
+
+// Structure-of-arrays boid kinematics (aligned, contiguous per component).
+// resize() does not zero new boids: every slot is written before it is read, and
+// the first write (the parallel spawn or step loop) decides the NUMA node of its page.
+struct BoidState {
+    FirstTouchVector<float> px, py, vx, vy;
+
+    size_t size() const { return px.size(); }
+
+    void resize(size_t n) {
+        px.resize(n); py.resize(n); vx.resize(n); vy.resize(n);
+    }
+
+    void push(float x, float y, float velX, float velY) {
+        px.push_back(x); py.push_back(y); vx.push_back(velX); vy.push_back(velY);
+    }
+};
+
+// Squared interaction radii; disabled rules get radius 0
+inline NeighborRadii squaredRadii(const BoidParams& b) {
+    const unsigned rules = b.flock.activeRules();
+    return { (rules & RULE_SEPARATION) ? b.separationRadius * b.separationRadius : 0.f,
+             (rules & RULE_ALIGNMENT)  ? b.alignmentRadius  * b.alignmentRadius  : 0.f,
+             (rules & RULE_COHESION)   ? b.cohesionRadius   * b.cohesionRadius   : 0.f };
+}
+
+// Kernel variant (NeighborRule mask) that covers the non-zero radii
+inline unsigned radiiRules(const NeighborRadii& r) {
+    return (r.sep2 > 0.f ? RULE_SEPARATION : 0u) | (r.ali2 > 0.f ? RULE_ALIGNMENT : 0u) |
+           (r.coh2 > 0.f ? RULE_COHESION : 0u);
+}
+
+// Boids are bucketed by species: species s owns [start[s], start[s + 1]) of the
+// arrays, so each species-pair neighbor pass runs with constant parameters.
+// Within a species the neighbor rules are the usual ones; across species a boid
+// only separates (within the larger of its separationRadius and the other's
+// avoidRadius) and chases (its own chaseRadius).
+struct SpeciesTable {
+    std::vector<BoidParams> params;        // per species
+    std::vector<NeighborRadii> pairRadii;  // [a * count() + b]: radii species a applies to neighbors of species b
+    std::vector<unsigned> pairRules;       // [a * count() + b]: radiiRules of pairRadii (0 = no interaction)
+    std::vector<size_t> start{0, 0};       // count() + 1 offsets
+
+    SpeciesTable() : params(1) { updateRadii(); }
+
+    int count() const { return (int)params.size(); }
+    size_t begin(int s) const { return start[s]; }
+    size_t end(int s) const { return start[s + 1]; }
+
+    const NeighborRadii& radii(int a, int b) const { return pairRadii[a * count() + b]; }
+    unsigned rules(int a, int b) const { return pairRules[a * count() + b]; }
+
+    // Species of boid i (linear scan: a handful of species)
+    int of(size_t i) const {
+        int s = 0;
+        while (i >= start[s + 1]) ++s;
+        return s;
+    }
+
+    // Recomputes pairRadii after params changed
+    void updateRadii() {
+        const int n = count();
+        pairRadii.resize(n * n);
+        pairRules.resize(n * n);
+        for (int a = 0; a < n; ++a) {
+            const unsigned active = params[a].flock.activeRules();
+            for (int b = 0; b < n; ++b) {
+                NeighborRadii& r = pairRadii[a * n + b];
+                if (a == b) {
+                    r = squaredRadii(params[a]);
+                } else {
+                    const float sep = std::max(params[a].separationRadius, params[b].avoidRadius);
+                    r = { (active & RULE_SEPARATION) ? sep * sep : 0.f, 0.f,
+                          (active & RULE_COHESION) ? params[a].chaseRadius * params[a].chaseRadius : 0.f };
+                }
+                pairRules[a * n + b] = radiiRules(r);
+            }
+        }
+    }
+
+    // Largest radius of any pair (grid cell size)
+    float maxRadius() const {
+        float r2 = 0.f;
+        for (const NeighborRadii& r : pairRadii) r2 = std::max({r2, r.sep2, r.ali2, r.coh2});
+        return std::sqrt(r2);
+    }
+};
+
+// Flock statistics produced by the step itself (see StatsAccum)
+struct FlockStats {
+    size_t count = 0;
+    float avgSpeed = 0.f, maxSpeed = 0.f;
+    float coherence = 0.f;          // mean distance to the centroid
+    float meanNeighbors = -1.f;     // within the cohesion radius (< 0 = engine does not count)
+    float centerX = 0.f, centerY = 0.f;
+    float minX = 0.f, minY = 0.f, maxX = 0.f, maxY = 0.f; // bounding box
+};
+
+// Partial sums for FlockStats, merged as an OpenMP reduction in the integration pass.
+// Distances are measured to the previous step's centroid, so one pass is enough
+// (boids move at most maxSpeed per step).
+struct StatsAccum {
+    double sumSpeed = 0.0, sumDist = 0.0, sumNeighbors = 0.0, sumX = 0.0, sumY = 0.0;
+    float maxSpeed = 0.f;
+    float minX = std::numeric_limits<float>::max(), minY = std::numeric_limits<float>::max();
+    float maxX = std::numeric_limits<float>::lowest(), maxY = std::numeric_limits<float>::lowest();
+    size_t count = 0;
+
+    void add(float x, float y, float vx, float vy, int neighbors, float cx, float cy) {
+        const float speed = std::sqrt(vx*vx + vy*vy);
+        const float dx = x - cx, dy = y - cy;
+        sumSpeed += speed;
+        sumDist += std::sqrt(dx*dx + dy*dy);
+        sumNeighbors += neighbors;
+        sumX += x; sumY += y;
+        maxSpeed = std::max(maxSpeed, speed);
+        minX = std::min(minX, x); minY = std::min(minY, y);
+        maxX = std::max(maxX, x); maxY = std::max(maxY, y);
+        ++count;
+    }
+
+    void merge(const StatsAccum& o) {
+        sumSpeed += o.sumSpeed; sumDist += o.sumDist; sumNeighbors += o.sumNeighbors;
+        sumX += o.sumX; sumY += o.sumY;
+        maxSpeed = std::max(maxSpeed, o.maxSpeed);
+        minX = std::min(minX, o.minX); minY = std::min(minY, o.minY);
+        maxX = std::max(maxX, o.maxX); maxY = std::max(maxY, o.maxY);
+        count += o.count;
+    }
+
+    FlockStats finish(bool countsNeighbors) const {
+        FlockStats s;
+        s.count = count;
+        if (count == 0) return s;
+        s.avgSpeed = (float)(sumSpeed / count);
+        s.maxSpeed = maxSpeed;
+        s.coherence = (float)(sumDist / count);
+        s.meanNeighbors = countsNeighbors ? (float)(sumNeighbors / count) : -1.f;
+        s.centerX = (float)(sumX / count);
+        s.centerY = (float)(sumY / count);
+        s.minX = minX; s.minY = minY; s.maxX = maxX; s.maxY = maxY;
+        return s;
+    }
+};
+
+#pragma omp declare reduction(stats : StatsAccum : omp_out.merge(omp_in)) initializer(omp_priv = StatsAccum())
+
+// Double-buffered flock: a step reads 'cur', writes 'next' and swaps them
+struct FlockState {
+    BoidState cur, next;
+    FlockStats stats;   // of 'cur', written by the step that produced it
+    uint64_t edits = 0; // bumped on every change made outside a step (engines with a device copy re-upload)
+
+    size_t size() const { return cur.size(); }
+
+    // Makes 'next' as large as 'cur' (no-op once both buffers match)
+    void prepareNext() { next.resize(cur.size()); }
+    void swap() { std::swap(cur, next); }
+};
+
+// OpenMP schedule of the per-boid loops (they use schedule(runtime)). Steal is
+// load-aware: the grid engine splits its cells into ranges weighted by
+// occupancy^2 and balances them with WorkStealing; other loops run it as dynamic.
+enum class LoopSchedule { Static, Dynamic, Guided, Steal };
+
+const char* scheduleName(LoopSchedule s);
+bool parseSchedule(const char* name, LoopSchedule& out);
+
+// Sets the run-sched-var of the calling thread; chunk 0 = OpenMP default
+void applySchedule(LoopSchedule s, int chunk);
+
+// Everything a step needs besides the boids themselves
+struct StepParams {
+    const SpeciesTable* species = nullptr;           // parameters and bucket offsets (never null in a step)
+    int width = 0, height = 0;                       // world (window) size
+    NeighborKernelSet kernels = neighborsScalarSet;  // runtime-dispatched neighbor kernels, per rule mask
+    float cellSize = 0.f;                            // grid cell side (0 = largest radius)
+    LoopSchedule schedule = LoopSchedule::Static;    // as applied to the runtime schedule
+    float theta = 0.5f;                              // quadtree opening angle (0 = exact)
+};
+
+// ===========================
+//  ENGINES
+// ==========================
+
+// A way of advancing the flock by one step. Engines may keep scratch buffers
+// between calls (grids, per-thread accumulators) but never own the boids.
+// A step ends with state.swap(), so 'next' holds the previous state (used to
+// interpolate rendering between steps).
+class FlockEngine {
+public:
+    virtual ~FlockEngine() = default;
+    virtual const char* name() const = 0;
+    // False for engines with their own pair loop, which ignore StepParams::kernels
+    virtual bool usesKernel() const { return true; }
+    // True for engines that keep their own copy of the boids (device buffers): reordering
+    // the arrays gains them nothing and forces a re-upload
+    virtual bool keepsDeviceCopy() const { return false; }
+    // Pre-allocates per-boid scratch for up to n boids, so growing the flock does not reallocate
+    virtual void reserve(size_t /*n*/) {}
+    virtual void step(FlockState& state, const StepParams& params) = 0;
+};
+
+using EngineFactory = std::unique_ptr<FlockEngine> (*)();
+
+struct EngineInfo {
+    const char* name;
+    const char* description;
+    EngineFactory create;
+};
+
+// Registered engines, built-in ones first in a stable order
+const std::vector<EngineInfo>& engineRegistry();
+
+// Adds an engine to the registry (e.g. an optional GPU backend); false if the name is taken
+bool registerEngine(const EngineInfo& info);
+
+// New instance of a registered engine, or nullptr for an unknown name
+std::unique_ptr<FlockEngine> createEngine(const std::string& name);
+
+// Comma separated list of registered names, for help and error messages
+std::string engineNames();
+
+// ===========================
+//  SHARED STEP MATH
+// ==========================
+
+// Limits (x, y) to maxMag with a single sqrt, only when needed
+inline void fastLimit(float& x, float& y, float maxMag) {
+    const float s2 = x*x + y*y;
+    const float m2 = maxMag * maxMag;
+    if (s2 > m2 && s2 > 0.f) {
+        const float inv = maxMag / std::sqrt(s2);
+        x *= inv; y *= inv;
+    }
+}
+
+// Reynolds steering toward direction (dx, dy): normalize(d) * speed - v, limited to maxForce.
+// Leaves (outX, outY) untouched and returns false when d is zero.
+inline bool steerToward(float dx, float dy, float vx, float vy, float speed, float maxForce,
+                        float& outX, float& outY) {
+    const float s2 = dx*dx + dy*dy;
+    if (!(s2 > 0.f)) return false;
+    const float inv = 1.0f / std::sqrt(s2);
+    dx *= inv; dy *= inv;
+    dx *= speed; dy *= speed;
+    dx -= vx; dy -= vy;
+    fastLimit(dx, dy, maxForce);
+    outX = dx; outY = dy;
+    return true;
+}
+
+// Environmental bias of a boid at height y moving at (vx, vy)
+inline bool biasSteer(const FlockParams& f, float y, float height, float vx, float vy,
+                      float maxSpeed, float maxForce, float& outX, float& outY) {
+    const float bx = f.driftX;
+    float by;
+    const float upperHalf = height * f.climbBand;
+    if (y > upperHalf) {
+        // If in lower half, add upward bias
+        const float distanceFromTop = (y - upperHalf) / upperHalf;
+        by = -distanceFromTop * f.climb;
+    } else {
+        by = f.sink;
+    }
+    // Stronger when far from the ideal corridor
+    const float idealY = height * f.corridorY;
+    const float distanceFromIdeal = std::abs(y - idealY) / (height * 0.5f);
+    const float speed = maxSpeed * (f.biasSpeed + distanceFromIdeal * f.corridorGain);
+    return steerToward(bx, by, vx, vy, speed, maxForce * f.biasForce, outX, outY);
+}
+
+// Combines the neighbor sums and the environmental bias into the acceleration of one boid of species params b.
+// Shared by every engine (Bird::flock computes its forces with the same helpers).
+
+void steerBoid(const NeighborSums& s, float pix, float piy, float vix, float viy,
+               const BoidParams& b, const StepParams& p, float& outX, float& outY);
+
+// Centroid the next step measures coherence against (window center before the first step)
+inline void statsCenter(const FlockState& state, const StepParams& p, float& cx, float& cy) {
+    if (state.stats.count > 0) { cx = state.stats.centerX; cy = state.stats.centerY; }
+    else { cx = p.width * 0.5f; cy = p.height * 0.5f; }
+}
+
+// Bird::update + Bird::borders for boid i: reads state.cur, writes state.next
+// and adds the new state of the boid to 'acc'
+inline void integrateBoid(FlockState& state, size_t i, float ax, float ay, const BoidParams& b,
+                          const StepParams& p, StatsAccum& acc, int neighbors, float cx, float cy) {
+    float x = state.cur.px[i], y = state.cur.py[i];
+    float vx = state.cur.vx[i] + ax, vy = state.cur.vy[i] + ay;
+
+    const float maxSpeed = b.maxSpeed;
+    const float v2 = vx*vx + vy*vy;
+    if (v2 > maxSpeed * maxSpeed) {
+        const float inv = maxSpeed / std::sqrt(v2);
+        vx *= inv; vy *= inv;
+    }
+    x += vx; y += vy;
+
+    const float r = b.r;
+    if (x < -r) x = p.width + r;
+    if (y < -r) y = p.height + r;
+    if (x > p.width + r) x = -r;
+    if (y > p.height + r) y = -r;
+
+    state.next.px[i] = x; state.next.py[i] = y;
+    state.next.vx[i] = vx; state.next.vy[i] = vy;
+    acc.add(x, y, vx, vy, neighbors, cx, cy);
+}
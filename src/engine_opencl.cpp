@@ -0,0 +1,496 @@
+#include "engine.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#define CL_TARGET_OPENCL_VERSION 120
+#ifdef __APPLE__
+#include <OpenCL/opencl.h>
+#else
+#include <CL/cl.h>
+#endif
+
+std::unique_ptr<FlockEngine> makeGridEngine();
+
+// Device side of the step: the same grid binning as NeighborGrid (histogram,
+// scan, scatter) and the same neighbor sums / steerBoid / integrateBoid math,
+// one work-item per boid. Scatter order inside a cell depends on the atomics,
+// so the float sums are not bit-identical between runs (or to the CPU engines).
+static const char* kernelSource = R"CL(
+typedef struct {
+    float r, maxSpeed, maxForce; uint rules;
+    float sepW, aliW, cohW, biasW;
+    float driftX, climbBand, climb, sink, corridorY, biasSpeed, corridorGain, biasForce;
+    int reach; int pad0, pad1, pad2;
+} Species;
+
+typedef struct { float sep2, ali2, coh2; int reach; } Pair;
+
+int cellX(float x, float invCell, int cols) { return clamp((int)floor(x * invCell), 0, cols - 1); }
+int cellY(float y, float invCell, int rows) { return clamp((int)floor(y * invCell), 0, rows - 1); }
+
+__kernel void bin(__global const float* px, __global const float* py, uint n,
+                  float invCell, int cols, int rows,
+                  __global int* cellOf, __global uint* counts) {
+    const uint i = get_global_id(0);
+    if (i >= n) return;
+    const int c = cellY(py[i], invCell, rows) * cols + cellX(px[i], invCell, cols);
+    cellOf[i] = c;
+    atomic_inc(&counts[c]);
+}
+
+// Exclusive prefix sum in one work-item: there are only window / cell size cells.
+// launch() rounds up to a whole work-group, so every other item leaves at once.
+__kernel void scan(__global const uint* counts, __global uint* cellStart, __global uint* cursor, int cells) {
+    if (get_global_id(0) != 0) return;
+    uint sum = 0;
+    for (int c = 0; c < cells; ++c) {
+        cellStart[c] = sum;
+        cursor[c] = sum;
+        sum += counts[c];
+    }
+    cellStart[cells] = sum;
+}
+
+__kernel void scatter(__global const float* px, __global const float* py,
+                      __global const float* vx, __global const float* vy,
+                      __global const int* cellOf, __global uint* cursor,
+                      __constant uint* start, int numSpecies, uint n,
+                      __global float* spx, __global float* spy, __global float* svx, __global float* svy,
+                      __global int* sspecies, __global uint* order) {
+    const uint i = get_global_id(0);
+    if (i >= n) return;
+    int s = 0;
+    while (s + 1 < numSpecies && i >= start[s + 1]) ++s;
+    const uint k = atomic_inc(&cursor[cellOf[i]]);
+    spx[k] = px[i]; spy[k] = py[i];
+    svx[k] = vx[i]; svy[k] = vy[i];
+    sspecies[k] = s;
+    order[k] = i;
+}
+
+void fastLimit(float* x, float* y, float maxMag) {
+    const float s2 = *x * *x + *y * *y;
+    if (s2 > maxMag * maxMag && s2 > 0.f) {
+        const float inv = maxMag / sqrt(s2);
+        *x *= inv; *y *= inv;
+    }
+}
+
+bool steerToward(float dx, float dy, float vx, float vy, float speed, float maxForce, float* ox, float* oy) {
+    const float s2 = dx*dx + dy*dy;
+    if (!(s2 > 0.f)) return false;
+    const float inv = 1.0f / sqrt(s2);
+    dx = dx * inv * speed - vx;
+    dy = dy * inv * speed - vy;
+    fastLimit(&dx, &dy, maxForce);
+    *ox = dx; *oy = dy;
+    return true;
+}
+
+// Neighbors of the 'reach' block of cells, steering and integration of one boid (cell order)
+__kernel void step(__global const float* spx, __global const float* spy,
+                   __global const float* svx, __global const float* svy,
+                   __global const int* sspecies, __global const uint* order,
+                   __global const uint* cellStart, float invCell, int cols, int rows,
+                   __constant Species* species, __constant Pair* pairs, int numSpecies,
+                   uint n, float width, float height,
+                   __global float* npx, __global float* npy, __global float* nvx, __global float* nvy) {
+    const uint k = get_global_id(0);
+    if (k >= n) return;
+    const float pix = spx[k], piy = spy[k], vix = svx[k], viy = svy[k];
+    const int a = sspecies[k];
+    const Species b = species[a];
+
+    float sep_x = 0.f, sep_y = 0.f; int sep_c = 0;
+    float ali_x = 0.f, ali_y = 0.f; int ali_c = 0;
+    float coh_x = 0.f, coh_y = 0.f; int coh_c = 0;
+
+    if (b.reach > 0) {
+        const int cx = cellX(pix, invCell, cols), cy = cellY(piy, invCell, rows);
+        const int x0 = max(cx - b.reach, 0), x1 = min(cx + b.reach, cols - 1);
+        const int y0 = max(cy - b.reach, 0), y1 = min(cy + b.reach, rows - 1);
+        for (int row = y0; row <= y1; ++row) {
+            // A row of cells is contiguous in cell order
+            const uint end = cellStart[row * cols + x1 + 1];
+            for (uint j = cellStart[row * cols + x0]; j < end; ++j) {
+                const Pair q = pairs[a * numSpecies + sspecies[j]];
+                const float dx = pix - spx[j];
+                const float dy = piy - spy[j];
+                const float d2 = dx*dx + dy*dy;
+                if (!(d2 > 0.f)) continue;
+                if (d2 < q.sep2) {
+                    const float invd = 1.0f / sqrt(d2);
+                    sep_x += dx * invd * invd;
+                    sep_y += dy * invd * invd;
+                    sep_c++;
+                }
+                if (d2 < q.ali2) { ali_x += svx[j]; ali_y += svy[j]; ali_c++; }
+                if (d2 < q.coh2) { coh_x += spx[j]; coh_y += spy[j]; coh_c++; }
+            }
+        }
+    }
+
+    float ax = 0.f, ay = 0.f, fx, fy;
+    if (sep_c > 0 && steerToward(sep_x / sep_c, sep_y / sep_c, vix, viy, b.maxSpeed, b.maxForce, &fx, &fy)) {
+        ax += b.sepW * fx; ay += b.sepW * fy;
+    }
+    if (ali_c > 0 && steerToward(ali_x / ali_c, ali_y / ali_c, vix, viy, b.maxSpeed, b.maxForce, &fx, &fy)) {
+        ax += b.aliW * fx; ay += b.aliW * fy;
+    }
+    if (coh_c > 0 && steerToward(coh_x / coh_c - pix, coh_y / coh_c - piy, vix, viy, b.maxSpeed, b.maxForce, &fx, &fy)) {
+        ax += b.cohW * fx; ay += b.cohW * fy;
+    }
+    if (b.rules & 8u) {
+        const float upperHalf = height * b.climbBand;
+        const float by = piy > upperHalf ? -((piy - upperHalf) / upperHalf) * b.climb : b.sink;
+        const float distanceFromIdeal = fabs(piy - height * b.corridorY) / (height * 0.5f);
+        const float speed = b.maxSpeed * (b.biasSpeed + distanceFromIdeal * b.corridorGain);
+        if (steerToward(b.driftX, by, vix, viy, speed, b.maxForce * b.biasForce, &fx, &fy)) {
+            ax += b.biasW * fx; ay += b.biasW * fy;
+        }
+    }
+
+    float vx = vix + ax, vy = viy + ay;
+    const float v2 = vx*vx + vy*vy;
+    if (v2 > b.maxSpeed * b.maxSpeed) {
+        const float inv = b.maxSpeed / sqrt(v2);
+        vx *= inv; vy *= inv;
+    }
+    float x = pix + vx, y = piy + vy;
+    if (x < -b.r) x = width + b.r;
+    if (y < -b.r) y = height + b.r;
+    if (x > width + b.r) x = -b.r;
+    if (y > height + b.r) y = -b.r;
+
+    const uint i = order[k];
+    npx[i] = x; npy[i] = y;
+    nvx[i] = vx; nvy[i] = vy;
+}
+)CL";
+
+// Host mirrors of the kernel structs (plain 32-bit fields, so the layouts match)
+struct GpuSpecies {
+    float r, maxSpeed, maxForce; uint32_t rules;
+    float sepW, aliW, cohW, biasW;
+    float driftX, climbBand, climb, sink, corridorY, biasSpeed, corridorGain, biasForce;
+    int32_t reach, pad[3];
+};
+struct GpuPair { float sep2, ali2, coh2; int32_t reach; };
+static_assert(sizeof(GpuSpecies) == 80 && sizeof(GpuPair) == 16, "must match the OpenCL structs");
+
+static bool clOk(cl_int err, const char* what) {
+    if (err == CL_SUCCESS) return true;
+    std::cerr << "[Warn] gpu engine: " << what << " failed (OpenCL error " << err << ")\n";
+    return false;
+}
+
+// OpenCL engine: the boids stay on the device between steps (two resident
+// copies, ping-ponged like FlockState) and are only uploaded again after the
+// host edited the flock (FlockState::edits). Without an OpenCL GPU, or after
+// any device error, every step runs on the CPU grid engine instead.
+class OpenCLEngine : public FlockEngine {
+    // Per-boid buffers: resident state [cur, next] and the cell-sorted copy
+    enum { PX, PY, VX, VY, STATE_BUFFERS };
+    enum { SPX, SPY, SVX, SVY, SSPECIES, ORDER, CELL_OF, SORTED_BUFFERS };
+
+    std::unique_ptr<FlockEngine> fallback;
+    cl_context context = nullptr;
+    cl_command_queue queue = nullptr;
+    cl_program program = nullptr;
+    cl_kernel kBin = nullptr, kScan = nullptr, kScatter = nullptr, kStep = nullptr;
+    cl_mem state[2][STATE_BUFFERS] = {};
+    cl_mem sorted[SORTED_BUFFERS] = {};
+    cl_mem counts = nullptr, cellStart = nullptr, cursor = nullptr;
+    cl_mem speciesBuf = nullptr, pairBuf = nullptr, startBuf = nullptr;
+    size_t capacity = 0, reserved = 0;
+    int cellCapacity = 0, speciesCapacity = 0;
+    int cur = 0;                        // index of the resident copy holding FlockState::cur
+
+    // Identifies the host flock the resident copy was uploaded from
+    const FlockState* residentOf = nullptr;
+    uint64_t residentEdits = 0;
+    size_t residentCount = 0;
+
+    std::vector<GpuSpecies> speciesData;
+    std::vector<GpuPair> pairData;
+    std::vector<cl_uint> startData;
+
+public:
+    OpenCLEngine() {
+        if (!init()) {
+            release();
+            fallback = makeGridEngine();
+        }
+    }
+    ~OpenCLEngine() override { release(); }
+
+    const char* name() const override { return "gpu"; }
+    bool usesKernel() const override { return false; }
+    bool keepsDeviceCopy() const override { return !fallback; }
+
+    void reserve(size_t n) override {
+        reserved = n;
+        if (fallback) fallback->reserve(n);
+    }
+
+    void step(FlockState& st, const StepParams& p) override {
+        if (!fallback && !deviceStep(st, p)) {
+            std::cerr << "[Warn] gpu engine: device step failed, continuing on the grid engine\n";
+            release();
+            fallback = makeGridEngine();
+            fallback->reserve(reserved);
+        }
+        if (fallback) fallback->step(st, p);
+    }
+
+private:
+    // Once per run: verify and the engine switcher create several instances
+    static void warnFallback(const char* why) {
+        static bool warned = false;
+        if (!warned) std::cerr << "[Warn] gpu engine: " << why << ", using the grid engine\n";
+        warned = true;
+    }
+
+    bool init() {
+        cl_uint numPlatforms = 0;
+        if (clGetPlatformIDs(0, nullptr, &numPlatforms) != CL_SUCCESS || numPlatforms == 0) {
+            warnFallback("no OpenCL platform");
+            return false;
+        }
+        std::vector<cl_platform_id> platforms(numPlatforms);
+        clGetPlatformIDs(numPlatforms, platforms.data(), nullptr);
+
+        // First GPU of any platform (an OpenCL CPU device would not beat the grid engine)
+        cl_device_id device = nullptr;
+        for (cl_platform_id pl : platforms)
+            if (clGetDeviceIDs(pl, CL_DEVICE_TYPE_GPU, 1, &device, nullptr) == CL_SUCCESS) break;
+        if (!device) {
+            warnFallback("no OpenCL GPU device");
+            return false;
+        }
+        char deviceName[256] = "";
+        clGetDeviceInfo(device, CL_DEVICE_NAME, sizeof(deviceName) - 1, deviceName, nullptr);
+
+        cl_int err;
+        context = clCreateContext(nullptr, 1, &device, nullptr, nullptr, &err);
+        if (!clOk(err, "clCreateContext")) return false;
+        queue = clCreateCommandQueue(context, device, 0, &err);
+        if (!clOk(err, "clCreateCommandQueue")) return false;
+        program = clCreateProgramWithSource(context, 1, &kernelSource, nullptr, &err);
+        if (!clOk(err, "clCreateProgramWithSource")) return false;
+        if (clBuildProgram(program, 1, &device, "", nullptr, nullptr) != CL_SUCCESS) {
+            size_t logSize = 0;
+            clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, 0, nullptr, &logSize);
+            std::string log(logSize, '\0');
+            clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, logSize, &log[0], nullptr);
+            std::cerr << "[Warn] gpu engine: kernel build failed on " << deviceName << ":\n" << log << "\n";
+            return false;
+        }
+        kBin = clCreateKernel(program, "bin", &err);
+        if (!clOk(err, "clCreateKernel(bin)")) return false;
+        kScan = clCreateKernel(program, "scan", &err);
+        if (!clOk(err, "clCreateKernel(scan)")) return false;
+        kScatter = clCreateKernel(program, "scatter", &err);
+        if (!clOk(err, "clCreateKernel(scatter)")) return false;
+        kStep = clCreateKernel(program, "step", &err);
+        if (!clOk(err, "clCreateKernel(step)")) return false;
+
+        std::cerr << "[gpu] Dispositivo OpenCL: " << deviceName << "\n";
+        return true;
+    }
+
+    static void releaseMem(cl_mem& m) {
+        if (m) clReleaseMemObject(m);
+        m = nullptr;
+    }
+
+    void releaseBoidBuffers() {
+        for (auto& copy : state)
+            for (cl_mem& m : copy) releaseMem(m);
+        for (cl_mem& m : sorted) releaseMem(m);
+        capacity = 0;
+        residentOf = nullptr;
+    }
+
+    void release() {
+        releaseBoidBuffers();
+        for (cl_mem* m : {&counts, &cellStart, &cursor, &speciesBuf, &pairBuf, &startBuf}) releaseMem(*m);
+        cellCapacity = speciesCapacity = 0;
+        for (cl_kernel* k : {&kBin, &kScan, &kScatter, &kStep}) {
+            if (*k) clReleaseKernel(*k);
+            *k = nullptr;
+        }
+        if (program) clReleaseProgram(program);
+        if (queue) clReleaseCommandQueue(queue);
+        if (context) clReleaseContext(context);
+        program = nullptr; queue = nullptr; context = nullptr;
+    }
+
+    bool createBuffer(cl_mem& m, size_t bytes, cl_mem_flags flags = CL_MEM_READ_WRITE) {
+        cl_int err;
+        m = clCreateBuffer(context, flags, bytes, nullptr, &err);
+        return clOk(err, "clCreateBuffer");
+    }
+
+    // Grows the device buffers (boids, cells, species) to fit this step
+    bool ensureBuffers(size_t n, int cells, int numSpecies) {
+        if (n > capacity) {
+            releaseBoidBuffers();
+            const size_t cap = std::max(n, reserved);
+            for (auto& copy : state)
+                for (cl_mem& m : copy)
+                    if (!createBuffer(m, cap * sizeof(float))) return false;
+            for (cl_mem& m : sorted)
+                if (!createBuffer(m, cap * sizeof(float))) return false;   // float, int and uint alike
+            capacity = cap;
+        }
+        if (cells > cellCapacity) {
+            for (cl_mem* m : {&counts, &cellStart, &cursor}) releaseMem(*m);
+            if (!createBuffer(counts, cells * sizeof(cl_uint)) ||
+                !createBuffer(cellStart, (cells + 1) * sizeof(cl_uint)) ||
+                !createBuffer(cursor, cells * sizeof(cl_uint))) return false;
+            cellCapacity = cells;
+        }
+        if (numSpecies > speciesCapacity) {
+            for (cl_mem* m : {&speciesBuf, &pairBuf, &startBuf}) releaseMem(*m);
+            if (!createBuffer(speciesBuf, numSpecies * sizeof(GpuSpecies), CL_MEM_READ_ONLY) ||
+                !createBuffer(pairBuf, numSpecies * numSpecies * sizeof(GpuPair), CL_MEM_READ_ONLY) ||
+                !createBuffer(startBuf, (numSpecies + 1) * sizeof(cl_uint), CL_MEM_READ_ONLY)) return false;
+            speciesCapacity = numSpecies;
+        }
+        return true;
+    }
+
+    template <class... Args>
+    static bool setArgs(cl_kernel k, const Args&... args) {
+        cl_uint index = 0;
+        bool ok = true;
+        ((ok = ok && clSetKernelArg(k, index++, sizeof(Args), &args) == CL_SUCCESS), ...);
+        return clOk(ok ? CL_SUCCESS : CL_INVALID_ARG_VALUE, "clSetKernelArg");
+    }
+
+    bool launch(cl_kernel k, size_t items) {
+        const size_t group = 64;
+        const size_t global = (items + group - 1) / group * group;
+        return clOk(clEnqueueNDRangeKernel(queue, k, 1, nullptr, &global, &group, 0, nullptr, nullptr),
+                    "clEnqueueNDRangeKernel");
+    }
+
+    // Species parameters, pair radii and bucket offsets (a few hundred bytes, sent every step)
+    void packSpecies(const SpeciesTable& species, float invCell) {
+        const int ns = species.count();
+        speciesData.assign(ns, GpuSpecies{});
+        pairData.resize(ns * ns);
+        for (int a = 0; a < ns; ++a) {
+            const BoidParams& b = species.params[a];
+            const FlockParams& f = b.flock;
+            GpuSpecies& g = speciesData[a];
+            g = { b.r, b.maxSpeed, b.maxForce, f.rules,
+                  f.separationWeight, f.alignmentWeight, f.cohesionWeight, f.biasWeight,
+                  f.driftX, f.climbBand, f.climb, f.sink, f.corridorY, f.biasSpeed, f.corridorGain, f.biasForce,
+                  0, {0, 0, 0} };
+            for (int t = 0; t < ns; ++t) {
+                const NeighborRadii& r = species.radii(a, t);
+                const float pairRadius = std::sqrt(std::max({r.sep2, r.ali2, r.coh2}));
+                const int reach = species.rules(a, t) != 0 ? std::max(1, (int)std::ceil(pairRadius * invCell)) : 0;
+                pairData[a * ns + t] = { r.sep2, r.ali2, r.coh2, reach };
+                g.reach = std::max(g.reach, reach);
+            }
+        }
+        startData.assign(species.start.begin(), species.start.end());
+    }
+
+    bool deviceStep(FlockState& st, const StepParams& p) {
+        TRACE_SCOPE("gpu.step");
+        const size_t n = st.size();
+        if (n == 0) return true;
+        st.prepareNext();
+
+        const SpeciesTable& species = *p.species;
+        const int numSpecies = species.count();
+        const float cellSize = std::max(p.cellSize > 0.f ? p.cellSize : species.maxRadius(), 1.f);
+        const float invCell = 1.f / cellSize;
+        const cl_int cols = std::max(1, (int)std::ceil(p.width * invCell));
+        const cl_int rows = std::max(1, (int)std::ceil(p.height * invCell));
+        const cl_int cells = cols * rows;
+        if (!ensureBuffers(n, cells, numSpecies)) return false;
+
+        packSpecies(species, invCell);
+        const size_t bytes = n * sizeof(float);
+        bool ok = clOk(clEnqueueWriteBuffer(queue, speciesBuf, CL_FALSE, 0, speciesData.size() * sizeof(GpuSpecies),
+                                            speciesData.data(), 0, nullptr, nullptr), "upload species") &&
+                  clOk(clEnqueueWriteBuffer(queue, pairBuf, CL_FALSE, 0, pairData.size() * sizeof(GpuPair),
+                                            pairData.data(), 0, nullptr, nullptr), "upload pairs") &&
+                  clOk(clEnqueueWriteBuffer(queue, startBuf, CL_FALSE, 0, startData.size() * sizeof(cl_uint),
+                                            startData.data(), 0, nullptr, nullptr), "upload buckets");
+
+        // The boids only cross the bus again when the host changed them since the last step
+        if (ok && (residentOf != &st || residentEdits != st.edits || residentCount != n)) {
+            TRACE_SCOPE("gpu.upload");
+            const float* host[STATE_BUFFERS] = { st.cur.px.data(), st.cur.py.data(), st.cur.vx.data(), st.cur.vy.data() };
+            for (int b = 0; ok && b < STATE_BUFFERS; ++b)
+                ok = clOk(clEnqueueWriteBuffer(queue, state[cur][b], CL_FALSE, 0, bytes, host[b], 0, nullptr, nullptr),
+                          "upload boids");
+        }
+        if (!ok) return false;
+
+        cl_mem* in = state[cur];
+        cl_mem* out = state[cur ^ 1];
+        const cl_uint count = (cl_uint)n;
+        const cl_int ns = numSpecies;
+        const cl_float width = (float)p.width, height = (float)p.height;
+        const cl_uint zero = 0;
+
+        ok = clOk(clEnqueueFillBuffer(queue, counts, &zero, sizeof(zero), 0, cells * sizeof(cl_uint), 0, nullptr, nullptr),
+                  "clear counts") &&
+             setArgs(kBin, in[PX], in[PY], count, invCell, cols, rows, sorted[CELL_OF], counts) &&
+             launch(kBin, n) &&
+             setArgs(kScan, counts, cellStart, cursor, cells) &&
+             launch(kScan, 1) &&
+             setArgs(kScatter, in[PX], in[PY], in[VX], in[VY], sorted[CELL_OF], cursor, startBuf, ns, count,
+                     sorted[SPX], sorted[SPY], sorted[SVX], sorted[SVY], sorted[SSPECIES], sorted[ORDER]) &&
+             launch(kScatter, n) &&
+             setArgs(kStep, sorted[SPX], sorted[SPY], sorted[SVX], sorted[SVY], sorted[SSPECIES], sorted[ORDER],
+                     cellStart, invCell, cols, rows, speciesBuf, pairBuf, ns, count, width, height,
+                     out[PX], out[PY], out[VX], out[VY]) &&
+             launch(kStep, n);
+        if (!ok) return false;
+
+        // The renderer draws from host memory, so the new positions come back once per step
+        {
+            TRACE_SCOPE("gpu.readback");
+            float* host[STATE_BUFFERS] = { st.next.px.data(), st.next.py.data(), st.next.vx.data(), st.next.vy.data() };
+            for (int b = 0; ok && b < STATE_BUFFERS; ++b)
+                ok = clOk(clEnqueueReadBuffer(queue, out[b], CL_FALSE, 0, bytes, host[b], 0, nullptr, nullptr),
+                          "read back boids");
+            ok = ok && clOk(clFinish(queue), "clFinish");
+        }
+        if (!ok) return false;
+        cur ^= 1;
+        residentOf = &st;
+        residentEdits = st.edits;
+        residentCount = n;
+
+        // Statistics on the host copy (neighbor counts stay on the device)
+        StatsAccum acc;
+        float centerX, centerY;
+        statsCenter(st, p, centerX, centerY);
+        const float* px = st.next.px.data();
+        const float* py = st.next.py.data();
+        const float* vx = st.next.vx.data();
+        const float* vy = st.next.vy.data();
+        #pragma omp parallel for schedule(static) reduction(stats : acc)
+        for (size_t i = 0; i < n; ++i) acc.add(px[i], py[i], vx[i], vy[i], 0, centerX, centerY);
+        st.stats = acc.finish(false);
+        st.swap();
+        return true;
+    }
+};
+
+std::unique_ptr<FlockEngine> makeOpenCLEngine() {
+    return std::make_unique<OpenCLEngine>();
+}
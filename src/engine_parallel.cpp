@@ -0,0 +1,239 @@
+#include "engine.hpp"
+#include "grid.hpp"
+#include "steal.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
+
+// Parallel version - each boid processes neighbors
+class ParallelEngine : public FlockEngine {
+public:
+    const char* name() const override { return "parallel"; }
+
+    void step(FlockState& state, const StepParams& p) override {
+        const size_t n = state.size();
+        if (n == 0) return;
+
+        // (b) Optimización de estructuras de datos (SoA):
+        //     El estado vive de forma persistente en arreglos contiguos y alineados px/py/vx/vy
+        //     (Structure of Arrays) con doble buffer. Razón: mejora la localidad de caché y
+        //     facilita la vectorización del loop de vecinos, sin copias ni reservas por frame.
+
+        state.prepareNext();
+
+        const float* px = state.cur.px.data();
+        const float* py = state.cur.py.data();
+        const float* vx = state.cur.vx.data();
+        const float* vy = state.cur.vy.data();
+
+        // (b) Optimización de estructuras de datos:
+        //     Cacheo de radios^2 para comparar d2 < R^2 y evitar sqrt en el test de vecindad.
+        //     Esto reduce operaciones costosas dentro del bucle más caliente.
+
+        const SpeciesTable& species = *p.species;
+        const int numSpecies = species.count();
+        const NeighborKernelSet& kernels = p.kernels;
+
+        // (c) Optimización de acceso a memoria compartida:
+        //     Fuerzas e integración en una sola pasada: cada hilo lee solo 'cur' y escribe
+        //     únicamente el índice i de 'next', evitando *data races* y buffers temporales.
+
+        // Flock statistics are reduced in the same pass (no extra sweep)
+        StatsAccum acc;
+        float centerX, centerY;
+        statsCenter(state, p, centerX, centerY);
+
+        // Calculate forces in parallel with SoA access
+        // (neighbors, steering and integration are fused per boid, so traced as one phase per thread)
+        #pragma omp parallel
+        {
+            TRACE_WORK("parallel.boids");
+            #pragma omp for schedule(runtime) nowait reduction(stats : acc)
+            for (size_t i = 0; i < n; ++i) {
+                // One kernel call per species bucket, each with that pair's constant radii
+                // and the variant compiled for the pair's enabled rules
+                const int a = species.of(i);
+                NeighborSums sums;
+                for (int b = 0; b < numSpecies; ++b) {
+                    const unsigned rules = species.rules(a, b);
+                    if (rules == 0) continue;
+                    kernels.rules[rules](px, py, vx, vy, species.begin(b), species.end(b), px[i], py[i],
+                                         species.radii(a, b), sums);
+                }
+                const BoidParams& bp = species.params[a];
+                float ax, ay;
+                steerBoid(sums, px[i], py[i], vx[i], vy[i], bp, p, ax, ay);
+                integrateBoid(state, i, ax, ay, bp, p, acc, sums.coh_c, centerX, centerY);
+            }
+        }
+
+        state.stats = acc.finish(true);
+        state.swap();
+    }
+};
+
+// Uniform grid: with cells as large as the largest radius, only the 3x3 cells around
+// each boid can hold neighbors (smaller cells widen the block accordingly).
+// Each row of cells is contiguous in the cell-sorted copy, so the inner
+// loop stays the same vectorizable scan as the brute-force path.
+// Every species gets its own grid over its bucket, so a row scan only sees one
+// species and runs with that pair's constant radii.
+class GridEngine : public FlockEngine {
+    std::vector<NeighborGrid> grids; // per species, reused between steps to keep their buffers allocated
+    std::vector<int> reach;          // [a * species + b]: cells around a boid of a to scan in grid b
+    size_t reserved = 0;
+
+    // schedule steal: runs of whole cells in bucket order, [itemBegin[w], itemBegin[w + 1]),
+    // weighted by the sum of occupancy^2 of their cells (about the pairs their boids test)
+    std::vector<size_t> itemBegin;
+    std::vector<float> itemWeight;
+    WorkStealing stealing;
+
+    // Cuts every species' cells into about ITEMS_PER_THREAD items per thread of equal weight,
+    // small enough that a thread stuck with a dense cluster can shed the rest of its run
+    static constexpr int ITEMS_PER_THREAD = 16;
+    void buildWorkItems(const SpeciesTable& species, int threads) {
+        double total = 0.0;
+        for (const NeighborGrid& g : grids)
+            for (size_t c = 0; c + 1 < g.cellStart.size(); ++c) {
+                const double occ = g.cellStart[c + 1] - g.cellStart[c];
+                total += occ * occ;
+            }
+        const double target = std::max(total / ((double)threads * ITEMS_PER_THREAD), 1.0);
+
+        itemBegin.assign(1, 0);
+        itemWeight.clear();
+        for (int s = 0; s < (int)grids.size(); ++s) {
+            const NeighborGrid& g = grids[s];
+            const size_t base = species.begin(s);
+            double w = 0.0;
+            for (size_t c = 0; c + 1 < g.cellStart.size(); ++c) {
+                const double occ = g.cellStart[c + 1] - g.cellStart[c];
+                w += occ * occ;
+                const size_t end = base + g.cellStart[c + 1];
+                if (w >= target && end > itemBegin.back()) {
+                    itemBegin.push_back(end);
+                    itemWeight.push_back((float)w);
+                    w = 0.0;
+                }
+            }
+            const size_t end = species.end(s);
+            if (end > itemBegin.back()) {
+                itemBegin.push_back(end);
+                itemWeight.push_back((float)w);
+            }
+        }
+    }
+
+public:
+    const char* name() const override { return "grid"; }
+    void reserve(size_t n) override {
+        reserved = n;
+        for (auto& g : grids) g.reserve(n);
+    }
+
+    void step(FlockState& state, const StepParams& p) override {
+        const size_t n = state.size();
+        if (n == 0) return;
+        state.prepareNext();
+
+        const SpeciesTable& species = *p.species;
+        const int numSpecies = species.count();
+        const NeighborKernelSet& kernels = p.kernels;
+        const float maxRadius = species.maxRadius();
+        const float cell = p.cellSize > 0.f ? p.cellSize : maxRadius;
+
+        if ((int)grids.size() != numSpecies) {
+            grids.resize(numSpecies);
+            for (auto& g : grids) g.reserve(reserved);
+        }
+        for (int s = 0; s < numSpecies; ++s) {
+            const size_t b = species.begin(s);
+            grids[s].build(state.cur.px.data() + b, state.cur.py.data() + b,
+                           state.cur.vx.data() + b, state.cur.vy.data() + b,
+                           species.end(s) - b, cell, p.width, p.height);
+        }
+
+        // Cells smaller than the pair's largest radius need a wider block than 3x3 (0 = pair does not interact)
+        const NeighborGrid& layout = grids[0];   // every grid has the same cells
+        reach.resize(numSpecies * numSpecies);
+        for (int a = 0; a < numSpecies; ++a) {
+            for (int b = 0; b < numSpecies; ++b) {
+                const NeighborRadii& r = species.radii(a, b);
+                const float pairRadius = std::sqrt(std::max({r.sep2, r.ali2, r.coh2}));
+                reach[a * numSpecies + b] = species.rules(a, b) != 0
+                    ? std::max(1, (int)std::ceil(pairRadius * layout.invCell)) : 0;
+            }
+        }
+
+        StatsAccum acc;
+        float centerX, centerY;
+        statsCenter(state, p, centerX, centerY);
+
+        // k-th boid in bucket order, visited in its species' cell order
+        auto boid = [&](size_t k, StatsAccum& threadAcc) {
+            const int a = species.of(k);
+            const NeighborGrid& own = grids[a];
+            const size_t local = k - species.begin(a);
+            const size_t i = species.begin(a) + own.order[local];
+            const float pix = own.spx[local], piy = own.spy[local];
+            const int c = own.cellOf[own.order[local]];
+            const int cx = c % layout.cols, cy = c / layout.cols;
+
+            NeighborSums sums;
+            for (int b = 0; b < numSpecies; ++b) {
+                const int rb = reach[a * numSpecies + b];
+                if (rb == 0) continue;
+                const NeighborGrid& g = grids[b];
+                const NeighborRadii& radii = species.radii(a, b);
+                const NeighborKernelFn accumulateNeighbors = kernels.rules[species.rules(a, b)];
+                const int x0 = std::max(cx - rb, 0), x1 = std::min(cx + rb, g.cols - 1);
+                const int y0 = std::max(cy - rb, 0), y1 = std::min(cy + rb, g.rows - 1);
+                for (int row = y0; row <= y1; ++row) {
+                    int rowBegin, rowEnd;
+                    g.rowRange(row, x0, x1, rowBegin, rowEnd);
+                    accumulateNeighbors(g.spx.data(), g.spy.data(), g.svx.data(), g.svy.data(),
+                                        rowBegin, rowEnd, pix, piy, radii, sums);
+                }
+            }
+            const BoidParams& bp = species.params[a];
+            float ax, ay;
+            steerBoid(sums, pix, piy, own.svx[local], own.svy[local], bp, p, ax, ay);
+            integrateBoid(state, i, ax, ay, bp, p, threadAcc, sums.coh_c, centerX, centerY);
+        };
+
+        if (p.schedule == LoopSchedule::Steal) {
+            buildWorkItems(species, omp_get_max_threads());
+            #pragma omp parallel reduction(stats : acc)
+            {
+                TRACE_WORK("grid.boids");
+                #pragma omp single
+                stealing.partition(itemWeight.data(), itemWeight.size(), omp_get_num_threads());
+                const int thread = omp_get_thread_num();
+                uint32_t item;
+                while (stealing.next(thread, item))
+                    for (size_t k = itemBegin[item]; k < itemBegin[item + 1]; ++k) boid(k, acc);
+            }
+        } else {
+            // Iterate in cell order so consecutive boids share the same neighbor cells
+            #pragma omp parallel
+            {
+                TRACE_WORK("grid.boids");
+                #pragma omp for schedule(runtime) nowait reduction(stats : acc)
+                for (size_t k = 0; k < n; ++k) boid(k, acc);
+            }
+        }
+
+        state.stats = acc.finish(true);
+        state.swap();
+    }
+};
+
+std::unique_ptr<FlockEngine> makeParallelEngine() {
+    return std::make_unique<ParallelEngine>();
+}
+
+std::unique_ptr<FlockEngine> makeGridEngine() {
+    return std::make_unique<GridEngine>();
+}
@@ -0,0 +1,243 @@
+#include "engine.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <omp.h>
+
+// Barnes-Hut style engine for large alignment/cohesion radii, where the 3x3 cells
+// of the grid cover most of the window and the step degrades towards O(n^2).
+// Every species gets a quadtree per step whose nodes keep the count, position sum
+// and velocity sum of the boids below them. A boid takes a node as a whole when
+// the node lies entirely inside its alignment/cohesion radius (exact), skips it
+// when it lies outside, and for a node straddling the radius opens it unless the
+// node is small as seen from the boid (size / distance to its center of mass < theta),
+// in which case the node counts if its center of mass is within the radius.
+// Separation is never approximated: nodes within the separation radius are always
+// opened, and leaves are scanned exactly with the neighbor kernel.
+// theta = 0 opens every straddling node, which gives the brute-force sums.
+class QuadtreeEngine : public FlockEngine {
+    static constexpr int LEAF_SIZE = 16;   // boids per leaf (one kernel call)
+    static constexpr int MAX_DEPTH = 24;   // coincident boids stop splitting here
+
+    struct Node {
+        float x0, y0, size;                // square covered by the node
+        float sumX, sumY, sumVx, sumVy;    // over the boids below
+        uint32_t begin, end;               // those boids, in tree order
+        int32_t child;                     // first of 4 consecutive children, -1 for a leaf
+    };
+
+    struct Tree {
+        std::vector<Node> nodes;
+        std::vector<uint32_t> order;              // tree slot -> boid of the bucket
+        FirstTouchVector<float> spx, spy, svx, svy; // boid state in tree order (leaves are ranges)
+
+        void reserve(size_t n) {
+            nodes.reserve(n / 4 + 1);
+            order.reserve(n);
+            spx.reserve(n); spy.reserve(n); svx.reserve(n); svy.reserve(n);
+        }
+
+        // Quadrant split of slots [begin, end) of node ni, depth-first
+        void split(uint32_t ni, uint32_t begin, uint32_t end, int depth, const float* px, const float* py,
+                   const float* vx, const float* vy) {
+            if (end - begin <= (uint32_t)LEAF_SIZE || depth == MAX_DEPTH) {
+                float sx = 0.f, sy = 0.f, svx = 0.f, svy = 0.f;
+                for (uint32_t k = begin; k < end; ++k) {
+                    const uint32_t i = order[k];
+                    sx += px[i]; sy += py[i]; svx += vx[i]; svy += vy[i];
+                }
+                Node& nd = nodes[ni];
+                nd.sumX = sx; nd.sumY = sy; nd.sumVx = svx; nd.sumVy = svy;
+                nd.begin = begin; nd.end = end; nd.child = -1;
+                return;
+            }
+
+            const float x0 = nodes[ni].x0, y0 = nodes[ni].y0, half = nodes[ni].size * 0.5f;
+            const float mx = x0 + half, my = y0 + half;
+            uint32_t* o = order.data();
+            uint32_t* midY  = std::partition(o + begin, o + end, [&](uint32_t i) { return py[i] < my; });
+            uint32_t* midX0 = std::partition(o + begin, midY,    [&](uint32_t i) { return px[i] < mx; });
+            uint32_t* midX1 = std::partition(midY, o + end,      [&](uint32_t i) { return px[i] < mx; });
+            const uint32_t bounds[5] = { begin, (uint32_t)(midX0 - o), (uint32_t)(midY - o),
+                                         (uint32_t)(midX1 - o), end };
+
+            // Children are appended, so only indices are held across the recursion
+            const int32_t child = (int32_t)nodes.size();
+            nodes.resize(nodes.size() + 4);
+            for (int q = 0; q < 4; ++q) {
+                Node& c = nodes[child + q];
+                c.x0 = (q & 1) ? mx : x0;
+                c.y0 = (q & 2) ? my : y0;
+                c.size = half;
+                split(child + q, bounds[q], bounds[q + 1], depth + 1, px, py, vx, vy);
+            }
+
+            Node& nd = nodes[ni];
+            nd.sumX = nd.sumY = nd.sumVx = nd.sumVy = 0.f;
+            for (int q = 0; q < 4; ++q) {
+                const Node& c = nodes[child + q];
+                nd.sumX += c.sumX; nd.sumY += c.sumY; nd.sumVx += c.sumVx; nd.sumVy += c.sumVy;
+            }
+            nd.begin = begin; nd.end = end; nd.child = child;
+        }
+
+        void build(const float* px, const float* py, const float* vx, const float* vy, size_t n) {
+            TRACE_SCOPE("quadtree.build");
+            order.resize(n);
+            std::iota(order.begin(), order.end(), 0u);
+            nodes.resize(1);
+            float minX = 0.f, minY = 0.f, maxX = 0.f, maxY = 0.f;
+            if (n > 0) {
+                minX = maxX = px[0]; minY = maxY = py[0];
+                for (size_t i = 1; i < n; ++i) {
+                    minX = std::min(minX, px[i]); maxX = std::max(maxX, px[i]);
+                    minY = std::min(minY, py[i]); maxY = std::max(maxY, py[i]);
+                }
+            }
+            // Slightly larger than the bounding box, so the far edges fall inside
+            nodes[0].x0 = minX;
+            nodes[0].y0 = minY;
+            nodes[0].size = std::max(maxX - minX, maxY - minY) * 1.001f + 1e-3f;
+            split(0, 0, (uint32_t)n, 0, px, py, vx, vy);
+
+            spx.resize(n); spy.resize(n); svx.resize(n); svy.resize(n);
+            #pragma omp parallel for schedule(static)
+            for (size_t k = 0; k < n; ++k) {
+                const uint32_t i = order[k];
+                spx[k] = px[i]; spy[k] = py[i];
+                svx[k] = vx[i]; svy[k] = vy[i];
+            }
+        }
+    };
+
+    std::vector<Tree> trees;     // per species, reused between steps
+    size_t reserved = 0;
+
+    // Adds tree t's boids around (pix, piy) to 'sums'; 'self' is the boid's own slot in t
+    // (or past the end when t is another species' tree), excluded like the kernel's d > 0
+    static void query(const Tree& t, float pix, float piy, float vix, float viy, uint32_t self,
+                      const NeighborRadii& r, NeighborKernelFn kernel, float theta2, NeighborSums& sums) {
+        const float maxR2 = std::max({r.sep2, r.ali2, r.coh2});
+        // 0: no boid of the node within r2, 1: all of them, 2: some
+        auto coverage = [](float r2, float dmin2, float dmax2) {
+            return (r2 <= 0.f || dmin2 >= r2) ? 0 : dmax2 < r2 ? 1 : 2;
+        };
+
+        uint32_t stack[3 * MAX_DEPTH + 4];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& nd = t.nodes[stack[--top]];
+            const uint32_t count = nd.end - nd.begin;
+            if (count == 0) continue;
+
+            // Nearest and farthest point of the square
+            const float x1 = nd.x0 + nd.size, y1 = nd.y0 + nd.size;
+            const float nx = std::max({nd.x0 - pix, 0.f, pix - x1});
+            const float ny = std::max({nd.y0 - piy, 0.f, piy - y1});
+            const float fx = std::max(pix - nd.x0, x1 - pix);
+            const float fy = std::max(piy - nd.y0, y1 - piy);
+            const float dmin2 = nx*nx + ny*ny, dmax2 = fx*fx + fy*fy;
+            if (dmin2 >= maxR2) continue;
+
+            // Separation is exact: open every node that reaches into its radius
+            const bool leaf = nd.child < 0;
+            if (leaf || dmin2 < r.sep2) {
+                if (leaf) kernel(t.spx.data(), t.spy.data(), t.svx.data(), t.svy.data(),
+                                 nd.begin, nd.end, pix, piy, r, sums);
+                else for (int q = 0; q < 4; ++q) stack[top++] = nd.child + q;
+                continue;
+            }
+
+            const int ali = coverage(r.ali2, dmin2, dmax2);
+            const int coh = coverage(r.coh2, dmin2, dmax2);
+            const float inv = 1.f / count;
+            const float dx = nd.sumX * inv - pix, dy = nd.sumY * inv - piy;
+            const float dcom2 = dx*dx + dy*dy;
+            if ((ali == 2 || coh == 2) && nd.size * nd.size >= theta2 * dcom2) {
+                for (int q = 0; q < 4; ++q) stack[top++] = nd.child + q;
+                continue;
+            }
+
+            const bool mine = self >= nd.begin && self < nd.end;
+            if (ali == 1 || (ali == 2 && dcom2 < r.ali2)) {
+                sums.ali_x += nd.sumVx - (mine ? vix : 0.f);
+                sums.ali_y += nd.sumVy - (mine ? viy : 0.f);
+                sums.ali_c += (int)count - (mine ? 1 : 0);
+            }
+            if (coh == 1 || (coh == 2 && dcom2 < r.coh2)) {
+                sums.coh_x += nd.sumX - (mine ? pix : 0.f);
+                sums.coh_y += nd.sumY - (mine ? piy : 0.f);
+                sums.coh_c += (int)count - (mine ? 1 : 0);
+            }
+        }
+    }
+
+public:
+    const char* name() const override { return "quadtree"; }
+
+    void reserve(size_t n) override {
+        reserved = n;
+        for (auto& t : trees) t.reserve(n);
+    }
+
+    void step(FlockState& state, const StepParams& p) override {
+        const size_t n = state.size();
+        if (n == 0) return;
+        state.prepareNext();
+
+        const SpeciesTable& species = *p.species;
+        const int numSpecies = species.count();
+        const NeighborKernelSet& kernels = p.kernels;
+        const float theta2 = p.theta * p.theta;
+
+        if ((int)trees.size() != numSpecies) {
+            trees.resize(numSpecies);
+            for (auto& t : trees) t.reserve(reserved);
+        }
+        for (int s = 0; s < numSpecies; ++s) {
+            const size_t b = species.begin(s);
+            trees[s].build(state.cur.px.data() + b, state.cur.py.data() + b,
+                           state.cur.vx.data() + b, state.cur.vy.data() + b, species.end(s) - b);
+        }
+
+        StatsAccum acc;
+        float centerX, centerY;
+        statsCenter(state, p, centerX, centerY);
+
+        // Boids in tree order, so consecutive boids walk the same nodes
+        #pragma omp parallel
+        {
+            TRACE_WORK("quadtree.boids");
+            #pragma omp for schedule(runtime) nowait reduction(stats : acc)
+            for (size_t k = 0; k < n; ++k) {
+                const int a = species.of(k);
+                const Tree& own = trees[a];
+                const uint32_t local = (uint32_t)(k - species.begin(a));
+                const size_t i = species.begin(a) + own.order[local];
+                const float pix = own.spx[local], piy = own.spy[local];
+                const float vix = own.svx[local], viy = own.svy[local];
+
+                NeighborSums sums;
+                for (int b = 0; b < numSpecies; ++b) {
+                    const unsigned rules = species.rules(a, b);
+                    if (rules == 0) continue;
+                    query(trees[b], pix, piy, vix, viy, b == a ? local : UINT32_MAX,
+                          species.radii(a, b), kernels.rules[rules], theta2, sums);
+                }
+                const BoidParams& bp = species.params[a];
+                float ax, ay;
+                steerBoid(sums, pix, piy, vix, viy, bp, p, ax, ay);
+                integrateBoid(state, i, ax, ay, bp, p, acc, sums.coh_c, centerX, centerY);
+            }
+        }
+
+        state.stats = acc.finish(true);
+        state.swap();
+    }
+};
+
+std::unique_ptr<FlockEngine> makeQuadtreeEngine() {
+    return std::make_unique<QuadtreeEngine>();
+}
@@ -0,0 +1,67 @@
+#include "flock.hpp"
+#include "trace.hpp"
+
+// Serial version - each boid processes neighbors sequentially.
+// Runs the original Bird methods on a persistent AoS copy so it stays the reference.
+class SerialEngine : public FlockEngine {
+    std::vector<Bird> scratch; // reused between steps, so no allocation after the first one
+
+public:
+    const char* name() const override { return "serial"; }
+    bool usesKernel() const override { return false; }
+    void reserve(size_t n) override { scratch.reserve(n); }
+
+    void step(FlockState& state, const StepParams& p) override {
+        const BoidState& cur = state.cur;
+        const size_t n = cur.size();
+
+        // One species keeps the original member-radius tests
+        const SpeciesTable& species = *p.species;
+        const bool mixed = species.count() > 1;
+        scratch.clear();
+        for (int s = 0; s < species.count(); ++s) {
+            for (size_t i = species.begin(s); i < species.end(s); ++i) {
+                scratch.emplace_back(Vector2D(cur.px[i], cur.py[i]), Vector2D(cur.vx[i], cur.vy[i]),
+                                     RGBA{0, 0, 0, 0}, species.params[s]);
+                scratch.back().species = s;
+                if (mixed) scratch.back().pairRadii = &species.pairRadii[s * species.count()];
+            }
+        }
+
+        {
+            TRACE_SCOPE("serial.flock");
+            for (auto& bird : scratch) {
+                bird.flock(scratch, p.width, p.height);
+            }
+        }
+
+        {
+            TRACE_SCOPE("serial.integrate");
+            for (auto& boid : scratch) {
+                boid.update();
+                boid.borders(p.width, p.height);
+            }
+        }
+
+        // Bird::flock does not expose its neighbor counts, so the stats leave them out
+        StatsAccum acc;
+        float cx, cy;
+        statsCenter(state, p, cx, cy);
+
+        state.prepareNext();
+        BoidState& next = state.next;
+        for (size_t i = 0; i < n; ++i) {
+            next.px[i] = scratch[i].position.x;
+            next.py[i] = scratch[i].position.y;
+            next.vx[i] = scratch[i].velocity.x;
+            next.vy[i] = scratch[i].velocity.y;
+            acc.add(next.px[i], next.py[i], next.vx[i], next.vy[i], 0, cx, cy);
+        }
+        state.stats = acc.finish(false);
+        state.swap();
+    }
+};
+
+std::unique_ptr<FlockEngine> makeSerialEngine() {
+    return std::make_unique<SerialEngine>();
+}
@@ -0,0 +1,196 @@
+#include "engine.hpp"
+#include <algorithm>
+#include <omp.h>
+#include "trace.hpp"
+
+// Evaluates every pair (i, j) with i in [i0, i1) and j in [j0, j1) once and applies it to
+// both boids. On a diagonal tile (same range) only j > i is visited.
+// i applies 'radii' to j and j applies 'radiiJ' to i; SameRadii (tiles of one species)
+// reuses the i weights for the j side. Rules (NeighborRule mask, the union of both sides)
+// drops the disabled rules at compile time.
+template <bool SameRadii, unsigned Rules>
+static void interactTiles(const float* px, const float* py, const float* vx, const float* vy,
+                          size_t i0, size_t i1, size_t j0, size_t j1, bool diagonal,
+                          const NeighborRadii& radii, const NeighborRadii& radiiJ,
+                          float* __restrict sx, float* __restrict sy,
+                          float* __restrict sc, float* __restrict ax, float* __restrict ay,
+                          float* __restrict ac, float* __restrict cx, float* __restrict cy,
+                          float* __restrict cc) {
+    for (size_t i = i0; i < i1; ++i) {
+        const float pix = px[i], piy = py[i], vix = vx[i], viy = vy[i];
+        float isx = 0.f, isy = 0.f, isc = 0.f;
+        float iax = 0.f, iay = 0.f, iac = 0.f;
+        float icx = 0.f, icy = 0.f, icc = 0.f;
+
+        // Branch-free: each rule contributes with a 0/1 weight. The j side gets the
+        // opposite separation term and i's velocity/position.
+        #pragma omp simd reduction(+:isx, isy, isc, iax, iay, iac, icx, icy, icc)
+        for (size_t j = diagonal ? i + 1 : j0; j < j1; ++j) {
+            const float dx = pix - px[j];
+            const float dy = piy - py[j];
+            const float d2 = dx*dx + dy*dy;
+            const bool  nz = d2 > 0.f;
+
+            if constexpr ((Rules & RULE_SEPARATION) != 0) {
+                const float inv2 = nz ? 1.0f / d2 : 0.f;
+                const float ws = (nz && d2 < radii.sep2) ? 1.f : 0.f;
+                const float wsj = SameRadii ? ws : ((nz && d2 < radiiJ.sep2) ? 1.f : 0.f);
+                const float fx = dx * inv2, fy = dy * inv2;
+                isx += ws * fx;     isy += ws * fy;     isc += ws;
+                sx[j] -= wsj * fx;  sy[j] -= wsj * fy;  sc[j] += wsj;
+            }
+            if constexpr ((Rules & RULE_ALIGNMENT) != 0) {
+                const float wa = (nz && d2 < radii.ali2) ? 1.f : 0.f;
+                const float waj = SameRadii ? wa : ((nz && d2 < radiiJ.ali2) ? 1.f : 0.f);
+                iax += wa * vx[j];  iay += wa * vy[j];  iac += wa;
+                ax[j] += waj * vix; ay[j] += waj * viy; ac[j] += waj;
+            }
+            if constexpr ((Rules & RULE_COHESION) != 0) {
+                const float wc = (nz && d2 < radii.coh2) ? 1.f : 0.f;
+                const float wcj = SameRadii ? wc : ((nz && d2 < radiiJ.coh2) ? 1.f : 0.f);
+                icx += wc * px[j];  icy += wc * py[j];  icc += wc;
+                cx[j] += wcj * pix; cy[j] += wcj * piy; cc[j] += wcj;
+            }
+        }
+
+        sx[i] += isx; sy[i] += isy; sc[i] += isc;
+        ax[i] += iax; ay[i] += iay; ac[i] += iac;
+        cx[i] += icx; cy[i] += icy; cc[i] += icc;
+    }
+}
+
+// Tile pair variants by NeighborRule mask (entry 0 is never called)
+using TileFn = decltype(&interactTiles<true, RULE_ALL>);
+template <bool SameRadii>
+static constexpr TileFn tileKernels[RULE_COMBOS] = {
+    interactTiles<SameRadii, 0>, interactTiles<SameRadii, 1>, interactTiles<SameRadii, 2>, interactTiles<SameRadii, 3>,
+    interactTiles<SameRadii, 4>, interactTiles<SameRadii, 5>, interactTiles<SameRadii, 6>, interactTiles<SameRadii, 7>,
+};
+
+// Tiled version: blocks of i against blocks of j that fit in cache, each pair evaluated
+// once (symmetry halves the distance computations). Threads accumulate into private
+// arrays, which are reduced per boid before steering and integration.
+// Tiles never straddle a species bucket, so each tile pair has constant radii.
+class TiledEngine : public FlockEngine {
+    struct Tile { size_t begin, end; int species; };
+    std::vector<Tile> tileList;
+
+    // Per-thread partial neighbor sums, one entry per boid.
+    // Counts are kept as floats (exact below 2^24) so the pair loop vectorizes uniformly.
+    struct TileAccum {
+        AlignedVector<float> sx, sy, sc, ax, ay, ac, cx, cy, cc;
+
+        void reset(size_t n) {
+            for (auto* a : {&sx, &sy, &sc, &ax, &ay, &ac, &cx, &cy, &cc}) a->assign(n, 0.f);
+        }
+        void reserve(size_t n) {
+            for (auto* a : {&sx, &sy, &sc, &ax, &ay, &ac, &cx, &cy, &cc}) a->reserve(n);
+        }
+    };
+    std::vector<TileAccum> tileAccum;
+    size_t reserved = 0;
+
+public:
+    // Boids per tile: a pair of tiles (positions, velocities and accumulators) stays well inside L1
+    static constexpr size_t TILE_SIZE = 256;
+
+    const char* name() const override { return "tiled"; }
+    bool usesKernel() const override { return false; }
+
+    // One accumulator set per thread (threads added later get theirs in step()); this only
+    // allocates, reset() still zeroes and first-touches on the owning thread
+    void reserve(size_t n) override {
+        reserved = n;
+        if ((int)tileAccum.size() < omp_get_max_threads()) tileAccum.resize(omp_get_max_threads());
+        for (TileAccum& acc : tileAccum) acc.reserve(n);
+        tileList.reserve(n / TILE_SIZE + 8);
+    }
+
+    void step(FlockState& state, const StepParams& p) override {
+        const size_t n = state.size();
+        if (n == 0) return;
+        state.prepareNext();
+
+        const float* px = state.cur.px.data();
+        const float* py = state.cur.py.data();
+        const float* vx = state.cur.vx.data();
+        const float* vy = state.cur.vy.data();
+
+        const SpeciesTable& species = *p.species;
+        tileList.clear();
+        for (int s = 0; s < species.count(); ++s) {
+            for (size_t b = species.begin(s); b < species.end(s); b += TILE_SIZE)
+                tileList.push_back({b, std::min(species.end(s), b + TILE_SIZE), s});
+        }
+        const size_t tiles = tileList.size();
+        if ((int)tileAccum.size() < omp_get_max_threads()) {
+            const size_t had = tileAccum.size();
+            tileAccum.resize(omp_get_max_threads());
+            for (size_t t = had; t < tileAccum.size(); ++t) tileAccum[t].reserve(reserved);
+        }
+
+        StatsAccum flockAcc;
+        float centerX, centerY;
+        statsCenter(state, p, centerX, centerY);
+
+        #pragma omp parallel
+        {
+            const int nthreads = omp_get_num_threads();
+            TileAccum& acc = tileAccum[omp_get_thread_num()];
+            acc.reset(n); // zeroed (and first touched) by the thread that owns it
+
+            // Row I pairs tile I with tiles I..tiles-1; rows shrink, so hand them out dynamically
+            {
+                TRACE_WORK("tiled.pairs");
+                #pragma omp for schedule(dynamic, 1) nowait
+                for (size_t I = 0; I < tiles; ++I) {
+                    const Tile& ti = tileList[I];
+                    for (size_t J = I; J < tiles; ++J) {
+                        const Tile& tj = tileList[J];
+                        const unsigned rules = species.rules(ti.species, tj.species) |
+                                               species.rules(tj.species, ti.species);
+                        if (rules == 0) continue;
+                        const NeighborRadii& rij = species.radii(ti.species, tj.species);
+                        const TileFn interact = ti.species == tj.species ? tileKernels<true>[rules]
+                                                                         : tileKernels<false>[rules];
+                        interact(px, py, vx, vy, ti.begin, ti.end, tj.begin, tj.end, I == J,
+                                 rij, species.radii(tj.species, ti.species),
+                                 acc.sx.data(), acc.sy.data(), acc.sc.data(),
+                                 acc.ax.data(), acc.ay.data(), acc.ac.data(),
+                                 acc.cx.data(), acc.cy.data(), acc.cc.data());
+                    }
+                }
+            }
+
+            // Barrier outside the traced scope so waiting shows up as a gap, not as work
+            #pragma omp barrier
+
+            // Every partial sum is complete
+            TRACE_WORK("tiled.reduce+integrate");
+            #pragma omp for schedule(static) nowait reduction(stats : flockAcc)
+            for (size_t i = 0; i < n; ++i) {
+                NeighborSums sums;
+                float sc = 0.f, ac = 0.f, cc = 0.f;
+                for (int t = 0; t < nthreads; ++t) {
+                    const TileAccum& a = tileAccum[t];
+                    sums.sep_x += a.sx[i]; sums.sep_y += a.sy[i]; sc += a.sc[i];
+                    sums.ali_x += a.ax[i]; sums.ali_y += a.ay[i]; ac += a.ac[i];
+                    sums.coh_x += a.cx[i]; sums.coh_y += a.cy[i]; cc += a.cc[i];
+                }
+                sums.sep_c = (int)sc; sums.ali_c = (int)ac; sums.coh_c = (int)cc;
+
+                const BoidParams& bp = species.params[species.of(i)];
+                float ax, ay;
+                steerBoid(sums, px[i], py[i], vx[i], vy[i], bp, p, ax, ay);
+                integrateBoid(state, i, ax, ay, bp, p, flockAcc, sums.coh_c, centerX, centerY);
+            }
+        }
+
+        state.stats = flockAcc.finish(true);
+        state.swap();
+    }
+};
+
+std::unique_ptr<FlockEngine> makeTiledEngine() {
+    return std::make_unique<TiledEngine>();
+}
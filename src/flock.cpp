@@ -0,0 +1,399 @@
+#include "flock.hpp"
+#include <algorithm>
+#include "perf_counters.hpp"
+#include "trace.hpp"
+#include <iostream>
+#include <omp.h>
+
+FlockingSystem::FlockingSystem(int width, int height)
+    : windowWidth(width), windowHeight(height), engine(createEngine("grid")) {
+    setSimdLevel(detectSimdLevel());
+    setCapacity(capacity);
+}
+
+bool FlockingSystem::setEngine(const std::string& name) {
+    auto e = createEngine(name);
+    if (!e) {
+        std::cerr << "[Warn] Unknown engine \"" << name << "\" (available: " << engineNames() << ")\n";
+        return false;
+    }
+    engine = std::move(e);
+    engine->reserve(capacity);
+    return true;
+}
+
+void FlockingSystem::setCapacity(size_t maxBoids) {
+    capacity = std::max<size_t>(maxBoids, MIN_BOIDS);
+    // Reserved, not touched: pages are only committed as boids are spawned
+    for (BoidState* s : {&boids.cur, &boids.next}) {
+        s->px.reserve(capacity); s->py.reserve(capacity);
+        s->vx.reserve(capacity); s->vy.reserve(capacity);
+    }
+    colors.reserve(capacity);
+    handles.reserve(capacity);
+    drawSlot.reserve(capacity);
+    drawnBoid.reserve(capacity);
+    engine->reserve(capacity);
+}
+
+// Random streams of a spawn key
+enum SpawnStream : uint32_t { SPAWN_X, SPAWN_Y, SPAWN_ANGLE, SPAWN_COLOR, SPAWN_RED, SPAWN_GREEN, SPAWN_BLUE };
+
+const RGBA* boidPalette() {
+    static const std::vector<RGBA> palette = [] {
+        // Fixed generator, so colors do not change with --seed
+        const CounterRng rng{0};
+        std::vector<RGBA> p(PALETTE_SIZE);
+        for (int k = 0; k < PALETTE_SIZE; ++k) {
+            p[k] = { (Uint8)(150 + rng.below(k, SPAWN_RED, 105)),    // 150-255
+                     (Uint8)(100 + rng.below(k, SPAWN_GREEN, 100)),  // 100-200
+                     (Uint8)( 50 + rng.below(k, SPAWN_BLUE, 100)),   // 50-150
+                     255 };
+        }
+        return p;
+    }();
+    return palette.data();
+}
+
+// Random initial velocity of spawn key k
+static void spawnVelocity(const CounterRng& rng, uint64_t k, float maxSpeed, float& vx, float& vy) {
+    const float angle = rng.uniform(k, SPAWN_ANGLE) * TWO_PI;
+    vx = std::cos(angle) * maxSpeed;
+    vy = std::sin(angle) * maxSpeed;
+}
+
+void randomSpawn(const CounterRng& rng, uint64_t k, int width, int height, float maxSpeed,
+                 float& x, float& y, float& vx, float& vy) {
+    x = rng.uniform(k, SPAWN_X) * width;
+    y = rng.uniform(k, SPAWN_Y) * height;
+    spawnVelocity(rng, k, maxSpeed, vx, vy);
+}
+
+void FlockingSystem::spawnAt(size_t i, uint64_t k, float x, float y, const BoidParams& p) {
+    boids.cur.px[i] = x;
+    boids.cur.py[i] = y;
+    spawnVelocity(rng, k, p.maxSpeed, boids.cur.vx[i], boids.cur.vy[i]);
+
+    // Random color with bird-like hues
+    colors[i] = (ColorIndex)rng.below(k, SPAWN_COLOR, PALETTE_SIZE);
+}
+
+size_t FlockingSystem::openSlots(size_t count, int s) {
+    const size_t n = boids.size();
+    ++boids.edits;
+    boids.cur.resize(n + count);
+    colors.resize(n + count);
+    handles.resize(n + count);
+    drawSlot.resize(n + count);
+    drawnBoid.resize(n + count);
+
+    // From the last bucket down: the first boids of bucket t move past its end,
+    // into the range the later buckets (or the new boids) just freed
+    std::vector<size_t>& start = species.start;
+    for (int t = species.count() - 1; t > s; --t) {
+        const size_t b = start[t], e = start[t + 1];
+        const size_t m = std::min(count, e - b);
+        for (size_t j = 0; j < m; ++j) moveBoid(b + j, e + count - m + j);
+    }
+    const size_t first = start[s + 1];
+    for (int t = s + 1; t <= species.count(); ++t) start[t] += count;
+    // New boids are drawn last (on top)
+    for (size_t j = 0; j < count; ++j) {
+        drawSlot[first + j] = (uint32_t)(n + j);
+        drawnBoid[n + j] = (uint32_t)(first + j);
+    }
+    return first;
+}
+
+void FlockingSystem::moveBoid(size_t from, size_t to) {
+    BoidState& cur = boids.cur;
+    BoidState& prev = boids.next;
+    // Keep the moved boid's previous step for interpolation (or none: prev = cur)
+    if (to < prevCount) {
+        const BoidState& src = from < prevCount ? prev : cur;
+        prev.px[to] = src.px[from]; prev.py[to] = src.py[from];
+        prev.vx[to] = src.vx[from]; prev.vy[to] = src.vy[from];
+    }
+    cur.px[to] = cur.px[from]; cur.py[to] = cur.py[from];
+    cur.vx[to] = cur.vx[from]; cur.vy[to] = cur.vy[from];
+    colors[to] = colors[from];
+    handles.move(from, to);
+    drawSlot[to] = drawSlot[from];
+    drawnBoid[drawSlot[to]] = (uint32_t)to;
+}
+
+// A new boid has no previous step: draw it where it is
+void FlockingSystem::clearPrevious(size_t i) {
+    if (i >= prevCount) return;
+    boids.next.px[i] = boids.cur.px[i]; boids.next.py[i] = boids.cur.py[i];
+    boids.next.vx[i] = boids.cur.vx[i]; boids.next.vy[i] = boids.cur.vy[i];
+}
+
+void FlockingSystem::spawnRandom(size_t count, int s) {
+    count = std::min(count, capacity - std::min(capacity, boids.size()));
+    if (count == 0) return;
+    const size_t first = openSlots(count, s);
+    const uint64_t key0 = spawned;
+    const BoidParams& p = species.params[s];
+
+    #pragma omp parallel for schedule(static)
+    for (size_t j = 0; j < count; ++j) {
+        const uint64_t k = key0 + j;
+        const size_t i = first + j;
+        spawnAt(i, k, rng.uniform(k, SPAWN_X) * windowWidth, rng.uniform(k, SPAWN_Y) * windowHeight, p);
+        clearPrevious(i);
+    }
+    for (size_t j = 0; j < count; ++j) handles.bind(first + j);
+    spawned += count;
+}
+
+// Adds a boid at (x, y) with random velocity and color
+BoidHandle FlockingSystem::addBoid(float x, float y, int s) {
+    if (s < 0 || s >= species.count() || boids.size() >= capacity) return BoidHandle();
+    const size_t i = openSlots(1, s);
+    spawnAt(i, spawned++, x, y, species.params[s]);
+    clearPrevious(i);
+    return handles.bind(i);
+}
+
+void FlockingSystem::removeAt(size_t i) {
+    std::vector<size_t>& start = species.start;
+    const int s = species.of(i);
+    handles.release(i);
+    ++boids.edits;
+
+    // The boid drawn last takes the removed boid's place in the draw order
+    const uint32_t lastDrawn = drawnBoid[boids.size() - 1];
+    drawSlot[lastDrawn] = drawSlot[i];
+    drawnBoid[drawSlot[i]] = lastDrawn;
+
+    // Fill the hole with the last boid of the bucket, then pass the hole on
+    // to the end of every later bucket the same way
+    size_t hole = i;
+    for (int t = s; t < species.count(); ++t) {
+        // After the first bucket, start[t] was already moved back onto the hole
+        const size_t last = start[t + 1] - 1;
+        if (last != hole) moveBoid(last, hole);
+        hole = last;
+        start[t + 1] -= 1;
+    }
+
+    const size_t n = boids.size() - 1;
+    boids.cur.resize(n);
+    colors.resize(n);
+    handles.resize(n);
+    drawSlot.resize(n);
+    drawnBoid.resize(n);
+    prevCount = std::min(prevCount, n);
+}
+
+bool FlockingSystem::removeBoid(BoidHandle h) {
+    size_t i;
+    if (!handles.find(h, i) || boids.size() <= (size_t)MIN_BOIDS) return false;
+    removeAt(i);
+    return true;
+}
+
+int FlockingSystem::addSpecies(const BoidParams& p) {
+    species.params.push_back(p);
+    species.start.push_back(species.start.back());
+    species.updateRadii();
+    return species.count() - 1;
+}
+
+void FlockingSystem::setFlockParams(int s, const FlockParams& f) {
+    if (s < 0 || s >= species.count()) return;
+    species.params[s].flock = f;
+    species.updateRadii();
+}
+
+bool FlockingSystem::nearestBoid(float x, float y, float maxDist, size_t& index) const {
+    const BoidState& cur = boids.cur;
+    float best = maxDist * maxDist;
+    bool found = false;
+    for (size_t i = 0; i < cur.size(); ++i) {
+        const float dx = cur.px[i] - x, dy = cur.py[i] - y;
+        const float d2 = dx*dx + dy*dy;
+        if (d2 <= best) { best = d2; index = i; found = true; }
+    }
+    return found;
+}
+
+void FlockingSystem::initializeBirds(int numBirds) {
+    boids.cur.resize(0);
+    ++boids.edits;
+    colors.clear();
+    handles.clear();
+    drawSlot.clear();
+    drawnBoid.clear();
+    stepsSinceSort = 0;
+    std::fill(species.start.begin(), species.start.end(), 0);
+    prevCount = 0;
+    spawned = 0;
+    boids.stats = FlockStats();
+    spawnRandom((size_t)std::max(numBirds, 0), 0);
+}
+
+StepParams FlockingSystem::stepParams() const {
+    StepParams sp;
+    sp.species = &species;
+    sp.width = windowWidth;
+    sp.height = windowHeight;
+    sp.kernels = neighborKernels;
+    sp.cellSize = cellSize;
+    sp.schedule = schedule;
+    sp.theta = theta;
+    return sp;
+}
+
+void FlockingSystem::previewStep(FlockEngine& other, BoidState& out) const {
+    FlockState copy = boids;
+    if (threads > 0) omp_set_num_threads(threads);
+    applySchedule(schedule, scheduleChunk);
+    other.step(copy, stepParams());
+    out = std::move(copy.cur);
+}
+
+void FlockingSystem::update() {
+    TRACE_SCOPE("flock.update");
+    const StepParams sp = stepParams();
+
+    if (threads > 0) omp_set_num_threads(threads);
+    applySchedule(schedule, scheduleChunk);
+    // Cache misses of every step as a trace counter track
+    const bool countMisses = trace::enabled() && perfCounters::available();
+    const perfCounters::CacheCounts before = countMisses ? perfCounters::read() : perfCounters::CacheCounts();
+    engine->step(boids, sp);
+    prevCount = boids.size();
+    if (sortInterval > 0 && ++stepsSinceSort >= sortInterval && !engine->keepsDeviceCopy()) {
+        sortBoids();
+        stepsSinceSort = 0;
+    }
+    if (countMisses) {
+        const perfCounters::CacheCounts d = perfCounters::read() - before;
+        trace::counter("cache.misses", (double)d.misses);
+        trace::counter("cache.l1d_misses", (double)d.l1dMisses);
+    }
+    if (stepHook) stepHook(*this);
+}
+
+// Interleaves the bits of x and y (16 each)
+static uint32_t morton(uint32_t x, uint32_t y) {
+    auto spread = [](uint32_t v) {
+        v &= 0xFFFF;
+        v = (v | (v << 8)) & 0x00FF00FF;
+        v = (v | (v << 4)) & 0x0F0F0F0F;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    };
+    return spread(x) | (spread(y) << 1);
+}
+
+// Reorders every bucket by grid cell, along the Morton curve or in bands (boids in
+// one cell share a key and keep their relative order). Runs right after a step, so the
+// previous step in boids.next is valid for every boid and moves with it.
+void FlockingSystem::sortBoids() {
+    TRACE_SCOPE("flock.sort");
+    const size_t n = boids.size();
+    if (n < 2) return;
+    sortKeys.reserve(capacity); sortFrom.reserve(capacity); sortScratch.reserve(capacity);
+    sortFloats.reserve(capacity); sortColors.reserve(capacity);
+    sortKeys.resize(n);
+    sortFrom.resize(n);
+
+    // Same cells as GridEngine
+    const float side = std::max(cellSize > 0.f ? cellSize : species.maxRadius(), 1.f);
+    const float inv = 1.f / side;
+    const float* px = boids.cur.px.data();
+    const float* py = boids.cur.py.data();
+    uint64_t* keys = sortKeys.data();
+    if (sortOrder == SortOrder::Bands) {
+        // Row-major cell id, clamped like NeighborGrid::cellX/cellY
+        const int cols = std::max(1, (int)std::ceil(windowWidth * inv));
+        const int rows = std::max(1, (int)std::ceil(windowHeight * inv));
+        #pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < n; ++i) {
+            const int cx = std::clamp((int)std::floor(px[i] * inv), 0, cols - 1);
+            const int cy = std::clamp((int)std::floor(py[i] * inv), 0, rows - 1);
+            keys[i] = (uint64_t)(cy * cols + cx) << 32 | i;
+        }
+    } else {
+        #pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < n; ++i) {
+            // Boids wrap at -r, so shift by one cell to keep the keys non-negative
+            const uint32_t cx = (uint32_t)std::clamp((px[i] + side) * inv, 0.f, 65535.f);
+            const uint32_t cy = (uint32_t)std::clamp((py[i] + side) * inv, 0.f, 65535.f);
+            keys[i] = (uint64_t)morton(cx, cy) << 32 | i;
+        }
+    }
+
+    // Insertion sort from the previous order; a bucket that is far from sorted
+    // (just spawned, or after a long pause) is sorted from scratch instead
+    bool moved = false;
+    for (int s = 0; s < species.count(); ++s) {
+        const size_t b = species.begin(s), e = species.end(s);
+        const size_t budget = 8 * (e - b);
+        size_t moves = 0;
+        for (size_t i = b + 1; i < e && moves <= budget; ++i) {
+            const uint64_t k = keys[i];
+            size_t j = i;
+            while (j > b && keys[j - 1] > k) { keys[j] = keys[j - 1]; --j; }
+            moves += i - j;
+            keys[j] = k;
+        }
+        if (moves > budget) std::sort(keys + b, keys + e);
+        moved |= moves > 0;
+    }
+    if (!moved) return;
+
+    uint32_t* from = sortFrom.data();
+    for (size_t i = 0; i < n; ++i) from[i] = (uint32_t)keys[i];
+
+    ++boids.edits;
+    BoidState& cur = boids.cur;
+    BoidState& prev = boids.next;
+    for (FirstTouchVector<float>* v : {&cur.px, &cur.py, &cur.vx, &cur.vy, &prev.px, &prev.py, &prev.vx, &prev.vy}) {
+        sortFloats.resize(n);
+        const float* src = v->data();
+        float* dst = sortFloats.data();
+        #pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < n; ++i) dst[i] = src[from[i]];
+        v->swap(sortFloats);
+    }
+    sortColors.resize(n);
+    for (size_t i = 0; i < n; ++i) sortColors[i] = colors[from[i]];
+    colors.swap(sortColors);
+    handles.permute(from, sortScratch);
+    sortScratch.resize(n);
+    for (size_t i = 0; i < n; ++i) sortScratch[i] = drawSlot[from[i]];
+    drawSlot.swap(sortScratch);
+    for (size_t i = 0; i < n; ++i) drawnBoid[drawSlot[i]] = (uint32_t)i;
+}
+
+// Renders all the birds in the system
+void FlockingSystem::render(SDL_Renderer* renderer, bool darkBoids, float alpha) {
+    // A step moves a boid at most maxSpeed; anything larger is a wrap around the border
+    const float maxJump = 0.5f * std::min(windowWidth, windowHeight);
+    batch.draw(renderer, boids.cur, colors.data(), boidPalette(), species, darkBoids,
+               &boids.next, prevCount, alpha, maxJump, drawSlot.data());
+}
+
+// handle window resize
+void FlockingSystem::resize(int width, int height) {
+    windowWidth = width;
+    windowHeight = height;
+}
+
+// Add or remove boids to reach target count
+void FlockingSystem::addBoids(int count, int s) {
+    if (count <= 0 || s < 0 || s >= species.count()) return;
+    spawnRandom((size_t)count, s);
+}
+
+// Remove boids from the end of bucket s, keeping at least MIN_BOIDS
+void FlockingSystem::removeBoids(int count, int s) {
+    if (count <= 0 || s < 0 || s >= species.count()) return;
+    const int remove = std::min({count, (int)boids.size() - MIN_BOIDS, (int)getSpeciesCount(s)});
+    for (int k = 0; k < remove; ++k) removeAt(species.end(s) - 1);
+}
@@ -0,0 +1,576 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include "engine.hpp"
+#include "batch.hpp"
+#include "rng.hpp"
+#include "pool.hpp"
+
+// ===========================
+// GLOBAL LIMITS
+// ===========================
+
+constexpr int MIN_BOIDS = 1;
+constexpr int DEFAULT_MAX_BOIDS = 200000;   // boid budget when --max-boids is not given
+
+// ===========================
+//  CONSTANTS
+// ==========================
+
+constexpr float PI = 3.14159265359f;
+constexpr float TWO_PI = 2.0f * PI;
+
+// ===========================
+//  STRUCTS
+// ==========================
+
+// RGBA color
+struct RGBA { Uint8 r, g, b, a; };
+
+// Boids keep a 1-byte index into a shared palette instead of their own color
+constexpr int PALETTE_SIZE = 256;
+using ColorIndex = uint8_t;
+
+// Palette of bird-like hues shared by every flock (PALETTE_SIZE entries, fixed)
+const RGBA* boidPalette();
+
+// Random position in a width x height world and velocity of spawn key k, as
+// initializeBirds/addBoids draw them (for flocks built outside a FlockingSystem)
+void randomSpawn(const CounterRng& rng, uint64_t k, int width, int height, float maxSpeed,
+                 float& x, float& y, float& vx, float& vy);
+
+// Representation of a 2D vector
+// provides utility function to operate 
+struct Vector2D {
+    float x, y;
+
+    // Constructors
+    Vector2D() : x(0), y(0) {}
+    Vector2D(float x_, float y_) : x(x_), y(y_) {}
+    
+    // Overload the arithmethic operators to 
+    // let sintax like Vec1 + Vec2 instead of Vec1.x + Vec2.x & Vec1.y + Vec2.y
+    
+    Vector2D operator+(const Vector2D & other) const {
+        return Vector2D(x + other.x, y + other.y);
+    }
+
+    Vector2D operator-(const Vector2D & other) const {
+        return Vector2D(x - other.x, y - other.y);
+    }
+
+    Vector2D operator*(float scalar) const {
+        return Vector2D(x * scalar, y * scalar);
+    }
+
+    Vector2D operator/(float scalar) const {
+        return Vector2D(x / scalar, y / scalar);
+    }
+
+    void operator+=(const Vector2D& other) {
+        x += other.x;
+        y += other.y;
+    }
+    
+    void operator-=(const Vector2D& other) {
+        x -= other.x;
+        y -= other.y;
+    }
+
+    void operator*=(float scalar) {
+        x *= scalar;
+        y *= scalar;
+    }
+
+
+    void operator/=(float scalar) {
+        x /= scalar;
+        y /= scalar;
+    }
+    
+    // UTILITY FUNCTION
+    
+    float magnitude() const {
+        return sqrt(x * x + y * y);
+    }
+    
+    /*Scales a vector to have a magnitud of 1*/
+    void normalize() {
+        float mag = magnitude();
+        if (mag > 0) {
+            x /= mag;
+            y /= mag;
+        }
+    }
+    
+    // Returns a normalized copy of the vector
+    Vector2D normalized() const {
+        Vector2D result = *this;
+        result.normalized();
+        return result;
+    }
+    
+    /*Limits the scale of a vector to have at most maxMav magnitud*/
+    void limit(float maxMag) {
+        if (magnitude() > maxMag) {
+            normalize();
+            *this *= maxMag;
+        }
+    }
+    
+    float heading() const {
+        return atan2(y, x);
+    }
+
+    // Return the distance between 2 scalars.
+    static float distance(const Vector2D& a, const Vector2D& b) {
+        return (a - b).magnitude();
+    }
+    
+    // Returns an unitary vector from 
+    static Vector2D fromAngle( float angle ) { 
+        return Vector2D(cos(angle), sin(angle));
+    }
+};
+
+// ==========================
+// FLOCK SYSTEM
+// ==========================
+
+class Bird {
+
+public:
+    Vector2D position;
+    Vector2D velocity;
+    Vector2D acceleration;
+    
+    float r;            // Size
+    float maxSpeed;     // Maximum speed
+    float maxForce;     // Maximum steering force
+    
+    // Flocking parameters
+    float separationRadius;
+    float alignmentRadius;
+    float cohesionRadius;
+    FlockParams flockParams;    // weights, enabled rules and bias shape
+
+    // Species: with pairRadii set (row of SpeciesTable::pairRadii for this species),
+    // the radii used against another bird come from pairRadii[other.species]
+    int species = 0;
+    const NeighborRadii* pairRadii = nullptr;
+    
+    // Visual properties
+    Uint8 red, green, blue, alpha;
+
+public:
+        // View of an existing boid, rebuilt from the SoA state of a FlockingSystem
+        Bird(const Vector2D& pos, const Vector2D& vel, const RGBA& color, const BoidParams& p)
+            : position(pos), velocity(vel), acceleration(0, 0),
+              red(color.r), green(color.g), blue(color.b), alpha(color.a) {
+            setParams(p);
+        }
+
+        // Copies the shared flocking parameters into this bird
+        void setParams(const BoidParams& p) {
+            r = p.r;
+            maxSpeed = p.maxSpeed;
+            maxForce = p.maxForce;
+            separationRadius = p.separationRadius;
+            alignmentRadius = p.alignmentRadius;
+            cohesionRadius = p.cohesionRadius;
+            flockParams = p.flock;
+        }
+
+        // Whether 'other' at distance d counts for a rule (radius member, or squared pair radius)
+        bool within(const Bird& other, float d, float radius, float NeighborRadii::* pairR2) const {
+            if (!pairRadii) return d < radius;
+            return d * d < pairRadii[other.species].*pairR2;
+        }
+
+        RGBA color() const { return {red, green, blue, alpha}; }
+
+        // Sets the Bird new position based on current accelaration, velocity and current coordinates.
+        void update() {
+            // Update velocity
+            velocity += acceleration;
+            velocity.limit(maxSpeed);
+            position += velocity;
+            
+            // Reset acceleration
+            acceleration *= 0;
+        }
+
+        // Update Bird current fields based on flock model ecuations.
+        // Disabled rules (FlockParams::rules) are skipped, like in the SoA engines.
+        void flock(const std::vector<Bird>& birds, int windowWidth, int windowHeight) {
+            const FlockParams& f = flockParams;
+            const unsigned rules = f.activeRules();
+
+            // Weight the forces and apply them
+            if (rules & RULE_SEPARATION) applyForce(separate(birds) * f.separationWeight);
+            if (rules & RULE_ALIGNMENT)  applyForce(align(birds) * f.alignmentWeight);
+            if (rules & RULE_COHESION)   applyForce(cohesion(birds) * f.cohesionWeight);
+            if (rules & RULE_BIAS)       applyForce(environmentalBias(windowWidth, windowHeight) * f.biasWeight);
+        }
+
+        void applyForce(const Vector2D& force) {
+            acceleration += force;
+        }
+
+        // Steering force towards a direction: STEER = DESIRED MINUS VELOCITY (same math as steerBoid)
+        Vector2D steerTo(const Vector2D& desired) const {
+            Vector2D steer(0, 0);
+            steerToward(desired.x, desired.y, velocity.x, velocity.y, maxSpeed, maxForce, steer.x, steer.y);
+            return steer;
+        }
+
+        // A method that calculates and applies a steering force towards a target
+        Vector2D seek(const Vector2D& target) const {
+            return steerTo(target - position);
+        }
+
+
+        // A given unit attempts to move away from neighbors who are too close.
+        Vector2D separate(const std::vector<Bird>& birds) {
+            Vector2D steer(0, 0);
+            int count = 0;
+            
+            for (const auto& other : birds) {
+                float d = Vector2D::distance(position, other.position);
+                if (d > 0 && within(other, d, separationRadius, &NeighborRadii::sep2)) {
+                    Vector2D diff = position - other.position;
+                    diff.normalize();
+                    diff /= d; // Weight by distance
+                    steer += diff;
+                    count++;
+                }
+            }
+            
+            if (count > 0) {
+                steer /= static_cast<float>(count);
+                return steerTo(steer);
+            }
+            
+            return steer;
+        }
+
+        // A given unit attempts to move to the center of mass of its neighbors.
+        Vector2D cohesion(const std::vector<Bird>& birds) {
+            Vector2D sum(0, 0);
+            int count = 0;
+            
+            for (const auto& other : birds) {
+                float d = Vector2D::distance(position, other.position);
+                if (d > 0 && within(other, d, cohesionRadius, &NeighborRadii::coh2)) {
+                    sum += other.position;
+                    count++;
+                }
+            }
+            
+            if (count > 0) {
+                sum /= static_cast<float>(count);
+                return seek(sum);
+            }
+            
+            return Vector2D(0, 0);
+        }
+    
+
+        // A given unit attempts to face the same direction as its neighbors.
+        Vector2D align(const std::vector<Bird>& birds) {
+            Vector2D sum(0, 0);
+            int count = 0;
+            
+            for (const auto& other : birds) {
+                float d = Vector2D::distance(position, other.position);
+                if (d > 0 && within(other, d, alignmentRadius, &NeighborRadii::ali2)) {
+                    sum += other.velocity;
+                    count++;
+                }
+            }
+            
+            if (count > 0) {
+                sum /= static_cast<float>(count);
+                return steerTo(sum);
+            }
+            
+            return Vector2D(0, 0);
+        }
+
+        // Environmental bias - encourages rightward flight in upper half (shape in FlockParams)
+        Vector2D environmentalBias(int windowWidth, int windowHeight) const {
+            Vector2D steer(0, 0);
+            biasSteer(flockParams, position.y, (float)windowHeight, velocity.x, velocity.y,
+                      maxSpeed, maxForce, steer.x, steer.y);
+            return steer;
+        }
+
+        // Behaviour when birds touch the borders: just draw on the opposite section of the window.
+        void borders(int width, int height) {
+            if (position.x < -r) position.x = width + r;
+            if (position.y < -r) position.y = height + r;
+            if (position.x > width + r) position.x = -r;
+            if (position.y > height + r) position.y = -r;
+        }
+
+        // Draws the birds onto window , based on current fields.
+        void render(SDL_Renderer* renderer, bool dark) const {
+            // Draw boid as triangle pointing in direction of velocity
+            float theta = velocity.heading() + PI / 2;
+            
+            Vector2D v1(0, -r * 2);
+            Vector2D v2(-r, r * 2);
+            Vector2D v3(r, r * 2);
+            
+            // Rotate vertices
+            float cosTheta = cos(theta);
+            float sinTheta = sin(theta);
+            
+            auto rotate = [cosTheta, sinTheta](Vector2D& v) {
+                float newX = v.x * cosTheta - v.y * sinTheta;
+                float newY = v.x * sinTheta + v.y * cosTheta;
+                v.x = newX;
+                v.y = newY;
+            };
+            
+            rotate(v1);
+            rotate(v2);
+            rotate(v3);
+            
+            // Translate to position
+            v1 += position;
+            v2 += position;
+            v3 += position;
+
+            Uint8 R = red, G = green, B = blue, A = alpha;
+            if (dark) {
+                R = (Uint8)(R * 0.35f);
+                G = (Uint8)(G * 0.35f);
+                B = (Uint8)(B * 0.45f);
+                SDL_SetRenderDrawColor(renderer, R, G, B, A);
+            } else {
+                // Draw filled triangle (approximate with lines)
+                SDL_SetRenderDrawColor(renderer, red, green, blue, alpha);
+            }
+            
+            // Draw triangle outline
+            SDL_RenderDrawLine(renderer, static_cast<int>(v1.x), static_cast<int>(v1.y),
+                              static_cast<int>(v2.x), static_cast<int>(v2.y));
+            SDL_RenderDrawLine(renderer, static_cast<int>(v2.x), static_cast<int>(v2.y),
+                              static_cast<int>(v3.x), static_cast<int>(v3.y));
+            SDL_RenderDrawLine(renderer, static_cast<int>(v3.x), static_cast<int>(v3.y),
+                              static_cast<int>(v1.x), static_cast<int>(v1.y));
+            
+            // Fill triangle with additional lines
+            for (int i = 1; i <= 3; i++) {
+                Vector2D p1 = v1 + (v2 - v1) * (i / 4.0f);
+                Vector2D p2 = v1 + (v3 - v1) * (i / 4.0f);
+                SDL_RenderDrawLine(renderer, static_cast<int>(p1.x), static_cast<int>(p1.y),
+                                  static_cast<int>(p2.x), static_cast<int>(p2.y));
+            }
+        }
+};
+
+// Larger, faster hunters: solitary among themselves, chased away from by other species
+// and steering for the centroid of the prey around them
+inline BoidParams predatorParams() {
+    BoidParams p;
+    p.r = 7.0f;
+    p.maxSpeed = 2.6f;
+    p.maxForce = 0.05f;
+    p.separationRadius = 40.0f;
+    p.alignmentRadius = 0.0f;
+    p.cohesionRadius = 0.0f;
+    p.avoidRadius = 90.0f;
+    p.chaseRadius = 120.0f;
+    p.flock.cohesionWeight = 1.2f;
+    p.flock.biasWeight = 0.3f;
+    return p;
+}
+
+// Key of the spatial re-sort (FlockingSystem::setSortInterval)
+enum class SortOrder {
+    Morton,   // Z-order curve of grid cells: close on screen, close in memory
+    Bands,    // grid cells row by row, as GridEngine visits them: a static share of the
+              // arrays is then one band of the world, both in the neighbor pass and in
+              // the pages the share first-touched (per-socket partitioning with --numa)
+};
+
+// Entity responsable for managing a group of birds.
+// The authoritative state is kept as persistent SoA arrays, double-buffered
+// (see FlockState), and advanced by a pluggable FlockEngine picked by name.
+// Bird is only materialized as a view (getBird) and by the serial engine.
+// Hot per-boid data is the 16 bytes of position and velocity; parameters are
+// shared per species (BoidParams) and the color is a palette index kept in a separate array.
+// Boids are bucketed by species (see SpeciesTable), bucket 0 being the default birds.
+// Storage for the whole boid budget is reserved up front, so adding boids never
+// reallocates mid-session; adding or removing moves at most one boid per species.
+class FlockingSystem {
+private:
+    FlockState boids;
+    std::vector<ColorIndex> colors; // cold per-boid data, only read when rendering
+    HandleTable handles;        // stable BoidHandle <-> index in the arrays above
+    size_t capacity = DEFAULT_MAX_BOIDS;
+    SpeciesTable species;
+    int windowWidth, windowHeight;
+    std::unique_ptr<FlockEngine> engine;
+    SimdLevel simdLevel = SimdLevel::Scalar;
+    NeighborKernelSet neighborKernels = neighborsScalarSet;
+    BoidBatch batch;            // persistent vertex buffer for render()
+    size_t prevCount = 0;       // leading boids whose previous step is valid in boids.next
+
+    // Draw order, independent of the array order (so re-sorting never changes which boid
+    // is drawn on top): boid i is drawn at position drawSlot[i], drawnBoid is the inverse
+    std::vector<uint32_t> drawSlot, drawnBoid;
+
+    // Spatial re-sort: every sortInterval steps the boids of each bucket are reordered
+    // along a Morton (Z-order) curve of grid cells, so boids that are close in space are
+    // close in memory. Flocks move little between sorts, so an insertion sort of the
+    // previous order is nearly linear.
+    int sortInterval = 0;       // steps between sorts (0 = never)
+    SortOrder sortOrder = SortOrder::Morton;
+    int stepsSinceSort = 0;
+    std::vector<uint64_t> sortKeys;     // Morton key << 32 | old index
+    std::vector<uint32_t> sortFrom, sortScratch;
+    FirstTouchVector<float> sortFloats;
+    std::vector<ColorIndex> sortColors;
+    void sortBoids();
+
+    // Spawning: boid k (in spawn order) draws its position, velocity and color
+    // from rng at key k, so results do not depend on threads or call order
+    CounterRng rng;
+    uint64_t spawned = 0;
+
+    // Random velocity and palette color of spawn key k, written to slot i
+    void spawnAt(size_t i, uint64_t k, float x, float y, const BoidParams& p);
+    // Adds count boids of species s at random positions, in parallel (clamped to the budget)
+    void spawnRandom(size_t count, int s);
+    // Opens count slots at the end of bucket s, shifting later buckets; returns the first slot
+    size_t openSlots(size_t count, int s);
+    // Moves boid 'from' into slot 'to' with its color, handle and previous step
+    void moveBoid(size_t from, size_t to);
+    // Removes boid i, refilling the hole from the end of each later bucket
+    void removeAt(size_t i);
+    void clearPrevious(size_t i);
+    // Step parameters of the current settings
+    StepParams stepParams() const;
+
+    // Runtime tuning, applied by update() on the calling thread
+    int threads = 0;            // OpenMP threads per step (0 = leave the runtime setting)
+    LoopSchedule schedule = LoopSchedule::Static;
+    int scheduleChunk = 0;
+    float cellSize = 0.f;       // grid cell side (0 = largest radius)
+    float theta = 0.5f;         // quadtree opening angle
+    std::function<void(const FlockingSystem&)> stepHook;
+
+public:
+    FlockingSystem(int width, int height);
+
+    // Switches to a registered engine; keeps the current one and returns false for unknown names
+    bool setEngine(const std::string& name);
+    const char* getEngineName() const { return engine->name(); }
+    bool usesKernel() const { return engine->usesKernel(); }
+
+    // Selects the neighbor kernel; unsupported levels fall back to the best available one
+    void setSimdLevel(SimdLevel level) { neighborKernels = selectNeighborKernels(level, &simdLevel); }
+    SimdLevel getSimdLevel() const { return simdLevel; }
+
+    void setThreads(int n) { threads = n; }
+    int getThreads() const { return threads; }
+    void setSchedule(LoopSchedule s, int chunk = 0) { schedule = s; scheduleChunk = chunk; }
+    LoopSchedule getSchedule() const { return schedule; }
+    int getScheduleChunk() const { return scheduleChunk; }
+    void setCellSize(float size) { cellSize = size; }
+    float getCellSize() const { return cellSize; }
+    // Opening angle of the quadtree engine (0 = exact, larger = more aggregated nodes)
+    void setTheta(float t) { theta = std::max(t, 0.f); }
+    float getTheta() const { return theta; }
+    // Steps between spatial re-sorts of the arrays (0 = keep the insertion order).
+    // Indices change on every sort; handles and the draw order do not.
+    void setSortInterval(int steps) { sortInterval = std::max(steps, 0); stepsSinceSort = 0; }
+    int getSortInterval() const { return sortInterval; }
+    void setSortOrder(SortOrder order) { sortOrder = order; }
+    SortOrder getSortOrder() const { return sortOrder; }
+
+    // Seed of the spawn generator; takes effect for the boids spawned afterwards
+    void setSeed(uint64_t seed) { rng.seed = seed; spawned = 0; }
+    uint64_t getSeed() const { return rng.seed; }
+
+    // Approximate bytes of boid state per boid (both buffers, color, handle maps, draw order)
+    static constexpr size_t BYTES_PER_BOID = 2 * 4 * sizeof(float) + sizeof(ColorIndex) + 6 * sizeof(uint32_t);
+
+    // Boid budget: reserves memory for maxBoids so adding boids never reallocates
+    // (already spawned boids beyond a smaller budget are kept)
+    void setCapacity(size_t maxBoids);
+    size_t getCapacity() const { return capacity; }
+
+    // Registers a species (empty) and returns its id; species 0 always exists
+    int addSpecies(const BoidParams& p);
+    const SpeciesTable& getSpecies() const { return species; }
+    size_t getSpeciesCount(int s) const { return species.end(s) - species.begin(s); }
+
+    // Adds a boid of species s at (x, y); invalid handle if the budget is exhausted
+    BoidHandle addBoid(float x, float y, int s = 0);
+    // Removes any boid in O(1); false for a stale handle or at MIN_BOIDS
+    bool removeBoid(BoidHandle h);
+    // Index of a live boid in state(); false if it was removed
+    bool findBoid(BoidHandle h, size_t& index) const { return handles.find(h, index); }
+    BoidHandle handleAt(size_t index) const { return handles.handleAt(index); }
+    // Closest boid to (x, y) within maxDist (linear scan, for mouse picking)
+    bool nearestBoid(float x, float y, float maxDist, size_t& index) const;
+
+    // Removes every boid and spawns numBirds of species 0 (other species stay registered, empty)
+    void initializeBirds(int numBirds);
+
+    // Advances the flock one step with the current engine
+    void update();
+    // Steps a copy of the flock with 'other' (same parameters) and returns the result in 'out';
+    // the flock itself is left untouched (one-step error of an approximate engine)
+    void previewStep(FlockEngine& other, BoidState& out) const;
+    // Called at the end of every update(), on the thread that runs it (e.g. --record)
+    void setStepHook(std::function<void(const FlockingSystem&)> hook) { stepHook = std::move(hook); }
+
+    // Draws every boid with one batched SDL_RenderGeometry call.
+    // alpha in [0, 1] interpolates between the previous and the current step.
+    void render(SDL_Renderer* renderer, bool darkBoids, float alpha = 1.f);
+    void setRenderDetail(BoidDetail d) { batch.setDetail(d); }
+    void resize(int width, int height);
+
+    // Returns the current number of boids
+    size_t getBoidCount() const { return boids.size(); }
+
+    // View of boid i (copy, changes are not written back)
+    Bird getBird(size_t i) const {
+        const BoidState& cur = boids.cur;
+        return Bird(Vector2D(cur.px[i], cur.py[i]), Vector2D(cur.vx[i], cur.vy[i]), boidPalette()[colors[i]], species.params[species.of(i)]);
+    }
+
+    const BoidState& state() const { return boids.cur; }
+    // Previous step (valid for the first previousCount() boids)
+    const BoidState& previousState() const { return boids.next; }
+    size_t previousCount() const { return prevCount; }
+    // Palette index of every boid (see boidPalette)
+    const std::vector<ColorIndex>& getColors() const { return colors; }
+    // Position of every boid in the draw order (see BoidBatch::draw)
+    const std::vector<uint32_t>& getDrawOrder() const { return drawSlot; }
+    int getWidth() const { return windowWidth; }
+    int getHeight() const { return windowHeight; }
+    // Parameters of species 0
+    const BoidParams& getParams() const { return species.params[0]; }
+    // Changes the weights and rules of species s (takes effect on the next step)
+    void setFlockParams(int s, const FlockParams& f);
+
+    void addBoids(int count, int s = 0);
+    // Removes boids of species s, keeping at least MIN_BOIDS in the flock
+    void removeBoids(int count, int s = 0);
+
+    // Statistics of the last step, reduced inside the engine's integration pass
+    const FlockStats& getStats() const { return boids.stats; }
+    float getAverageSpeed() const { return boids.stats.avgSpeed; }
+    float getCoherence() const { return boids.stats.coherence; }
+};
@@ -0,0 +1,116 @@
+#include "frame_writer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include "trace.hpp"
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+bool FrameWriter::start(const std::string& target, int w, int h, size_t depth) {
+    finish();
+    width = w;
+    height = h;
+    if (target == "-") {
+        dir.clear();
+        raw = stdout;
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    } else {
+        dir = target;
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        if (ec) {
+            std::cerr << "[Error] No se pudo crear el directorio " << dir << ": " << ec.message() << "\n";
+            return false;
+        }
+    }
+
+    // Allocated once; the same buffers cycle between renderer and writer
+    buffers.assign(std::max<size_t>(depth, 1), std::vector<uint8_t>((size_t)w * h * 4));
+    freeBuffers.clear();
+    queued.clear();
+    for (size_t b = 0; b < buffers.size(); ++b) freeBuffers.push_back(b);
+    nextIndex = 0;
+    stalledUs = 0;
+    stopping = false;
+    failed = false;
+    worker = std::thread(&FrameWriter::run, this);
+    return true;
+}
+
+uint8_t* FrameWriter::acquire() {
+    const auto t0 = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mutex);
+    bufferFreed.wait(lock, [&] { return !freeBuffers.empty(); });
+    filling = freeBuffers.front();
+    freeBuffers.pop_front();
+    stalledUs += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+    return buffers[filling].data();
+}
+
+void FrameWriter::submit() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued.push_back({filling, nextIndex++});
+    }
+    frameQueued.notify_one();
+}
+
+bool FrameWriter::finish() {
+    if (!worker.joinable()) return !failed;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    frameQueued.notify_one();
+    worker.join();
+    if (raw) std::fflush(raw);
+    raw = nullptr;
+    return !failed;
+}
+
+void FrameWriter::run() {
+    trace::setThreadName("writer");
+    while (true) {
+        std::pair<size_t, int> item;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            frameQueued.wait(lock, [&] { return stopping || !queued.empty(); });
+            if (queued.empty()) return;  // stopping and drained
+            item = queued.front();
+            queued.pop_front();
+        }
+        const bool ok = failed || write(buffers[item.first], item.second);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!ok) failed = true;
+            freeBuffers.push_back(item.first);
+        }
+        bufferFreed.notify_one();
+    }
+}
+
+bool FrameWriter::write(const std::vector<uint8_t>& rgba, int index) {
+    TRACE_SCOPE("writer.frame");
+    if (raw) {
+        if (std::fwrite(rgba.data(), 1, rgba.size(), raw) == rgba.size()) return true;
+        std::cerr << "[Error] Escritura fallida en stdout (frame " << index << ")\n";
+        return false;
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%05d.png", index);
+    const std::string path = (std::filesystem::path(dir) / name).string();
+    SDL_Surface* s = SDL_CreateRGBSurfaceWithFormatFrom(const_cast<uint8_t*>(rgba.data()), width, height,
+                                                        32, pitch(), SDL_PIXELFORMAT_RGBA32);
+    const bool ok = s && IMG_SavePNG(s, path.c_str()) == 0;
+    if (!ok) std::cerr << "[Error] No se pudo escribir " << path << ": " << SDL_GetError() << "\n";
+    if (s) SDL_FreeSurface(s);
+    return ok;
+}
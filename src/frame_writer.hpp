@@ -0,0 +1,54 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Writes rendered RGBA frames on its own thread: numbered PNG files in a directory,
+// or raw RGBA to stdout ("-") for ffmpeg. Frames travel through a bounded queue of
+// reused buffers, so the caller only blocks when the writer falls 'depth' frames behind
+// and encoding/disk I/O overlaps with the next simulation step.
+class FrameWriter {
+public:
+    ~FrameWriter() { finish(); }
+
+    bool start(const std::string& target, int width, int height, size_t depth = 4);
+
+    // Buffer (width * height * 4 bytes, rows of width * 4) to render the next frame into.
+    // Blocks while every buffer is queued; each acquire() must be followed by submit().
+    uint8_t* acquire();
+    // Queues the acquired buffer for writing
+    void submit();
+
+    // Writes the queued frames and stops the thread; false if any write failed
+    bool finish();
+
+    int pitch() const { return width * 4; }
+    // Time acquire() spent waiting for a free buffer, in microseconds
+    long long stallUs() const { return stalledUs; }
+
+private:
+    void run();
+    bool write(const std::vector<uint8_t>& rgba, int index);
+
+    std::string dir;            // empty = raw RGBA to stdout
+    FILE* raw = nullptr;
+    int width = 0, height = 0;
+
+    std::vector<std::vector<uint8_t>> buffers;
+    std::deque<size_t> freeBuffers;
+    std::deque<std::pair<size_t, int>> queued;  // (buffer, frame index)
+    size_t filling = 0;
+    int nextIndex = 0;
+    long long stalledUs = 0;
+
+    std::mutex mutex;
+    std::condition_variable bufferFreed, frameQueued;
+    bool stopping = false;
+    bool failed = false;
+    std::thread worker;
+};
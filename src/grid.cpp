@@ -0,0 +1,63 @@
+#include "grid.hpp"
+#include <algorithm>
+#include <cmath>
+#include "trace.hpp"
+
+// Cell column for an x coordinate, clamped so boids slightly outside the window still bin
+int NeighborGrid::cellX(float x) const {
+    int c = static_cast<int>(std::floor(x * invCell));
+    return std::clamp(c, 0, cols - 1);
+}
+
+// Cell row for a y coordinate, clamped like cellX
+int NeighborGrid::cellY(float y) const {
+    int c = static_cast<int>(std::floor(y * invCell));
+    return std::clamp(c, 0, rows - 1);
+}
+
+void NeighborGrid::reserve(size_t n) {
+    cellOf.reserve(n);
+    order.reserve(n);
+    spx.reserve(n); spy.reserve(n); svx.reserve(n); svy.reserve(n);
+}
+
+// Counting sort of boids by cell: histogram, exclusive prefix sum, stable scatter
+void NeighborGrid::build(const float* px, const float* py, const float* vx, const float* vy,
+                         size_t n, float cell, int width, int height) {
+    cellSize = std::max(cell, 1.f);
+    invCell = 1.f / cellSize;
+    cols = std::max(1, static_cast<int>(std::ceil(width  * invCell)));
+    rows = std::max(1, static_cast<int>(std::ceil(height * invCell)));
+    const int numCells = cols * rows;
+
+    cellOf.resize(n);
+    order.resize(n);
+    spx.resize(n); spy.resize(n); svx.resize(n); svy.resize(n);
+    cellStart.assign(numCells + 1, 0);
+
+    TRACE_SCOPE("grid.build");
+
+    // Cell id per boid (independent, so parallel)
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n; ++i) {
+        cellOf[i] = cellY(py[i]) * cols + cellX(px[i]);
+    }
+
+    // Histogram (shifted by one so the prefix sum yields start offsets)
+    for (size_t i = 0; i < n; ++i) cellStart[cellOf[i] + 1]++;
+    for (int c = 0; c < numCells; ++c) cellStart[c + 1] += cellStart[c];
+
+    // Stable scatter: boids keep their relative order inside each cell
+    cursor.assign(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < n; ++i) {
+        order[cursor[cellOf[i]]++] = static_cast<int>(i);
+    }
+
+    // Gather state in cell order for contiguous access in the neighbor loop
+    #pragma omp parallel for schedule(static)
+    for (size_t k = 0; k < n; ++k) {
+        const int i = order[k];
+        spx[k] = px[i]; spy[k] = py[i];
+        svx[k] = vx[i]; svy[k] = vy[i];
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include "aligned.hpp"
+
+// Uniform grid used to answer neighbor queries without visiting every boid.
+// Cell size equals the largest interaction radius, so every neighbor of a boid
+// lives in the 3x3 block of cells around it. Rebuilt each frame with a counting sort.
+class NeighborGrid {
+public:
+    int cols = 0, rows = 0;   // grid dimensions in cells
+    float cellSize = 1.f;     // side of a cell (max interaction radius)
+    float invCell = 1.f;      // 1 / cellSize
+
+    std::vector<int> cellStart; // first sorted slot of each cell (cols*rows + 1 entries)
+    std::vector<int> order;     // sorted slot -> boid index
+    FirstTouchVector<int> cellOf; // boid index -> cell id
+
+    // Boid state copied in cell order so that each row of 3 cells is one contiguous range
+    // (filled by parallel loops, so placed by first touch)
+    FirstTouchVector<float> spx, spy, svx, svy;
+
+private:
+    std::vector<int> cursor;    // per-cell write offsets used by the scatter pass
+
+public:
+    // Bins n boids into cells of side 'cell' covering a width x height window
+    void build(const float* px, const float* py, const float* vx, const float* vy,
+               size_t n, float cell, int width, int height);
+
+    // Pre-allocates the per-boid buffers for up to n boids
+    void reserve(size_t n);
+
+    // Cell coordinates for a position, clamped to the grid
+    int cellX(float x) const;
+    int cellY(float y) const;
+
+    // Returns the sorted range [begin, end) covering cells x0..x1 of a given row
+    void rowRange(int row, int x0, int x1, int& begin, int& end) const {
+        begin = cellStart[row * cols + x0];
+        end   = cellStart[row * cols + x1 + 1];
+    }
+};
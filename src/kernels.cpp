@@ -0,0 +1,150 @@
+#include "kernels.hpp"
+#include <cmath>
+#include <cstring>
+
+template <unsigned Rules>
+static void scalarKernel(const float* px, const float* py, const float* vx, const float* vy,
+                         size_t begin, size_t end, float pix, float piy,
+                         const NeighborRadii& radii, NeighborSums& s) {
+    const float sepR2 = radii.sep2, aliR2 = radii.ali2, cohR2 = radii.coh2;
+    float sep_x = 0.f, sep_y = 0.f; int sep_c = 0;
+    float ali_x = 0.f, ali_y = 0.f; int ali_c = 0;
+    float coh_x = 0.f, coh_y = 0.f; int coh_c = 0;
+
+    // Neighboors: vectorizable with simd
+
+    // (a) Directivas/cláusulas OpenMP no vistas en la intro:
+    //     Uso de `#pragma omp simd` con múltiples `reduction(+: ...)` para vectorizar el
+    //     bucle de vecinos (índice j). Razón: explota SIMD/ILP, acumula en registros
+    //     vectoriales sin locks/atómicas, elevando el throughput del O(n^2).
+
+    #pragma omp simd reduction(+:sep_x, sep_y, sep_c, ali_x, ali_y, ali_c, coh_x, coh_y, coh_c)
+    for (size_t j = begin; j < end; ++j) {
+        const float dx = pix - px[j];
+        const float dy = piy - py[j];
+        const float d2 = dx*dx + dy*dy;
+
+        if (d2 > 0.f) {
+            if constexpr ((Rules & RULE_SEPARATION) != 0) {
+                if (d2 < sepR2) {
+                    // diff.normalize(); diff/=d  -> invsqrt * inv (equals a /d)
+                    const float invd = 1.0f / std::sqrt(d2);
+                    sep_x += dx * invd * invd;
+                    sep_y += dy * invd * invd;
+                    sep_c++;
+                }
+            }
+            if constexpr ((Rules & RULE_ALIGNMENT) != 0) {
+                if (d2 < aliR2) {
+                    ali_x += vx[j];
+                    ali_y += vy[j];
+                    ali_c++;
+                }
+            }
+            if constexpr ((Rules & RULE_COHESION) != 0) {
+                if (d2 < cohR2) {
+                    coh_x += px[j];
+                    coh_y += py[j];
+                    coh_c++;
+                }
+            }
+        }
+    }
+
+    s.sep_x += sep_x; s.sep_y += sep_y; s.sep_c += sep_c;
+    s.ali_x += ali_x; s.ali_y += ali_y; s.ali_c += ali_c;
+    s.coh_x += coh_x; s.coh_y += coh_y; s.coh_c += coh_c;
+}
+
+void neighborsScalar(const float* px, const float* py, const float* vx, const float* vy,
+                     size_t begin, size_t end, float pix, float piy,
+                     const NeighborRadii& radii, NeighborSums& s) {
+    scalarKernel<RULE_ALL>(px, py, vx, vy, begin, end, pix, piy, radii, s);
+}
+
+const NeighborKernelSet neighborsScalarSet = {{
+    scalarKernel<0>, scalarKernel<1>, scalarKernel<2>, scalarKernel<3>,
+    scalarKernel<4>, scalarKernel<5>, scalarKernel<6>, scalarKernel<7>,
+}};
+
+// Whether the running CPU (and OS) can execute a level
+static bool cpuSupports(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Scalar:
+            return true;
+#if defined(FLOCK_HAVE_AVX2) && (defined(__GNUC__) || defined(__clang__))
+        case SimdLevel::AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+#if defined(FLOCK_HAVE_AVX512) && (defined(__GNUC__) || defined(__clang__))
+        case SimdLevel::AVX512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+#ifdef FLOCK_HAVE_NEON
+        case SimdLevel::NEON:
+            return true; // baseline on AArch64
+#endif
+        default:
+            return false;
+    }
+}
+
+SimdLevel detectSimdLevel() {
+    if (cpuSupports(SimdLevel::AVX512)) return SimdLevel::AVX512;
+    if (cpuSupports(SimdLevel::AVX2))   return SimdLevel::AVX2;
+    if (cpuSupports(SimdLevel::NEON))   return SimdLevel::NEON;
+    return SimdLevel::Scalar;
+}
+
+NeighborKernelFn selectNeighborKernel(SimdLevel level, SimdLevel* chosen) {
+    if (!cpuSupports(level)) level = detectSimdLevel();
+    if (chosen) *chosen = level;
+
+    switch (level) {
+#ifdef FLOCK_HAVE_AVX2
+        case SimdLevel::AVX2:   return neighborsAVX2;
+#endif
+#ifdef FLOCK_HAVE_AVX512
+        case SimdLevel::AVX512: return neighborsAVX512;
+#endif
+#ifdef FLOCK_HAVE_NEON
+        case SimdLevel::NEON:   return neighborsNEON;
+#endif
+        default:                return neighborsScalar;
+    }
+}
+
+NeighborKernelSet selectNeighborKernels(SimdLevel level, SimdLevel* chosen) {
+    if (!cpuSupports(level)) level = detectSimdLevel();
+    if (chosen) *chosen = level;
+
+    switch (level) {
+#ifdef FLOCK_HAVE_AVX2
+        case SimdLevel::AVX2:   return neighborsAVX2Set;
+#endif
+#ifdef FLOCK_HAVE_AVX512
+        case SimdLevel::AVX512: return neighborsAVX512Set;
+#endif
+#ifdef FLOCK_HAVE_NEON
+        case SimdLevel::NEON:   return neighborsNEONSet;
+#endif
+        default:                return neighborsScalarSet;
+    }
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX2:   return "avx2";
+        case SimdLevel::AVX512: return "avx512";
+        case SimdLevel::NEON:   return "neon";
+        default:                return "scalar";
+    }
+}
+
+bool parseSimdLevel(const char* s, SimdLevel& out) {
+    if (std::strcmp(s, "scalar") == 0) { out = SimdLevel::Scalar; return true; }
+    if (std::strcmp(s, "avx2")   == 0) { out = SimdLevel::AVX2;   return true; }
+    if (std::strcmp(s, "avx512") == 0) { out = SimdLevel::AVX512; return true; }
+    if (std::strcmp(s, "neon")   == 0) { out = SimdLevel::NEON;   return true; }
+    return false;
+}
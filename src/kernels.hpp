@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+
+// Neighbor kernels shared by every engine. Each instruction set lives in its own
+// translation unit compiled with the matching flags (see CMakeLists.txt), and the
+// best one supported by the running CPU is picked at startup.
+// Keep this header free of inline functions: anything inlined into an AVX-512
+// translation unit could be picked by the linker for the whole program.
+
+// Sums over the neighbors of one boid, one group per flocking rule
+struct NeighborSums {
+    float sep_x = 0.f, sep_y = 0.f; int sep_c = 0;
+    float ali_x = 0.f, ali_y = 0.f; int ali_c = 0;
+    float coh_x = 0.f, coh_y = 0.f; int coh_c = 0;
+};
+
+// Squared interaction radii
+struct NeighborRadii {
+    float sep2, ali2, coh2;
+};
+
+// Accumulates the contribution of boids [begin, end) of the SoA arrays to the boid at (pix, piy)
+using NeighborKernelFn = void (*)(const float* px, const float* py,
+                                  const float* vx, const float* vy,
+                                  size_t begin, size_t end, float pix, float piy,
+                                  const NeighborRadii& radii, NeighborSums& s);
+
+// Neighbor rules as a bit mask. Every kernel is compiled once per mask, with the
+// missing rules removed from the loop; their sums are left untouched.
+enum NeighborRule : unsigned {
+    RULE_SEPARATION = 1u,
+    RULE_ALIGNMENT  = 2u,
+    RULE_COHESION   = 4u,
+    RULE_ALL        = 7u,
+};
+constexpr unsigned RULE_COMBOS = 8;
+
+// Kernels of one instruction set, indexed by rule mask (entry 0 accumulates nothing)
+struct NeighborKernelSet {
+    NeighborKernelFn rules[RULE_COMBOS];
+};
+
+// Instruction sets a neighbor kernel can be built for
+enum class SimdLevel { Scalar, AVX2, AVX512, NEON };
+
+// Scalar reference (exact 1/sqrt, auto-vectorized with omp simd)
+void neighborsScalar(const float* px, const float* py, const float* vx, const float* vy,
+                     size_t begin, size_t end, float pix, float piy,
+                     const NeighborRadii& radii, NeighborSums& s);
+extern const NeighborKernelSet neighborsScalarSet;
+
+#ifdef FLOCK_HAVE_AVX2
+// 8 lanes, masked accumulation, rsqrt + one Newton step
+void neighborsAVX2(const float* px, const float* py, const float* vx, const float* vy,
+                   size_t begin, size_t end, float pix, float piy,
+                   const NeighborRadii& radii, NeighborSums& s);
+extern const NeighborKernelSet neighborsAVX2Set;
+#endif
+
+#ifdef FLOCK_HAVE_AVX512
+// 16 lanes, mask registers for both the radius tests and the loop tail
+void neighborsAVX512(const float* px, const float* py, const float* vx, const float* vy,
+                     size_t begin, size_t end, float pix, float piy,
+                     const NeighborRadii& radii, NeighborSums& s);
+extern const NeighborKernelSet neighborsAVX512Set;
+#endif
+
+#ifdef FLOCK_HAVE_NEON
+// 4 lanes, vrsqrte + one vrsqrts refinement step
+void neighborsNEON(const float* px, const float* py, const float* vx, const float* vy,
+                   size_t begin, size_t end, float pix, float piy,
+                   const NeighborRadii& radii, NeighborSums& s);
+extern const NeighborKernelSet neighborsNEONSet;
+#endif
+
+// Best instruction set compiled in and supported by the running CPU
+SimdLevel detectSimdLevel();
+
+// Kernel for a level; falls back to the best available one when 'level' is unsupported
+NeighborKernelFn selectNeighborKernel(SimdLevel level, SimdLevel* chosen = nullptr);
+// Every rule variant of the kernel selectNeighborKernel would pick
+NeighborKernelSet selectNeighborKernels(SimdLevel level, SimdLevel* chosen = nullptr);
+
+// "scalar" | "avx2" | "avx512" | "neon"
+const char* simdLevelName(SimdLevel level);
+bool parseSimdLevel(const char* s, SimdLevel& out);
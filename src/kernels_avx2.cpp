@@ -0,0 +1,98 @@
+// Built with -mavx2 -mfma; only reached through selectNeighborKernel on CPUs that support it.
+#include "kernels.hpp"
+#include <immintrin.h>
+
+// Sum of the 8 lanes of v
+static inline float hsum(__m256 v) {
+    __m128 lo = _mm256_castps256_ps128(v);
+    __m128 hi = _mm256_extractf128_ps(v, 1);
+    lo = _mm_add_ps(lo, hi);
+    lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+    lo = _mm_add_ss(lo, _mm_shuffle_ps(lo, lo, 0x55));
+    return _mm_cvtss_f32(lo);
+}
+
+template <unsigned Rules>
+static void avx2Kernel(const float* px, const float* py, const float* vx, const float* vy,
+                       size_t begin, size_t end, float pix, float piy,
+                       const NeighborRadii& radii, NeighborSums& s) {
+    constexpr bool SEP = (Rules & RULE_SEPARATION) != 0;
+    constexpr bool ALI = (Rules & RULE_ALIGNMENT) != 0;
+    constexpr bool COH = (Rules & RULE_COHESION) != 0;
+
+    const __m256 pix8 = _mm256_set1_ps(pix), piy8 = _mm256_set1_ps(piy);
+    const __m256 sep2 = _mm256_set1_ps(radii.sep2);
+    const __m256 ali2 = _mm256_set1_ps(radii.ali2);
+    const __m256 coh2 = _mm256_set1_ps(radii.coh2);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.f);
+    const __m256 half = _mm256_set1_ps(0.5f), threeHalves = _mm256_set1_ps(1.5f);
+
+    __m256 sepX = zero, sepY = zero, sepC = zero;
+    __m256 aliX = zero, aliY = zero, aliC = zero;
+    __m256 cohX = zero, cohY = zero, cohC = zero;
+
+    size_t j = begin;
+    for (; j + 8 <= end; j += 8) {
+        const __m256 qx = _mm256_loadu_ps(px + j), qy = _mm256_loadu_ps(py + j);
+        const __m256 dx = _mm256_sub_ps(pix8, qx), dy = _mm256_sub_ps(piy8, qy);
+        const __m256 d2 = _mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy));
+
+        // Lane masks instead of branches; d2 > 0 excludes the boid itself
+        const __m256 nz   = _mm256_cmp_ps(d2, zero, _CMP_GT_OQ);
+
+        if constexpr (SEP) {
+            const __m256 mSep = _mm256_and_ps(nz, _mm256_cmp_ps(d2, sep2, _CMP_LT_OQ));
+            // 1/d^2 from rsqrt + one Newton step: y' = y * (1.5 - 0.5 * d2 * y^2).
+            // Lanes with d2 == 0 give inf/NaN here but are cleared by the mask below.
+            __m256 y = _mm256_rsqrt_ps(d2);
+            y = _mm256_mul_ps(y, _mm256_fnmadd_ps(_mm256_mul_ps(half, d2), _mm256_mul_ps(y, y), threeHalves));
+            const __m256 inv2 = _mm256_mul_ps(y, y);
+
+            sepX = _mm256_add_ps(sepX, _mm256_and_ps(mSep, _mm256_mul_ps(dx, inv2)));
+            sepY = _mm256_add_ps(sepY, _mm256_and_ps(mSep, _mm256_mul_ps(dy, inv2)));
+            sepC = _mm256_add_ps(sepC, _mm256_and_ps(mSep, one));
+        }
+        if constexpr (ALI) {
+            const __m256 mAli = _mm256_and_ps(nz, _mm256_cmp_ps(d2, ali2, _CMP_LT_OQ));
+            aliX = _mm256_add_ps(aliX, _mm256_and_ps(mAli, _mm256_loadu_ps(vx + j)));
+            aliY = _mm256_add_ps(aliY, _mm256_and_ps(mAli, _mm256_loadu_ps(vy + j)));
+            aliC = _mm256_add_ps(aliC, _mm256_and_ps(mAli, one));
+        }
+        if constexpr (COH) {
+            const __m256 mCoh = _mm256_and_ps(nz, _mm256_cmp_ps(d2, coh2, _CMP_LT_OQ));
+            cohX = _mm256_add_ps(cohX, _mm256_and_ps(mCoh, qx));
+            cohY = _mm256_add_ps(cohY, _mm256_and_ps(mCoh, qy));
+            cohC = _mm256_add_ps(cohC, _mm256_and_ps(mCoh, one));
+        }
+    }
+
+    float sx = hsum(sepX), sy = hsum(sepY);
+    float ax = hsum(aliX), ay = hsum(aliY);
+    float cx = hsum(cohX), cy = hsum(cohY);
+    int sc = (int)hsum(sepC), ac = (int)hsum(aliC), cc = (int)hsum(cohC);
+
+    // Remainder (< 8 boids)
+    for (; j < end; ++j) {
+        const float dx = pix - px[j], dy = piy - py[j];
+        const float d2 = dx*dx + dy*dy;
+        if (d2 <= 0.f) continue;
+        if (SEP && d2 < radii.sep2) { sx += dx / d2; sy += dy / d2; sc++; }
+        if (ALI && d2 < radii.ali2) { ax += vx[j]; ay += vy[j]; ac++; }
+        if (COH && d2 < radii.coh2) { cx += px[j]; cy += py[j]; cc++; }
+    }
+
+    s.sep_x += sx; s.sep_y += sy; s.sep_c += sc;
+    s.ali_x += ax; s.ali_y += ay; s.ali_c += ac;
+    s.coh_x += cx; s.coh_y += cy; s.coh_c += cc;
+}
+
+void neighborsAVX2(const float* px, const float* py, const float* vx, const float* vy,
+                   size_t begin, size_t end, float pix, float piy,
+                   const NeighborRadii& radii, NeighborSums& s) {
+    avx2Kernel<RULE_ALL>(px, py, vx, vy, begin, end, pix, piy, radii, s);
+}
+
+const NeighborKernelSet neighborsAVX2Set = {{
+    avx2Kernel<0>, avx2Kernel<1>, avx2Kernel<2>, avx2Kernel<3>,
+    avx2Kernel<4>, avx2Kernel<5>, avx2Kernel<6>, avx2Kernel<7>,
+}};
@@ -0,0 +1,92 @@
+// Built with -mavx512f -mfma; only reached through selectNeighborKernel on CPUs that support it.
+#include "kernels.hpp"
+#include <immintrin.h>
+
+// Horizontal sum of 16 floats, mirroring hsum in kernels_avx2.cpp. GCC 12 builds
+// _mm512_reduce_add_ps, the unmasked shuffles and even _mm512_castps512_ps128 on an
+// undefined vector, which warns (-Wuninitialized) in every kernel they are inlined into;
+// the zero-masked forms with a full mask are the same instructions without it.
+static inline float hsum16(__m512 v) {
+    v = _mm512_add_ps(v, _mm512_maskz_shuffle_f32x4(0xFFFF, v, v, _MM_SHUFFLE(1, 0, 3, 2)));  // 256-bit halves
+    v = _mm512_add_ps(v, _mm512_maskz_shuffle_f32x4(0xFFFF, v, v, _MM_SHUFFLE(2, 3, 0, 1)));  // 128-bit lanes
+    __m128 lo = _mm512_maskz_extractf32x4_ps(0xF, v, 0);
+    lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+    lo = _mm_add_ss(lo, _mm_shuffle_ps(lo, lo, 0x55));
+    return _mm_cvtss_f32(lo);
+}
+
+template <unsigned Rules>
+static void avx512Kernel(const float* px, const float* py, const float* vx, const float* vy,
+                         size_t begin, size_t end, float pix, float piy,
+                         const NeighborRadii& radii, NeighborSums& s) {
+    constexpr bool SEP = (Rules & RULE_SEPARATION) != 0;
+    constexpr bool ALI = (Rules & RULE_ALIGNMENT) != 0;
+    constexpr bool COH = (Rules & RULE_COHESION) != 0;
+
+    const __m512 pix16 = _mm512_set1_ps(pix), piy16 = _mm512_set1_ps(piy);
+    const __m512 sep2 = _mm512_set1_ps(radii.sep2);
+    const __m512 ali2 = _mm512_set1_ps(radii.ali2);
+    const __m512 coh2 = _mm512_set1_ps(radii.coh2);
+    const __m512 zero = _mm512_setzero_ps(), one = _mm512_set1_ps(1.f);
+    const __m512 half = _mm512_set1_ps(0.5f), threeHalves = _mm512_set1_ps(1.5f);
+
+    __m512 sepX = zero, sepY = zero, sepC = zero;
+    __m512 aliX = zero, aliY = zero, aliC = zero;
+    __m512 cohX = zero, cohY = zero, cohC = zero;
+
+    for (size_t j = begin; j < end; j += 16) {
+        // The last iteration loads only the remaining lanes (masked-off lanes read as 0)
+        const size_t left = end - j;
+        const __mmask16 live = left >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << left) - 1u);
+
+        const __m512 qx = _mm512_maskz_loadu_ps(live, px + j);
+        const __m512 qy = _mm512_maskz_loadu_ps(live, py + j);
+        const __m512 dx = _mm512_sub_ps(pix16, qx), dy = _mm512_sub_ps(piy16, qy);
+        const __m512 d2 = _mm512_fmadd_ps(dx, dx, _mm512_mul_ps(dy, dy));
+
+        // d2 > 0 excludes the boid itself
+        const __mmask16 nz   = _mm512_mask_cmp_ps_mask(live, d2, zero, _CMP_GT_OQ);
+
+        if constexpr (SEP) {
+            const __mmask16 mSep = _mm512_mask_cmp_ps_mask(nz, d2, sep2, _CMP_LT_OQ);
+            // 1/d^2 from rsqrt14 + one Newton step, evaluated only on separation lanes
+            __m512 y = _mm512_maskz_rsqrt14_ps(mSep, d2);
+            y = _mm512_mul_ps(y, _mm512_fnmadd_ps(_mm512_mul_ps(half, d2), _mm512_mul_ps(y, y), threeHalves));
+            const __m512 inv2 = _mm512_mul_ps(y, y);
+
+            sepX = _mm512_mask_add_ps(sepX, mSep, sepX, _mm512_mul_ps(dx, inv2));
+            sepY = _mm512_mask_add_ps(sepY, mSep, sepY, _mm512_mul_ps(dy, inv2));
+            sepC = _mm512_mask_add_ps(sepC, mSep, sepC, one);
+        }
+        if constexpr (ALI) {
+            const __mmask16 mAli = _mm512_mask_cmp_ps_mask(nz, d2, ali2, _CMP_LT_OQ);
+            aliX = _mm512_mask_add_ps(aliX, mAli, aliX, _mm512_maskz_loadu_ps(mAli, vx + j));
+            aliY = _mm512_mask_add_ps(aliY, mAli, aliY, _mm512_maskz_loadu_ps(mAli, vy + j));
+            aliC = _mm512_mask_add_ps(aliC, mAli, aliC, one);
+        }
+        if constexpr (COH) {
+            const __mmask16 mCoh = _mm512_mask_cmp_ps_mask(nz, d2, coh2, _CMP_LT_OQ);
+            cohX = _mm512_mask_add_ps(cohX, mCoh, cohX, qx);
+            cohY = _mm512_mask_add_ps(cohY, mCoh, cohY, qy);
+            cohC = _mm512_mask_add_ps(cohC, mCoh, cohC, one);
+        }
+    }
+
+    s.sep_x += hsum16(sepX); s.sep_y += hsum16(sepY);
+    s.sep_c += (int)hsum16(sepC);
+    s.ali_x += hsum16(aliX); s.ali_y += hsum16(aliY);
+    s.ali_c += (int)hsum16(aliC);
+    s.coh_x += hsum16(cohX); s.coh_y += hsum16(cohY);
+    s.coh_c += (int)hsum16(cohC);
+}
+
+void neighborsAVX512(const float* px, const float* py, const float* vx, const float* vy,
+                     size_t begin, size_t end, float pix, float piy,
+                     const NeighborRadii& radii, NeighborSums& s) {
+    avx512Kernel<RULE_ALL>(px, py, vx, vy, begin, end, pix, piy, radii, s);
+}
+
+const NeighborKernelSet neighborsAVX512Set = {{
+    avx512Kernel<0>, avx512Kernel<1>, avx512Kernel<2>, avx512Kernel<3>,
+    avx512Kernel<4>, avx512Kernel<5>, avx512Kernel<6>, avx512Kernel<7>,
+}};
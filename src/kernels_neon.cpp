@@ -0,0 +1,92 @@
+// AArch64 only: NEON is part of the base ISA, so no extra flags are needed.
+#include "kernels.hpp"
+#include <arm_neon.h>
+
+template <unsigned Rules>
+static void neonKernel(const float* px, const float* py, const float* vx, const float* vy,
+                       size_t begin, size_t end, float pix, float piy,
+                       const NeighborRadii& radii, NeighborSums& s) {
+    constexpr bool SEP = (Rules & RULE_SEPARATION) != 0;
+    constexpr bool ALI = (Rules & RULE_ALIGNMENT) != 0;
+    constexpr bool COH = (Rules & RULE_COHESION) != 0;
+
+    const float32x4_t pix4 = vdupq_n_f32(pix), piy4 = vdupq_n_f32(piy);
+    const float32x4_t sep2 = vdupq_n_f32(radii.sep2);
+    const float32x4_t ali2 = vdupq_n_f32(radii.ali2);
+    const float32x4_t coh2 = vdupq_n_f32(radii.coh2);
+    const float32x4_t zero = vdupq_n_f32(0.f);
+    const uint32x4_t one = vreinterpretq_u32_f32(vdupq_n_f32(1.f));
+
+    float32x4_t sepX = zero, sepY = zero, sepC = zero;
+    float32x4_t aliX = zero, aliY = zero, aliC = zero;
+    float32x4_t cohX = zero, cohY = zero, cohC = zero;
+
+    // Masked add: acc += (mask ? v : 0)
+    auto madd = [](float32x4_t acc, uint32x4_t m, float32x4_t v) {
+        return vaddq_f32(acc, vreinterpretq_f32_u32(vandq_u32(m, vreinterpretq_u32_f32(v))));
+    };
+
+    size_t j = begin;
+    for (; j + 4 <= end; j += 4) {
+        const float32x4_t qx = vld1q_f32(px + j), qy = vld1q_f32(py + j);
+        const float32x4_t dx = vsubq_f32(pix4, qx), dy = vsubq_f32(piy4, qy);
+        const float32x4_t d2 = vfmaq_f32(vmulq_f32(dy, dy), dx, dx);
+
+        // d2 > 0 excludes the boid itself
+        const uint32x4_t nz   = vcgtq_f32(d2, zero);
+
+        if constexpr (SEP) {
+            const uint32x4_t mSep = vandq_u32(nz, vcltq_f32(d2, sep2));
+            // 1/d^2 from vrsqrte + one Newton step (vrsqrts computes (3 - a*b) / 2)
+            float32x4_t y = vrsqrteq_f32(d2);
+            y = vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(d2, y), y));
+            const float32x4_t inv2 = vmulq_f32(y, y);
+
+            sepX = madd(sepX, mSep, vmulq_f32(dx, inv2));
+            sepY = madd(sepY, mSep, vmulq_f32(dy, inv2));
+            sepC = vaddq_f32(sepC, vreinterpretq_f32_u32(vandq_u32(mSep, one)));
+        }
+        if constexpr (ALI) {
+            const uint32x4_t mAli = vandq_u32(nz, vcltq_f32(d2, ali2));
+            aliX = madd(aliX, mAli, vld1q_f32(vx + j));
+            aliY = madd(aliY, mAli, vld1q_f32(vy + j));
+            aliC = vaddq_f32(aliC, vreinterpretq_f32_u32(vandq_u32(mAli, one)));
+        }
+        if constexpr (COH) {
+            const uint32x4_t mCoh = vandq_u32(nz, vcltq_f32(d2, coh2));
+            cohX = madd(cohX, mCoh, qx);
+            cohY = madd(cohY, mCoh, qy);
+            cohC = vaddq_f32(cohC, vreinterpretq_f32_u32(vandq_u32(mCoh, one)));
+        }
+    }
+
+    float sx = vaddvq_f32(sepX), sy = vaddvq_f32(sepY);
+    float ax = vaddvq_f32(aliX), ay = vaddvq_f32(aliY);
+    float cx = vaddvq_f32(cohX), cy = vaddvq_f32(cohY);
+    int sc = (int)vaddvq_f32(sepC), ac = (int)vaddvq_f32(aliC), cc = (int)vaddvq_f32(cohC);
+
+    // Remainder (< 4 boids)
+    for (; j < end; ++j) {
+        const float dx = pix - px[j], dy = piy - py[j];
+        const float d2 = dx*dx + dy*dy;
+        if (d2 <= 0.f) continue;
+        if (SEP && d2 < radii.sep2) { sx += dx / d2; sy += dy / d2; sc++; }
+        if (ALI && d2 < radii.ali2) { ax += vx[j]; ay += vy[j]; ac++; }
+        if (COH && d2 < radii.coh2) { cx += px[j]; cy += py[j]; cc++; }
+    }
+
+    s.sep_x += sx; s.sep_y += sy; s.sep_c += sc;
+    s.ali_x += ax; s.ali_y += ay; s.ali_c += ac;
+    s.coh_x += cx; s.coh_y += cy; s.coh_c += cc;
+}
+
+void neighborsNEON(const float* px, const float* py, const float* vx, const float* vy,
+                   size_t begin, size_t end, float pix, float piy,
+                   const NeighborRadii& radii, NeighborSums& s) {
+    neonKernel<RULE_ALL>(px, py, vx, vy, begin, end, pix, piy, radii, s);
+}
+
+const NeighborKernelSet neighborsNEONSet = {{
+    neonKernel<0>, neonKernel<1>, neonKernel<2>, neonKernel<3>,
+    neonKernel<4>, neonKernel<5>, neonKernel<6>, neonKernel<7>,
+}};
@@ -9,6 +9,8 @@
 #include <vector>
 #include <limits>
 #include <cctype>
+#include <cstdlib>
+#include <thread>
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
@@ -17,23 +19,22 @@
 #include "backends/imgui_impl_sdl2.h"
 #include "backends/imgui_impl_sdlrenderer2.h"
 #include "cat.hpp"
+#include "flock.hpp"
+#include "pipeline.hpp"
+#include "trace.hpp"
+#include "perf_counters.hpp"
+#include "numa.hpp"
+#include "power.hpp"
+#include "dashboard.hpp"
+#include "snapshot.hpp"
+#include "frame_writer.hpp"
+#include "recording.hpp"
+#ifdef FLOCK_HAVE_MPI
+#include "distributed.hpp"
+#endif
 
 #include <omp.h>
 
-// ===========================
-// GLOBAL LIMITS
-// ===========================
-
-constexpr int MIN_BOIDS = 1;
-constexpr int MAX_BOIDS = 3000;
-
-// ===========================
-//  CONSTANTS
-// ==========================
-
-constexpr float PI = 3.14159265359f;
-constexpr float TWO_PI = 2.0f * PI;
-
 // ===========================
 //  STRUCTS
 // ==========================
@@ -44,24 +45,83 @@ struct CLI_Options {
     int height = 0;
     int numBoids = 150;
     bool showStats = true;
-    bool useParallel = true;
     bool showTrails = false;
     bool useSunset = true;
     bool darkBoids = false;
+    std::vector<std::string> engines;   // --engine list (GUI starts with the first one)
+    SimdLevel simd = detectSimdLevel(); // neighbor kernel instruction set
+    std::string renderer = "accelerated"; // "accelerated" (GPU + vsync) | "software"
+    int maxFps = 60;                      // pacing target when vsync is off (0 = uncapped)
+    float frameBudget = 0.f;              // low-power mode: work per frame in ms before quality drops (0 = off)
+    int simHz = 60;                       // fixed simulation rate (steps per second)
+    int maxSimSteps = 5;                  // cap of simulation steps per rendered frame
+    bool pipeline = false;                // simulate on a separate thread while rendering
+    int maxBoids = DEFAULT_MAX_BOIDS;     // boid budget, reserved up front
+    int predators = 0;                    // boids of a predator species the flock separates from
+    FlockParams flock;                    // weights and rules of the flock (--weights, --rules)
 
     // Benchmark Mode:
     bool bench = false;        // Benchmark Mode (without SDL/render)
     int frames = 600;          // frames per test
     int trials = 10;           // number of measurements per configuration
     int threads = 0;           // OMP threads (0 = runtime default)
+    LoopSchedule schedule = LoopSchedule::Static;  // per-boid loop schedule (--schedule)
+    std::vector<LoopSchedule> benchSchedules;      // --schedule list for sweeps (empty = schedule)
+    int sortInterval = 8;      // steps between spatial re-sorts of the boid arrays (0 = never)
+    float theta = 0.5f;        // opening angle of the quadtree engine (0 = exact)
+    bool numa = false;         // first-touch friendly placement: bind threads, one world band per static share
+    std::string procBind;      // OMP_PROC_BIND to run with (empty = environment)
+    std::string places;        // OMP_PLACES to run with (empty = environment)
+    int warmup = 1;            // discarded trials before measuring each point
+    std::vector<int> benchBoids;   // --boids list for sweeps (empty = numBoids)
+    std::vector<int> benchThreads; // --threads list for sweeps (empty = threads)
+    std::string jsonPath;      // JSON output path (default: CSV path with .json)
+    std::string tracePath;     // Chrome trace output (empty = tracing off)
     unsigned seed = 12345;     // RNG seed
     std::string csvPath;       // CSV output path (empty = stdout only)
-    std::string mode = "both"; // "serial" | "parallel" | "both"
+    std::string mode = "both"; // "serial" | "parallel" | "tiled" | "both" | "all" (when no --engine)
+
+    // Verify Mode:
+    bool verify = false;       // compare engines step by step (without SDL/render)
+    float tolerance = 0.5f;    // max position divergence in pixels before a frame fails
+    std::string saveStates;    // trajectory of the reference engine to write
+    std::string loadStates;    // golden trajectory to compare against instead of a second engine
+
+    // Offline Mode:
+    std::string renderOut;     // PNG directory, or "-" for raw RGBA on stdout (empty = window)
+    bool headless = false;     // simulate --frames steps without window or rendering (with --record)
+
+    // Recording:
+    std::string recordPath;    // .flk log of every simulation step (window, --headless, --render-out)
+    bool recordDelta = true;   // delta frames between key frames (--record-keyframes-only turns off)
+    int keyInterval = 60;      // frames between forced key frames
+    std::string replayPath;    // .flk log to play back instead of simulating
+
+    // Distributed Mode (MPI):
+    bool distributed = false;  // one world strip per rank; --boids, --predators and --width are per rank
 
 };
 
-// RGBA color
-struct RGBA { Uint8 r, g, b, a; };
+// Sleeps until the next frame slot when the renderer is not vsync-locked,
+// so the loop does not spin a core that the simulation could use
+struct FramePacer {
+    using clock = std::chrono::steady_clock;
+    clock::duration period{};
+    clock::time_point next = clock::now();
+
+    explicit FramePacer(int fps) {
+        if (fps > 0) period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / fps));
+    }
+
+    void wait() {
+        if (period == clock::duration::zero()) return;
+        next += period;
+        const auto now = clock::now();
+        // Too far behind (slow frame, window dragged): resync instead of bursting
+        if (next < now - period) next = now;
+        else std::this_thread::sleep_until(next);
+    }
+};
 
 // ===========================
 //  UTILITY FUNCTION
@@ -92,118 +152,142 @@ static inline RGBA mix(const RGBA& a, const RGBA& b, float t) {
     return { u8lerp(a.r,b.r,t), u8lerp(a.g,b.g,t), u8lerp(a.b,b.b,t), u8lerp(a.a,b.a,t) };
 }
 
-// Draws a vertical gradient from top to bottom with a color transition at 'split' (0..1)
-static void drawSunsetGradient(SDL_Renderer* r, int w, int h, float split) {
+// Color of the vertical sunset gradient at height t (0..1) with a transition at 'split' (0..1)
+static RGBA sunsetColor(float t, float split) {
     const RGBA top    = {255, 136,  0, 255};
     const RGBA mid    = {255,  66, 123, 255};
     const RGBA bottom = { 46,  26,  71, 255};
-
-    // Draw in bands to avoid per-pixel overhead
-    const int bandH = 2; 
-    for (int y = 0; y < h; y += bandH) {
-        float t = (float)y / (float)(h - 1);
-        RGBA c = (t < split)
-            ? mix(top, mid, t / split)
-            : mix(mid, bottom, (t - split) / (1.f - split));
-        SDL_SetRenderDrawColor(r, c.r, c.g, c.b, c.a);
-        SDL_Rect row{0, y, w, std::min(bandH, h - y)};
-        SDL_RenderFillRect(r, &row);
-    }
+    return (t < split)
+        ? mix(top, mid, t / split)
+        : mix(mid, bottom, (t - split) / (1.f - split));
 }
 
-// Representation of a 2D vector
-// provides utility function to operate 
-struct Vector2D {
-    float x, y;
-
-    // Constructors
-    Vector2D() : x(0), y(0) {}
-    Vector2D(float x_, float y_) : x(x_), y(y_) {}
-    
-    // Overload the arithmethic operators to 
-    // let sintax like Vec1 + Vec2 instead of Vec1.x + Vec2.x & Vec1.y + Vec2.y
-    
-    Vector2D operator+(const Vector2D & other) const {
-        return Vector2D(x + other.x, y + other.y);
+// Sunset gradient cached in a 1 x H texture and stretched over the window with one copy.
+// The texture is rebuilt only when the height changes or the split moves by a whole row.
+struct SunsetBackground {
+    SDL_Texture* tex = nullptr;
+    int texH = 0;
+    int splitRow = -1;
+    std::vector<RGBA> column;
+
+    void draw(SDL_Renderer* r, int w, int h, float split) {
+        if (h <= 0) return;
+        const int row = (int)(split * h);
+        if (!tex || h != texH) {
+            if (tex) SDL_DestroyTexture(tex);
+            tex = SDL_CreateTexture(r, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, 1, h);
+            if (!tex) {
+                std::cerr << "[Error] SDL_CreateTexture: " << SDL_GetError() << "\n";
+                return;
+            }
+            texH = h;
+            splitRow = -1;
+        }
+        if (row != splitRow) {
+            column.resize(h);
+            for (int y = 0; y < h; ++y)
+                column[y] = sunsetColor((float)y / (float)std::max(h - 1, 1), split);
+            SDL_UpdateTexture(tex, nullptr, column.data(), (int)sizeof(RGBA));
+            splitRow = row;
+        }
+        SDL_Rect dst{0, 0, w, h};
+        SDL_RenderCopy(r, tex, nullptr, &dst);
     }
 
-    Vector2D operator-(const Vector2D & other) const {
-        return Vector2D(x - other.x, y - other.y);
-    }
+    // Must run before SDL_DestroyRenderer, which owns the texture
+    void release() { if (tex) SDL_DestroyTexture(tex); tex = nullptr; }
+};
 
-    Vector2D operator*(float scalar) const {
-        return Vector2D(x * scalar, y * scalar);
-    }
 
-    Vector2D operator/(float scalar) const {
-        return Vector2D(x / scalar, y / scalar);
-    }
+// Splits "a,b,c" into its non-empty items
+static std::vector<std::string> splitList(const std::string& s) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        if (!item.empty()) out.push_back(item);
+    return out;
+}
 
-    void operator+=(const Vector2D& other) {
-        x += other.x;
-        y += other.y;
-    }
-    
-    void operator-=(const Vector2D& other) {
-        x -= other.x;
-        y -= other.y;
+// Parses "a,b,c" into integers within [minVal, maxVal]; false (and out untouched) on any bad item
+static bool parseIntList(const std::string& s, std::vector<int>& out, int minVal, int maxVal) {
+    std::vector<int> values;
+    for (const auto& item : splitList(s)) {
+        int v;
+        if (!parseStrictNonNegInt(item, v) || v < minVal || v > maxVal) {
+            std::cerr << "[Advertencia] Valor inválido en la lista \"" << s << "\": \"" << item
+                      << "\" (rango " << minVal << ".." << maxVal << "), se ignora la lista.\n";
+            return false;
+        }
+        values.push_back(v);
     }
+    if (values.empty()) return false;
+    out = std::move(values);
+    return true;
+}
 
-    void operator*=(float scalar) {
-        x *= scalar;
-        y *= scalar;
+// Parses "a,b,c" into exactly 'count' non-negative floats; false (and out untouched) on any bad item
+static bool parseFloatList(const std::string& s, float* out, size_t count) {
+    const std::vector<std::string> items = splitList(s);
+    std::vector<float> values;
+    for (const auto& item : items) {
+        char* end = nullptr;
+        const float v = std::strtof(item.c_str(), &end);
+        if (end != item.c_str() + item.size() || !std::isfinite(v) || v < 0.f) return false;
+        values.push_back(v);
     }
+    if (values.size() != count) return false;
+    std::copy(values.begin(), values.end(), out);
+    return true;
+}
 
-
-    void operator/=(float scalar) {
-        x /= scalar;
-        y /= scalar;
-    }
-    
-    // UTILITY FUNCTION
-    
-    float magnitude() const {
-        return sqrt(x * x + y * y);
-    }
-    
-    /*Scales a vector to have a magnitud of 1*/
-    void normalize() {
-        float mag = magnitude();
-        if (mag > 0) {
-            x /= mag;
-            y /= mag;
-        }
-    }
-    
-    // Returns a normalized copy of the vector
-    Vector2D normalized() const {
-        Vector2D result = *this;
-        result.normalized();
-        return result;
-    }
-    
-    /*Limits the scale of a vector to have at most maxMav magnitud*/
-    void limit(float maxMag) {
-        if (magnitude() > maxMag) {
-            normalize();
-            *this *= maxMag;
-        }
-    }
-    
-    float heading() const {
-        return atan2(y, x);
+// Parses the enabled rules: "sep,ali,coh,bias", "all" or "none"
+static bool parseRules(const std::string& s, unsigned& out) {
+    if (s == "all")  { out = RULE_ALL | RULE_BIAS; return true; }
+    if (s == "none") { out = 0; return true; }
+    unsigned rules = 0;
+    for (const auto& item : splitList(s)) {
+        if (item == "sep") rules |= RULE_SEPARATION;
+        else if (item == "ali") rules |= RULE_ALIGNMENT;
+        else if (item == "coh") rules |= RULE_COHESION;
+        else if (item == "bias") rules |= RULE_BIAS;
+        else return false;
     }
+    out = rules;
+    return true;
+}
 
-    // Return the distance between 2 scalars.
-    static float distance(const Vector2D& a, const Vector2D& b) {
-        return (a - b).magnitude();
-    }
-    
-    // Returns an unitary vector from 
-    static Vector2D fromAngle( float angle ) { 
-        return Vector2D(cos(angle), sin(angle));
+// Parses a boid budget: a count ("500000") or bytes of boid state ("64MB", "1GB", "512KB", "4096B")
+static bool parseBoidBudget(const std::string& s, int& out) {
+    size_t digits = 0;
+    while (digits < s.size() && std::isdigit((unsigned char)s[digits])) ++digits;
+    int value;
+    if (!parseStrictNonNegInt(s.substr(0, digits), value)) return false;
+
+    const std::string unit = s.substr(digits);
+    if (unit.empty()) { out = value; return value >= MIN_BOIDS; }
+
+    long long scale;
+    if (unit == "B") scale = 1;
+    else if (unit == "KB") scale = 1LL << 10;
+    else if (unit == "MB") scale = 1LL << 20;
+    else if (unit == "GB") scale = 1LL << 30;
+    else return false;
+    const long long boids = (long long)value * scale / (long long)FlockingSystem::BYTES_PER_BOID;
+    out = (int)std::min<long long>(boids, std::numeric_limits<int>::max());
+    return out >= MIN_BOIDS;
+}
+
+// Keeps the registered engine names of a --engine list, warning about the rest
+static std::vector<std::string> parseEngineList(const std::string& s) {
+    std::vector<std::string> out;
+    for (const auto& name : splitList(s)) {
+        if (createEngine(name)) out.push_back(name);
+        else std::cerr << "[Advertencia] Motor desconocido \"" << name
+                       << "\" (disponibles: " << engineNames() << "), se ignora.\n";
     }
-};
+    return out;
+}
 
 // Warns about invalid boids number and shows fallback
 static void warnInvalidBoids(const std::string& raw, int fallback) {
@@ -247,7 +331,7 @@ static CLI_Options parseArgs(int argc, char** argv) {
         if (!a.empty() && a[0] != '-') {
             int num;
             if (parseStrictNonNegInt(a, num)) {
-                if (num >= MIN_BOIDS) opt.numBoids = std::min(num, MAX_BOIDS);
+                if (num >= MIN_BOIDS) opt.numBoids = num;
                 else warnInvalidBoids(a, opt.numBoids);
                 continue;
             } else if (looksLikeNumber(a)) {
@@ -259,20 +343,115 @@ static CLI_Options parseArgs(int argc, char** argv) {
         // The rest of the arguments are passed with with flags
         if (auto v = eat("--width");  !v.empty())  parseStrictNonNegInt(v.c_str(), opt.width);
         else if (auto v = eat("--height"); !v.empty()) parseStrictNonNegInt(v.c_str(), opt.height);
-        else if (auto v = eat("--boids"); !v.empty()) parseStrictNonNegInt(v.c_str(), opt.numBoids);
+        else if (auto v = eat("--boids"); !v.empty()) {
+            if (v.find(',') == std::string::npos) parseStrictNonNegInt(v.c_str(), opt.numBoids);
+            else if (parseIntList(v, opt.benchBoids, MIN_BOIDS, std::numeric_limits<int>::max())) opt.numBoids = opt.benchBoids.front();
+        }
+        else if (auto v = eat("--predators"); !v.empty()) parseStrictNonNegInt(v, opt.predators);
+        else if (auto v = eat("--max-boids"); !v.empty()) {
+            if (!parseBoidBudget(v, opt.maxBoids))
+                std::cerr << "[Advertencia] Valor inválido para --max-boids: \"" << v
+                          << "\" (boids o bytes: 500000, 64MB, 1GB), se usa " << opt.maxBoids << ".\n";
+        }
+        else if (auto v = eat("--weights"); !v.empty()) {
+            float w[4];
+            if (parseFloatList(v, w, 4)) {
+                opt.flock.separationWeight = w[0]; opt.flock.alignmentWeight = w[1];
+                opt.flock.cohesionWeight = w[2];   opt.flock.biasWeight = w[3];
+            } else {
+                std::cerr << "[Advertencia] --weights debe ser sep,ali,coh,bias (4 valores >= 0), se ignora.\n";
+            }
+        }
+        else if (auto v = eat("--rules"); !v.empty()) {
+            if (!parseRules(v, opt.flock.rules))
+                std::cerr << "[Advertencia] --rules debe ser una lista de sep,ali,coh,bias (o all|none), se ignora.\n";
+        }
         else if (a == "--no-gui") opt.showStats = false;
-        else if (a == "--serial") opt.useParallel = false;
+        else if (a == "--serial") opt.engines = {"serial"};
         else if (a == "--trails") opt.showTrails = true;
+        else if (a == "--pipeline") opt.pipeline = true;
         else if (a == "--sunset")     opt.useSunset = true;
         else if (a == "--no-sunset")  opt.useSunset = false;
         else if (a == "--dark-boids") opt.darkBoids = true;
         else if (a == "--bench") opt.bench = true;
+        else if (a == "--verify") opt.verify = true;
+        else if (auto v = eat("--tolerance"); !v.empty()) {
+            char* end = nullptr;
+            const float t = std::strtof(v.c_str(), &end);
+            if (end == v.c_str() + v.size() && std::isfinite(t) && t >= 0.f) opt.tolerance = t;
+            else std::cerr << "[Advertencia] Valor inválido para --tolerance: \"" << v
+                           << "\", se usará " << opt.tolerance << ".\n";
+        }
+        else if (auto v = eat("--render-out"); !v.empty()) opt.renderOut = v;
+        else if (a == "--headless") opt.headless = true;
+        else if (a == "--distributed") opt.distributed = true;
+        else if (auto v = eat("--record"); !v.empty()) opt.recordPath = v;
+        else if (a == "--record-keyframes-only") opt.recordDelta = false;
+        else if (auto v = eat("--keyframe-interval"); !v.empty()) parseStrictNonNegInt(v, opt.keyInterval);
+        else if (auto v = eat("--replay"); !v.empty()) opt.replayPath = v;
+        else if (auto v = eat("--save-states"); !v.empty()) opt.saveStates = v;
+        else if (auto v = eat("--load-states"); !v.empty()) opt.loadStates = v;
         else if (auto v = eat("--frames"); !v.empty()) parseStrictNonNegInt(v, opt.frames);
         else if (auto v = eat("--trials"); !v.empty()) parseStrictNonNegInt(v, opt.trials);
-        else if (auto v = eat("--threads"); !v.empty()) parseStrictNonNegInt(v, opt.threads);
+        else if (auto v = eat("--threads"); !v.empty()) {
+            if (v.find(',') == std::string::npos) parseStrictNonNegInt(v, opt.threads);
+            else if (parseIntList(v, opt.benchThreads, 1, 4096)) opt.threads = opt.benchThreads.front();
+        }
+        else if (auto v = eat("--schedule"); !v.empty()) {
+            std::vector<LoopSchedule> list;
+            for (const auto& item : splitList(v)) {
+                LoopSchedule sched;
+                if (parseSchedule(item.c_str(), sched)) list.push_back(sched);
+                else std::cerr << "[Advertencia] --schedule desconocido \"" << item
+                               << "\" (static|dynamic|guided|steal), se ignora.\n";
+            }
+            if (!list.empty()) { opt.schedule = list.front(); if (list.size() > 1) opt.benchSchedules = list; }
+        }
+        else if (auto v = eat("--sort-interval"); !v.empty()) parseStrictNonNegInt(v, opt.sortInterval);
+        else if (auto v = eat("--theta"); !v.empty()) {
+            if (!parseFloatList(v, &opt.theta, 1))
+                std::cerr << "[Advertencia] Valor inválido para --theta: \"" << v
+                          << "\", se usará " << opt.theta << ".\n";
+        }
+        else if (a == "--numa") opt.numa = true;
+        else if (auto v = eat("--bind"); !v.empty()) {
+            if (v == "close" || v == "spread" || v == "master" || v == "primary" || v == "true" || v == "false") opt.procBind = v;
+            else std::cerr << "[Advertencia] --bind debe ser close|spread|master|primary|true|false, se ignora.\n";
+        }
+        else if (auto v = eat("--places"); !v.empty()) opt.places = v;  // threads|cores|sockets|ll_caches|numa_domains|{lista}
+        else if (auto v = eat("--warmup"); !v.empty()) parseStrictNonNegInt(v, opt.warmup);
+        else if (auto v = eat("--json"); !v.empty()) opt.jsonPath = v;
+        else if (auto v = eat("--trace"); !v.empty()) opt.tracePath = v;
         else if (auto v = eat("--seed"); !v.empty()) { int s; if (parseStrictNonNegInt(v, s)) opt.seed = (unsigned)s; }
         else if (auto v = eat("--csv"); !v.empty()) opt.csvPath = v;
-        else if (auto v = eat("--mode"); !v.empty()) opt.mode = v; // serial|parallel|both
+        else if (auto v = eat("--mode"); !v.empty()) opt.mode = v; // serial|parallel|tiled|both|all
+        else if (auto v = eat("--engine"); !v.empty()) opt.engines = parseEngineList(v);
+        else if (auto v = eat("--renderer"); !v.empty()) {
+            if (v == "accelerated" || v == "software") opt.renderer = v;
+            else std::cerr << "[Advertencia] --renderer debe ser accelerated|software, se usará "
+                           << opt.renderer << ".\n";
+        }
+        else if (auto v = eat("--fps"); !v.empty()) parseStrictNonNegInt(v, opt.maxFps);
+        else if (auto v = eat("--sim-hz"); !v.empty()) parseStrictNonNegInt(v, opt.simHz);
+        else if (a == "--low-power") { if (opt.frameBudget <= 0.f) opt.frameBudget = 8.f; }
+        else if (auto v = eat("--frame-budget"); !v.empty()) {
+            if (!parseFloatList(v, &opt.frameBudget, 1))
+                std::cerr << "[Advertencia] Valor inválido para --frame-budget: \"" << v
+                          << "\", se usará " << opt.frameBudget << ".\n";
+        }
+        else if (auto v = eat("--max-steps"); !v.empty()) parseStrictNonNegInt(v, opt.maxSimSteps);
+        else if (auto v = eat("--neighbors"); !v.empty()) {
+            // Older spelling of --engine grid | --engine parallel
+            if (v == "grid")       opt.engines = {"grid"};
+            else if (v == "brute") opt.engines = {"parallel"};
+            else std::cerr << "[Advertencia] --neighbors debe ser grid|brute, se ignora.\n";
+        }
+        else if (auto v = eat("--simd"); !v.empty()) {
+            if (v == "auto") opt.simd = detectSimdLevel();
+            else if (!parseSimdLevel(v.c_str(), opt.simd))
+                std::cerr << "[Advertencia] --simd debe ser auto|scalar|avx2|avx512|neon, se usará "
+                          << simdLevelName(opt.simd) << ".\n";
+        }
         // Print help message
         else if (a == "-?" || a == "--help") {
             std::cout << "Uso: flocking [num_boids] [opciones]\n";
@@ -280,16 +459,68 @@ static CLI_Options parseArgs(int argc, char** argv) {
             std::cout << "  --width W       Ancho de ventana\n";
             std::cout << "  --height H      Alto de ventana\n";
             std::cout << "  --boids B       Número de boids\n";
+            std::cout << "  --max-boids M   Presupuesto de boids: cantidad o bytes (64MB, 1GB; default " << DEFAULT_MAX_BOIDS << ")\n";
+            std::cout << "  --predators N   Agrega N depredadores (otra especie) de los que huyen los boids\n";
+            std::cout << "  --weights W     Pesos sep,ali,coh,bias (default 1.5,1,1,0.8)\n";
+            std::cout << "  --rules R       Reglas activas: lista de sep,ali,coh,bias | all | none (default all)\n";
             std::cout << "  --no-gui        Sin overlay GUI\n";
-            std::cout << "  --serial        Forzar modo serial (sin OpenMP)\n";
+            std::cout << "  --serial        Forzar modo serial (igual que --engine serial)\n";
             std::cout << "  --trails        Mostrar estelas\n";
+            std::cout << "  --engine E      Motor de simulación: " << engineNames() << " (default grid)\n";
+            std::cout << "                  En --bench acepta una lista: --engine serial,grid,tiled\n";
+            std::cout << "  --renderer R    Renderer: accelerated (GPU + vsync) | software\n";
+            std::cout << "  --fps F         Límite de FPS sin vsync (default 60, 0 = sin límite)\n";
+            std::cout << "  --pipeline      Simulación en un hilo aparte, solapada con el render\n";
+            std::cout << "  --sim-hz H      Pasos de simulación por segundo (default 60)\n";
+            std::cout << "  --max-steps K   Máximo de pasos por frame renderizado (default 5)\n";
+            std::cout << "  --low-power     Modo de bajo consumo: con frames sobre el presupuesto baja el detalle de los boids,\n";
+            std::cout << "                  la frecuencia de simulación y los hilos (y los recupera con margen); con la ventana\n";
+            std::cout << "                  oculta o minimizada no simula ni dibuja, y los hilos OpenMP esperan dormidos\n";
+            std::cout << "  --frame-budget MS  Presupuesto de trabajo por frame del modo de bajo consumo (default 8, lo activa)\n";
+            std::cout << "  --neighbors N   Búsqueda de vecinos: grid | brute (alias de --engine)\n";
+            std::cout << "  --bench         Benchmark sin ventana (--frames, --trials, --warmup, --threads, --csv, --json)\n";
+            std::cout << "                  --boids y --threads aceptan listas: --boids 500,1000 --threads 1,2,4\n";
+            std::cout << "  --mode M        Benchmark sin --engine: serial | parallel | tiled | both | all\n";
+            std::cout << "  --schedule S    Reparto de boids entre hilos: static | dynamic | guided | steal (default static)\n";
+            std::cout << "                  steal: rangos de celdas pesados por ocupación^2 con robo de trabajo (motor grid)\n";
+            std::cout << "                  En --bench acepta una lista: --schedule static,steal\n";
+            std::cout << "  --sort-interval N  Reordena los boids en memoria por curva de Morton cada N pasos (default 8, 0 = nunca)\n";
+            std::cout << "  --theta T       Ángulo de apertura del motor quadtree (default 0.5, 0 = exacto); con --verify\n";
+            std::cout << "                  informa también el error de un paso frente al primer motor\n";
+            std::cout << "  --bind B        OMP_PROC_BIND: close | spread | master | primary | true | false\n";
+            std::cout << "  --places P      OMP_PLACES: threads | cores | sockets | ll_caches | numa_domains | {0:4},{4:4}\n";
+            std::cout << "  --numa          Modo NUMA: hilos fijos (default --bind close --places cores), schedule static\n";
+            std::cout << "                  y el mundo en franjas de celdas, una por hilo, en las páginas que ese hilo ubicó\n";
+            std::cout << "  --render-out D  Render sin ventana de --frames frames: PNG en el directorio D, o - para RGBA crudo a stdout\n";
+            std::cout << "                  (ej: --render-out - --frames 600 | ffmpeg -f rawvideo -pix_fmt rgba -s 1280x720 -i - out.mp4)\n";
+            std::cout << "  --headless      Simula --frames pasos sin ventana ni render (para --record)\n";
+            std::cout << "  --record F      Graba cada paso en F (.flk: 16 bits cuantizado, deltas entre key frames)\n";
+            std::cout << "  --keyframe-interval K  Frames entre key frames de --record (default 60)\n";
+            std::cout << "  --record-keyframes-only  Graba sin deltas (solo key frames)\n";
+            std::cout << "  --replay F      Reproduce una grabación .flk (mapeada en memoria) sin simular\n";
+            std::cout << "  --distributed   Con mpirun: una franja de --width x --height por rank, --boids por rank\n";
+            std::cout << "                  (--frames pasos sin ventana; con --bench, escalado débil de 1 a N ranks)\n";
+            std::cout << "  --verify        Compara motores paso a paso desde la misma semilla (--engine serial,grid, --frames)\n";
+            std::cout << "  --tolerance T   Divergencia máxima de posición en píxeles para --verify (default 0.5)\n";
+            std::cout << "  --save-states F Guarda la trayectoria del primer motor de --verify (snapshot binario)\n";
+            std::cout << "  --load-states F Compara --verify contra una trayectoria guardada (snapshot o .flk) en vez de un segundo motor\n";
+            std::cout << "  --seed S        Semilla del estado inicial (default 12345, igual con cualquier número de hilos)\n";
+            std::cout << "  --trace F       Guarda fases por hilo como Chrome trace JSON al salir\n";
+            std::cout << "  --simd S        Kernel de vecinos: auto | scalar | avx2 | avx512 | neon\n";
             std::cout << "Ejemplo: flocking 500 --width 1920 --height 1080 --trails\n";
             std::exit(0);
         }
         if (opt.numBoids < MIN_BOIDS) opt.numBoids = MIN_BOIDS;
-        if (opt.numBoids > MAX_BOIDS) opt.numBoids = MAX_BOIDS;
     }
 
+    // The budget may come after --boids, so clamp once every flag is read
+    if (opt.numBoids > opt.maxBoids) {
+        std::cerr << "[Advertencia] " << opt.numBoids << " boids superan --max-boids " << opt.maxBoids
+                  << ", se usarán " << opt.maxBoids << ".\n";
+        opt.numBoids = opt.maxBoids;
+    }
+    for (int& b : opt.benchBoids) b = std::min(b, opt.maxBoids);
+
     return opt;
 }
 
@@ -309,700 +540,815 @@ static int askInt(const std::string& prompt, int minVal, int fallback) {
 }
 
 // ==========================
-// FLOCK SYSTEM
+// Benchmark
 // ==========================
 
-class Bird {
-
-public:
-    Vector2D position;
-    Vector2D velocity;
-    Vector2D acceleration;
-    
-    float r;            // Size
-    float maxSpeed;     // Maximum speed
-    float maxForce;     // Maximum steering force
-    
-    // Flocking parameters
-    float separationRadius;
-    float alignmentRadius;
-    float cohesionRadius;
-    
-    // Visual properties
-    Uint8 red, green, blue, alpha;
+#include <fstream>
+#include <random>
 
-public:
-        Bird(float x, float y) {
-            position = Vector2D(x, y);
-            
-            // Random initial velocity
-            float angle = static_cast<float>(rand()) / RAND_MAX * TWO_PI;
-            velocity = Vector2D::fromAngle(angle) * 2.0f;
+// Ejecuta frames de update y devuelve tiempo total en microsegundos
+// engine: cualquier nombre registrado (ver engineNames())
+// frameUs (opcional): recibe la latencia de cada frame en microsegundos
+static long long run_simulation_once(const std::string& engine, SimdLevel simd, int frames, int width, int height, int numBoids, unsigned seed,
+                                     const FlockParams& params, LoopSchedule schedule, int sortInterval, SortOrder sortOrder,
+                                     float theta, std::vector<float>* frameUs = nullptr, perfCounters::CacheCounts* cache = nullptr) {
+    FlockingSystem flock(width, height);
+    flock.setCapacity(numBoids);
+    flock.setSchedule(schedule);
+    flock.setSortInterval(sortInterval);
+    flock.setSortOrder(sortOrder);
+    flock.setTheta(theta);
+    // Semilla fija por corrida: el estado inicial no depende del número de hilos
+    flock.setSeed(seed);
+    flock.setEngine(engine);
+    flock.setSimdLevel(simd);
+    flock.setFlockParams(0, params);
+    flock.initializeBirds(numBoids);
 
-            acceleration = Vector2D(0, 0);
-            
-            r = 4.0f;
-            maxSpeed = 2.0f;
-            maxForce = 0.03f;
-
-            // Flock parameter initalization
-            // Same for all birds
-            separationRadius = 25.0f;
-            alignmentRadius = 50.0f;
-            cohesionRadius = 50.0f;
-            
-            // Random color with bird-like hues
-            red = 150 + rand() % 105;    // 150-255
-            green = 100 + rand() % 100;  // 100-200
-            blue = 50 + rand() % 100;    // 50-150
-            alpha = 255;
+    using clock = std::chrono::steady_clock;
+    const perfCounters::CacheCounts cache0 = perfCounters::read();
+    auto t0 = clock::now();
+    auto prev = t0;
+    for (int f = 0; f < frames; ++f) {
+        flock.update();
+        // No es necesario mover gato ni render, para medir cómputo puro
+        if (frameUs) {
+            auto now = clock::now();
+            frameUs->push_back(std::chrono::duration<float, std::micro>(now - prev).count());
+            prev = now;
         }
+    }
+    auto t1 = clock::now();
+    if (cache) *cache = perfCounters::read() - cache0;
+    return std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+}
 
-        // Sets the Bird new position based on current accelaration, velocity and current coordinates.
-        void update() {
-            // Update velocity
-            velocity += acceleration;
-            velocity.limit(maxSpeed);
-            position += velocity;
-            
-            // Reset acceleration
-            acceleration *= 0;
-        }
+// Engines measured: the --engine list if given, otherwise derived from --mode
+static std::vector<std::string> bench_engines(const CLI_Options& opt) {
+    if (!opt.engines.empty()) return opt.engines;
+    const std::string& mode = opt.mode;
+    if (mode == "both") return {"serial", "parallel"};
+    if (mode == "all") {
+        std::vector<std::string> all;
+        for (const auto& e : engineRegistry()) all.push_back(e.name);
+        return all;
+    }
+    if (mode == "serial" || mode == "parallel" || mode == "tiled") return {mode};
+    std::cerr << "[Advertencia] --mode desconocido \"" << mode << "\", se usará both.\n";
+    return {"serial", "parallel"};
+}
 
-        // Update Bird current fields based on flock model ecuations.
-        void flock(const std::vector<Bird>& birds, int windowWidth, int windowHeight) {
-            Vector2D sep = separate(birds);
-            Vector2D ali = align(birds);
-            Vector2D coh = cohesion(birds);
-            Vector2D bias = environmentalBias(windowWidth, windowHeight);
-            
-            // Weight the forces
-            sep *= 1.5f;   // Avoid collisions (highest priority)
-            ali *= 1.0f;   // Match neighbors
-            coh *= 1.0f;   // Stay together
-            bias *= 0.8f;  // Environmental preference
-            
-            // Apply forces
-            applyForce(sep);
-            applyForce(ali);
-            applyForce(coh);
-            applyForce(bias);
-        }
+// Nearest-rank percentile (q in 0..1) of an already sorted sample
+static double percentile(const std::vector<float>& sorted, double q) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = (size_t)std::ceil(q * sorted.size());
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
 
-        void applyForce(const Vector2D& force) {
-            acceleration += force;
-        }
+// One (engine, boids, threads) cell of the sweep
+struct BenchPoint {
+    std::string engine;
+    const char* simd;
+    LoopSchedule schedule;
+    int boids, threads;
+    std::vector<long long> trialUs;  // total per measured trial
+    double mean = 0, sd = 0;         // over trials
+    double p50 = 0, p95 = 0, p99 = 0; // per-frame latency over all measured frames
+    double missesPerStep = -1, l1dMissesPerStep = -1; // cache misses over all measured frames (< 0 = no counters)
+};
 
-        // A method that calculates and applies a steering force towards a target
-        // STEER = DESIRED MINUS VELOCITY
-        Vector2D seek(const Vector2D& target) {
-            Vector2D desired = target - position;
-            desired.normalize();
-            desired *= maxSpeed;
-            
-            Vector2D steer = desired - velocity;
-            steer.limit(maxForce);
-            return steer;
-        }
+struct ScalingRow {
+    std::string engine;
+    LoopSchedule schedule;
+    int boids, threads;
+    double mean, speedup, efficiency;
+};
 
+// Default JSON path: the CSV path with a .json extension
+static std::string bench_json_path(const CLI_Options& opt) {
+    if (!opt.jsonPath.empty()) return opt.jsonPath;
+    if (opt.csvPath.empty()) return "";
+    std::string path = opt.csvPath;
+    const size_t dot = path.find_last_of('.');
+    const size_t slash = path.find_last_of("/\\");
+    if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) path.erase(dot);
+    return path + ".json";
+}
 
-        // A given unit attempts to move away from neighbors who are too close.
-        Vector2D separate(const std::vector<Bird>& birds) {
-            Vector2D steer(0, 0);
-            int count = 0;
-            
-            for (const auto& other : birds) {
-                float d = Vector2D::distance(position, other.position);
-                if (d > 0 && d < separationRadius) {
-                    Vector2D diff = position - other.position;
-                    diff.normalize();
-                    diff /= d; // Weight by distance
-                    steer += diff;
-                    count++;
-                }
-            }
-            
-            if (count > 0) {
-                steer /= static_cast<float>(count);
-                
-                if (steer.magnitude() > 0) {
-                    steer.normalize();
-                    steer *= maxSpeed;
-                    steer -= velocity;
-                    steer.limit(maxForce);
-                }
-            }
-            
-            return steer;
-        }
+static void run_benchmark(const CLI_Options& opt) {
+    const int W = (opt.width  > 0 ? opt.width  : 1280);
+    const int H = (opt.height > 0 ? opt.height : 720);
 
-        // A given unit attempts to move to the center of mass of its neighbors.
-        Vector2D cohesion(const std::vector<Bird>& birds) {
-            Vector2D sum(0, 0);
-            int count = 0;
-            
-            for (const auto& other : birds) {
-                float d = Vector2D::distance(position, other.position);
-                if (d > 0 && d < cohesionRadius) {
-                    sum += other.position;
-                    count++;
-                }
-            }
-            
-            if (count > 0) {
-                sum /= static_cast<float>(count);
-                return seek(sum);
-            }
-            
-            return Vector2D(0, 0);
-        }
-    
+    // Sweep axes (single values unless lists were given)
+    const std::vector<std::string> engines = bench_engines(opt);
+    const std::vector<int> boidsList = opt.benchBoids.empty() ? std::vector<int>{opt.numBoids} : opt.benchBoids;
+    const std::vector<int> threadsList = opt.benchThreads.empty()
+        ? std::vector<int>{opt.threads > 0 ? opt.threads : omp_get_max_threads()}
+        : opt.benchThreads;
+    const std::vector<LoopSchedule> schedules = opt.benchSchedules.empty()
+        ? std::vector<LoopSchedule>{opt.schedule} : opt.benchSchedules;
 
-        // A given unit attempts to face the same direction as its neighbors.
-        Vector2D align(const std::vector<Bird>& birds) {
-            Vector2D sum(0, 0);
-            int count = 0;
-            
-            for (const auto& other : birds) {
-                float d = Vector2D::distance(position, other.position);
-                if (d > 0 && d < alignmentRadius) {
-                    sum += other.velocity;
-                    count++;
-                }
-            }
-            
-            if (count > 0) {
-                sum /= static_cast<float>(count);
-                sum.normalize();
-                sum *= maxSpeed;
-                
-                Vector2D steer = sum - velocity;
-                steer.limit(maxForce);
-                return steer;
-            }
-            
-            return Vector2D(0, 0);
-        }
+    // CSV
+    std::ofstream csv;
+    if (!opt.csvPath.empty()) {
+        csv.open(opt.csvPath);
+    }
+    auto& out = opt.csvPath.empty() ? std::cout : csv;
 
-        // Environmental bias - encourages rightward flight in upper half
-        Vector2D environmentalBias(int windowWidth, int windowHeight) {
-            Vector2D bias(0, 0);
-            
-            // Encourage rightward movement (like migrating birds)
-            bias.x = 0.5f;
-            
-            // Encourage staying in upper half of screen
-            float upperHalf = windowHeight * 0.3f;
-            if (position.y > upperHalf) {
-                // If in lower half, add upward bias
-                float distanceFromTop = (position.y - upperHalf) / upperHalf;
-                bias.y = -distanceFromTop * 0.8f;  // Stronger bias the lower you are
-            } else {
-                // If in upper half, slight downward bias to prevent clustering at top
-                bias.y = 0.15f;
-            }
-            
-            // Scale bias based on distance from ideal "flight corridor"
-            float idealY = windowHeight * 0.2f;  // Prefer flying at 30% from top
-            float distanceFromIdeal = abs(position.y - idealY) / (windowHeight * 0.5f);
-            
-            Vector2D steer = bias;
-            steer.normalize();
-            steer *= maxSpeed * (0.3f + distanceFromIdeal * 0.5f);  // Stronger when far from ideal
-            steer -= velocity;
-            steer.limit(maxForce * 0.5f);  // Gentler than other forces
-            
-            return steer;
-        }
+    out << "engine,simd,schedule,boids,frames,trials,threads,seed,trial_idx,usec,p50_us,p95_us,p99_us,"
+           "llc_miss_per_step,l1d_miss_per_step\n";
+    // Cache columns stay empty without hardware counters
+    const bool counters = perfCounters::available();
+    if (!counters)
+        std::cerr << "[bench] Sin contadores de caché (perf_event_open no disponible; revisa kernel.perf_event_paranoid)\n";
+
+    // Kernel actually used (requested level may be unsupported on this CPU)
+    SimdLevel selectedSimd;
+    selectNeighborKernel(opt.simd, &selectedSimd);
+
+    // Engines with their own pair loop always run scalar math
+    auto engine_simd = [&](const std::string& e) {
+        auto engine = createEngine(e);
+        return engine && engine->usesKernel() ? simdLevelName(selectedSimd) : "scalar";
+    };
 
-        // Behaviour when birds touch the borders: just draw on the opposite section of the window.
-        void borders(int width, int height) {
-            if (position.x < -r) position.x = width + r;
-            if (position.y < -r) position.y = height + r;
-            if (position.x > width + r) position.x = -r;
-            if (position.y > height + r) position.y = -r;
-        }
+    auto join = [](const auto& v) {
+        std::ostringstream ss;
+        for (size_t k = 0; k < v.size(); ++k) ss << (k ? "," : "") << v[k];
+        return ss.str();
+    };
 
-        // Draws the birds onto window , based on current fields.
-        void render(SDL_Renderer* renderer, bool dark) const {
-            // Draw boid as triangle pointing in direction of velocity
-            float theta = velocity.heading() + PI / 2;
-            
-            Vector2D v1(0, -r * 2);
-            Vector2D v2(-r, r * 2);
-            Vector2D v3(r, r * 2);
-            
-            // Rotate vertices
-            float cosTheta = cos(theta);
-            float sinTheta = sin(theta);
-            
-            auto rotate = [cosTheta, sinTheta](Vector2D& v) {
-                float newX = v.x * cosTheta - v.y * sinTheta;
-                float newY = v.x * sinTheta + v.y * cosTheta;
-                v.x = newX;
-                v.y = newY;
-            };
-            
-            rotate(v1);
-            rotate(v2);
-            rotate(v3);
-            
-            // Translate to position
-            v1 += position;
-            v2 += position;
-            v3 += position;
-
-            Uint8 R = red, G = green, B = blue, A = alpha;
-            if (dark) {
-                R = (Uint8)(R * 0.35f);
-                G = (Uint8)(G * 0.35f);
-                B = (Uint8)(B * 0.45f);
-                SDL_SetRenderDrawColor(renderer, R, G, B, A);
-            } else {
-                // Draw filled triangle (approximate with lines)
-                SDL_SetRenderDrawColor(renderer, red, green, blue, alpha);
-            }
-            
-            // Draw triangle outline
-            SDL_RenderDrawLine(renderer, static_cast<int>(v1.x), static_cast<int>(v1.y),
-                              static_cast<int>(v2.x), static_cast<int>(v2.y));
-            SDL_RenderDrawLine(renderer, static_cast<int>(v2.x), static_cast<int>(v2.y),
-                              static_cast<int>(v3.x), static_cast<int>(v3.y));
-            SDL_RenderDrawLine(renderer, static_cast<int>(v3.x), static_cast<int>(v3.y),
-                              static_cast<int>(v1.x), static_cast<int>(v1.y));
-            
-            // Fill triangle with additional lines
-            for (int i = 1; i <= 3; i++) {
-                Vector2D p1 = v1 + (v2 - v1) * (i / 4.0f);
-                Vector2D p2 = v1 + (v3 - v1) * (i / 4.0f);
-                SDL_RenderDrawLine(renderer, static_cast<int>(p1.x), static_cast<int>(p1.y),
-                                  static_cast<int>(p2.x), static_cast<int>(p2.y));
-            }
-        }
-};
+    std::vector<const char*> scheduleNames;
+    for (LoopSchedule sched : schedules) scheduleNames.push_back(scheduleName(sched));
 
-// Entity responsable for managing a group of birds
-class FlockingSystem {
-private:
-    std::vector<Bird> birds;
-    int windowWidth, windowHeight;
-    
-public:
-    FlockingSystem(int width, int height) : windowWidth(width), windowHeight(height) {}
-    
-    void addBoid(float x, float y) {
-        birds.emplace_back(x, y);
-    }
-    
-    void initializeBirds(int numBirds) {
-        birds.clear();
-        birds.reserve(numBirds);
-        
-        for (int i = 0; i < numBirds; i++) {
-            float x = static_cast<float>(rand()) / RAND_MAX * windowWidth;
-            float y = static_cast<float>(rand()) / RAND_MAX * windowHeight;
-            addBoid(x, y);
-        }
-    }
-    
-    // Serial version - each boid processes neighbors sequentially
-    void updateSerial() {
-        for (auto& bird : birds) {
-            bird.flock(birds, windowWidth, windowHeight);
-        }
-        
-        for (auto& boid : birds) {
-            boid.update();
-            boid.borders(windowWidth, windowHeight);
-        }
-    }
-    
-    // Serial version - each boid processes neighbors 
-    void updateParallel() {
-        const size_t n = birds.size();
-        if (n == 0) return;
-
-        // SoA snapshot to improve locality and avoid false sharing
-
-        // (b) Optimización de estructuras de datos (SoA):
-        //     Se crea un *snapshot* en arreglos contiguos px/py/vx/vy (Structure of Arrays).
-        //     Razón: mejora la localidad de caché y facilita la vectorización del loop de vecinos,
-        //             separando lectura (SoA) de escritura (ax/ay/birds), lo que reduce contención.
-
-
-        std::vector<float> px(n), py(n), vx(n), vy(n);
-        #pragma omp parallel for schedule(static)
-        for (size_t i = 0; i < n; ++i) {
-            px[i] = birds[i].position.x;
-            py[i] = birds[i].position.y;
-            vx[i] = birds[i].velocity.x;
-            vy[i] = birds[i].velocity.y;
-        }
+    const size_t totalPoints = engines.size() * schedules.size() * boidsList.size() * threadsList.size();
+    std::cerr << "[bench] " << totalPoints << " puntos (engines=" << join(engines)
+              << ", schedules=" << join(scheduleNames) << ", sort-interval=" << opt.sortInterval
+              << ", boids=" << join(boidsList) << ", threads=" << join(threadsList)
+              << ", simd=" << simdLevelName(selectedSimd)
+              << ", warmup=" << opt.warmup << ", trials=" << opt.trials
+              << ", frames=" << opt.frames << ")\n";
 
-        // Buffer for accelerations
-
-        // (c) Optimización de acceso a memoria compartida:
-        //     Buffers temporales de aceleración (ax/ay) por boid. Cada hilo escribe solo su índice,
-        //     evitando *data races* y *false sharing*. La escritura al objeto compartido birds[i]
-        //     se difiere a la fase de integración.
-
-        std::vector<float> ax(n, 0.0f), ay(n, 0.0f);
-
-        // If all of the boids share the same radiius, caches squared radius
-
-        // (b) Optimización de estructuras de datos:
-        //     Cacheo de radios^2 para comparar d2 < R^2 y evitar sqrt en el test de vecindad.
-        //     Esto reduce operaciones costosas dentro del bucle más caliente.
-
-        const float sepR2 = birds[0].separationRadius * birds[0].separationRadius;
-        const float aliR2 = birds[0].alignmentRadius  * birds[0].alignmentRadius;
-        const float cohR2 = birds[0].cohesionRadius   * birds[0].cohesionRadius;
-
-        // Calculate forces in parallel with SoA access
-        #pragma omp parallel for schedule(static)
-        for (size_t i = 0; i < n; ++i) {
-            const float pix = px[i], piy = py[i];
-            const float vix = vx[i], viy = vy[i];
-            float sep_x = 0.f, sep_y = 0.f; int sep_c = 0;
-            float ali_x = 0.f, ali_y = 0.f; int ali_c = 0;
-            float coh_x = 0.f, coh_y = 0.f; int coh_c = 0;
-
-            // Neighboors: vectorizable with simd
-
-            // (a) Directivas/cláusulas OpenMP no vistas en la intro:
-            //     Uso de `#pragma omp simd` con múltiples `reduction(+: ...)` para vectorizar el
-            //     bucle de vecinos (índice j). Razón: explota SIMD/ILP, acumula en registros
-            //     vectoriales sin locks/atómicas, elevando el throughput del O(n^2).
-
-            #pragma omp simd reduction(+:sep_x, sep_y, sep_c, ali_x, ali_y, ali_c, coh_x, coh_y, coh_c)
-            for (size_t j = 0; j < n; ++j) {
-                const float dx = pix - px[j];
-                const float dy = piy - py[j];
-                const float d2 = dx*dx + dy*dy;
-
-                if (d2 > 0.f) {
-                    if (d2 < sepR2) {
-                        // diff.normalize(); diff/=d  -> invsqrt * inv (equals a /d)
-                        const float invd = 1.0f / std::sqrt(d2);
-                        sep_x += dx * invd * invd;
-                        sep_y += dy * invd * invd;
-                        sep_c++;
-                    }
-                    if (d2 < aliR2) {
-                        ali_x += vx[j];
-                        ali_y += vy[j];
-                        ali_c++;
+    auto stats = [](const std::vector<long long>& v) {
+        long double sum = 0.0L; for (auto x : v) sum += x;
+        long double mean = sum / v.size();
+        long double var = 0.0L; for (auto x : v) { long double d = x - mean; var += d*d; }
+        var /= (v.size() > 1 ? (v.size() - 1) : 1);
+        long double sd = std::sqrt(var);
+        return std::pair<long double,long double>(mean, sd);
+    };
+
+    // Thread placement of every thread count of the sweep, as the runtime applied it
+    const SortOrder sortOrder = opt.numa ? SortOrder::Bands : SortOrder::Morton;
+    std::vector<std::pair<int, std::string>> placements;
+    for (int threads : threadsList) {
+        if (std::any_of(placements.begin(), placements.end(), [&](const auto& p) { return p.first == threads; })) continue;
+        placements.emplace_back(threads, numa::describePlacement(threads));
+        std::cerr << "[bench] threads=" << threads << " " << placements.back().second << "\n";
+    }
+    if (opt.numa)
+        std::cerr << "[bench] NUMA: first touch en reparto static, boids reordenados por franjas de celdas\n";
+
+    std::vector<BenchPoint> points;
+    points.reserve(totalPoints);
+    std::vector<float> frameUs, trialFrames;
+    const auto benchStart = std::chrono::steady_clock::now();
+
+    for (const auto& e : engines) {
+        for (LoopSchedule sched : schedules) {
+            for (int boids : boidsList) {
+                for (int threads : threadsList) {
+                    omp_set_num_threads(threads);
+
+                    BenchPoint pt{e, engine_simd(e), sched, boids, threads, {}};
+                    // Warmup trials: caches, page faults, thread pool start-up; discarded
+                    for (int w = 0; w < opt.warmup; ++w)
+                        run_simulation_once(e, opt.simd, opt.frames, W, H, boids, opt.seed + w, opt.flock, sched,
+                                            opt.sortInterval, sortOrder, opt.theta);
+
+                    frameUs.clear();
+                    frameUs.reserve((size_t)opt.trials * opt.frames);
+                    perfCounters::CacheCounts cacheTotal;
+                    for (int t = 0; t < opt.trials; ++t) {
+                        trialFrames.clear();
+                        perfCounters::CacheCounts cache;
+                        long long us = run_simulation_once(e, opt.simd, opt.frames, W, H, boids, opt.seed + t, opt.flock, sched,
+                                                           opt.sortInterval, sortOrder, opt.theta, &trialFrames, &cache);
+                        pt.trialUs.push_back(us);
+                        frameUs.insert(frameUs.end(), trialFrames.begin(), trialFrames.end());
+                        cacheTotal.misses += cache.misses;
+                        cacheTotal.l1dMisses += cache.l1dMisses;
+
+                        std::sort(trialFrames.begin(), trialFrames.end());
+                        out << e << "," << pt.simd << "," << scheduleName(sched)
+                            << "," << boids << "," << opt.frames << "," << opt.trials << ","
+                            << threads << "," << (opt.seed + t) << "," << (t+1) << "," << us << ","
+                            << percentile(trialFrames, 0.50) << "," << percentile(trialFrames, 0.95) << ","
+                            << percentile(trialFrames, 0.99) << ",";
+                        if (counters)
+                            out << (double)cache.misses / opt.frames << "," << (double)cache.l1dMisses / opt.frames;
+                        else
+                            out << ",";
+                        out << "\n";
                     }
-                    if (d2 < cohR2) {
-                        coh_x += px[j];
-                        coh_y += py[j];
-                        coh_c++;
+                    if (counters) {
+                        const double steps = (double)opt.trials * opt.frames;
+                        pt.missesPerStep = cacheTotal.misses / steps;
+                        pt.l1dMissesPerStep = cacheTotal.l1dMisses / steps;
                     }
-                }
-            }
 
-            // Combine into a local "acc" using fast limit version
-
-            // (d) Otra optimización algorítmica documentable:
-            //     `fast_limit`: limita por norma sin normalizaciones intermedias ni cálculos extra.
-            //     Razón: evita trabajo cuando el vector ya está bajo el umbral y usa una sola sqrt
-            //            en el caso de reescalado, reduciendo costo en la ruta crítica.
-
-            auto fast_limit = [](float& x, float& y, float maxMag) {
-                const float s2 = x*x + y*y;
-                const float m2 = maxMag * maxMag;
-                if (s2 > m2 && s2 > 0.f) {
-                    const float inv = maxMag / std::sqrt(s2);
-                    x *= inv; y *= inv;
-                }
-            };
-
-            float acc_x = 0.f, acc_y = 0.f;
-
-            // Separation (weight 1.5)
-            if (sep_c > 0) {
-                float sx = sep_x / sep_c, sy = sep_y / sep_c;
-                const float s2 = sx*sx + sy*sy;
-                if (s2 > 0.f) {
-                    const float inv = 1.0f / std::sqrt(s2);
-                    sx *= inv; sy *= inv;
-                    sx *= birds[i].maxSpeed; sy *= birds[i].maxSpeed;
-                    sx -= vix; sy -= viy;
-                    fast_limit(sx, sy, birds[i].maxForce);
-                    acc_x += 1.5f * sx;
-                    acc_y += 1.5f * sy;
+                    auto [mean, sd] = stats(pt.trialUs);
+                    pt.mean = (double)mean; pt.sd = (double)sd;
+                    std::sort(frameUs.begin(), frameUs.end());
+                    pt.p50 = percentile(frameUs, 0.50);
+                    pt.p95 = percentile(frameUs, 0.95);
+                    pt.p99 = percentile(frameUs, 0.99);
+                    points.push_back(std::move(pt));
+
+                    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - benchStart).count();
+                    std::cerr << "[bench] (" << points.size() << "/" << totalPoints << ") " << e
+                              << " schedule=" << scheduleName(sched)
+                              << " boids=" << boids << " threads=" << threads
+                              << " mean_us=" << (long long)points.back().mean
+                              << " p99_frame_us=" << (long long)points.back().p99
+                              << " | " << (long long)elapsed << " s\n";
                 }
             }
+        }
+    }
 
-            // Alignment 
-            if (ali_c > 0) {
-                float axm = ali_x / ali_c, aym = ali_y / ali_c;
-                const float s2 = axm*axm + aym*aym;
-                if (s2 > 0.f) {
-                    const float inv = 1.0f / std::sqrt(s2);
-                    axm *= inv; aym *= inv;
-                    axm *= birds[i].maxSpeed; aym *= birds[i].maxSpeed;
-                    axm -= vix; aym -= viy;
-                    fast_limit(axm, aym, birds[i].maxForce);
-                    acc_x += axm;
-                    acc_y += aym;
-                }
-            }
+    auto find_point = [&](const std::string& e, LoopSchedule sched, int boids, int threads) -> const BenchPoint* {
+        for (const auto& pt : points)
+            if (pt.engine == e && pt.schedule == sched && pt.boids == boids && pt.threads == threads) return &pt;
+        return nullptr;
+    };
 
-            // Cohesion 
-            if (coh_c > 0) {
-                const float tx = coh_x / coh_c, ty = coh_y / coh_c;
-                float dx = tx - pix, dy = ty - piy;
-                const float s2 = dx*dx + dy*dy;
-                if (s2 > 0.f) {
-                    const float inv = 1.0f / std::sqrt(s2);
-                    dx *= inv; dy *= inv;
-                    dx *= birds[i].maxSpeed; dy *= birds[i].maxSpeed;
-                    dx -= vix; dy -= viy;
-                    fast_limit(dx, dy, birds[i].maxForce);
-                    acc_x += dx;
-                    acc_y += dy;
-                }
-            }
+    // Speedups are relative to the serial engine with the same boids and threads when it was measured
+    out << "# summary\n";
+    for (const auto& pt : points) {
+        out << "# " << pt.engine << " schedule=" << scheduleName(pt.schedule)
+            << " boids=" << pt.boids << " threads=" << pt.threads
+            << " mean_us=" << (long long)pt.mean << " sd_us=" << (long long)pt.sd
+            << " p50_us=" << pt.p50 << " p95_us=" << pt.p95 << " p99_us=" << pt.p99;
+        if (pt.missesPerStep >= 0)
+            out << " llc_miss_per_step=" << (long long)pt.missesPerStep
+                << " l1d_miss_per_step=" << (long long)pt.l1dMissesPerStep;
+        const BenchPoint* ser = find_point("serial", pt.schedule, pt.boids, pt.threads);
+        if (ser && pt.engine != "serial" && pt.mean > 0) {
+            const double speedup = ser->mean / pt.mean;
+            out << " speedup=" << speedup << " efficiency=" << speedup / pt.threads;
+        }
+        out << "\n";
+    }
 
-            // Environmental bias
-            {
-                float bx = 0.5f, by;
-                const float upperHalf = windowHeight * 0.3f;
-                if (piy > upperHalf) {
-                    const float distanceFromTop = (piy - upperHalf) / upperHalf;
-                    by = -distanceFromTop * 0.8f;
-                } else {
-                    by = 0.15f;
-                }
-                const float idealY = windowHeight * 0.2f;
-                const float distanceFromIdeal = std::abs(piy - idealY) / (windowHeight * 0.5f);
-
-                // steer = norm(bias) * maxSpeed*(0.3 + d*0.5) - v
-                float bsx = bx, bsy = by;
-                const float b2 = bsx*bsx + bsy*bsy;
-                if (b2 > 0.f) {
-                    const float inv = 1.0f / std::sqrt(b2);
-                    bsx *= inv; bsy *= inv;
-                    const float speed = birds[i].maxSpeed * (0.3f + distanceFromIdeal * 0.5f);
-                    bsx *= speed; bsy *= speed;
-                    bsx -= vix;   bsy -= viy;
-                    fast_limit(bsx, bsy, birds[i].maxForce * 0.5f);
-                    acc_x += 0.8f * bsx;
-                    acc_y += 0.8f * bsy;
+    out << "# placement\n";
+    for (const auto& [threads, where] : placements) out << "# threads=" << threads << " " << where << "\n";
+
+    // Strong scaling: fixed boids, relative to the smallest thread count of the sweep
+    // Weak scaling: fixed boids per thread, boids = b0 * threads / t0 when that point exists
+    const int t0 = *std::min_element(threadsList.begin(), threadsList.end());
+    std::vector<ScalingRow> strong, weak;
+    for (const auto& e : engines) {
+        for (LoopSchedule sched : schedules) {
+            for (int boids : boidsList) {
+                const BenchPoint* base = find_point(e, sched, boids, t0);
+                if (!base || base->mean <= 0) continue;
+                for (int threads : threadsList) {
+                    if (const BenchPoint* pt = find_point(e, sched, boids, threads)) {
+                        const double s = base->mean / pt->mean;
+                        strong.push_back({e, sched, boids, threads, pt->mean, s, s * t0 / threads});
+                    }
+                    if ((long long)boids * threads % t0 != 0) continue;
+                    const int scaled = (int)((long long)boids * threads / t0);
+                    if (const BenchPoint* pt = find_point(e, sched, scaled, threads))
+                        weak.push_back({e, sched, boids, threads, pt->mean, base->mean / pt->mean, base->mean / pt->mean});
                 }
             }
-
-            ax[i] = acc_x;
-            ay[i] = acc_y;
         }
+    }
 
-        // Parallel integration (only one operation per bird)
+    if (threadsList.size() > 1) {
+        out << "# strong scaling (vs threads=" << t0 << ")\n";
+        for (const auto& r : strong)
+            out << "# " << r.engine << " schedule=" << scheduleName(r.schedule)
+                << " boids=" << r.boids << " threads=" << r.threads
+                << " mean_us=" << (long long)r.mean << " speedup=" << r.speedup
+                << " efficiency=" << r.efficiency << "\n";
+        out << "# weak scaling (boids/thread fixed, base threads=" << t0 << ")\n";
+        for (const auto& r : weak)
+            out << "# " << r.engine << " schedule=" << scheduleName(r.schedule) << " base_boids=" << r.boids
+                << " threads=" << r.threads << " boids=" << (long long)r.boids * r.threads / t0
+                << " mean_us=" << (long long)r.mean << " efficiency=" << r.efficiency << "\n";
+    }
 
-        // (c) Optimización de acceso a memoria compartida:
-        //     Fase 2 (integración): patrón write-once, secuencial por boid.
-        //     Razón: consolidar las escrituras en una sola pasada minimiza contención,
-        //            mejora la localidad y reduce *false sharing* en caché.
+    if (&out == &std::cout) std::cout << std::flush;
 
-        #pragma omp parallel for schedule(static)
-        for (size_t i = 0; i < n; ++i) {
-            birds[i].acceleration.x += ax[i];
-            birds[i].acceleration.y += ay[i];
-            birds[i].update();
-            birds[i].borders(windowWidth, windowHeight);
-        }
+    if (!opt.csvPath.empty()) {
+        std::cerr << "[bench] Resultados escritos en: " << opt.csvPath << "\n";
     }
 
-    // Renders all the birds in the system
-    void render(SDL_Renderer* renderer, bool darkBoids) {
-        for (const auto& bird : birds) {
-            bird.render(renderer, darkBoids);
-        }
-    }
-    
-    // handle window resize
-    void resize(int width, int height) {
-        windowWidth = width;
-        windowHeight = height;
+    // Machine-readable copy of everything above
+    const std::string jsonPath = bench_json_path(opt);
+    if (jsonPath.empty()) return;
+    std::ofstream json(jsonPath);
+    if (!json) {
+        std::cerr << "[Error] No se pudo abrir " << jsonPath << "\n";
+        return;
     }
-    
-    // Returns the current number of boids
-    size_t getBoidCount() const { return birds.size(); }
-    
-    // Add or remove boids to reach target count
-    void addBoids(int count) {
-        if (count <= 0) return;
-        const int canAdd = std::min(count, std::max(0, MAX_BOIDS - (int)birds.size()));
-        for (int i = 0; i < canAdd; i++) {
-            float x = static_cast<float>(rand()) / RAND_MAX * windowWidth;
-            float y = static_cast<float>(rand()) / RAND_MAX * windowHeight;
-            addBoid(x, y);
-        }
+    json << "{\n  \"config\": {\"width\": " << W << ", \"height\": " << H
+         << ", \"frames\": " << opt.frames << ", \"trials\": " << opt.trials
+         << ", \"warmup\": " << opt.warmup << ", \"seed\": " << opt.seed
+         << ", \"sort_interval\": " << opt.sortInterval << ", \"theta\": " << opt.theta << ", \"numa\": " << (opt.numa ? "true" : "false")
+         << ", \"simd\": \"" << simdLevelName(selectedSimd) << "\"},\n";
+    json << "  \"points\": [";
+    for (size_t k = 0; k < points.size(); ++k) {
+        const auto& pt = points[k];
+        json << (k ? ",\n" : "\n") << "    {\"engine\": \"" << pt.engine << "\", \"simd\": \"" << pt.simd
+             << "\", \"schedule\": \"" << scheduleName(pt.schedule)
+             << "\", \"boids\": " << pt.boids << ", \"threads\": " << pt.threads
+             << ", \"mean_us\": " << pt.mean << ", \"sd_us\": " << pt.sd
+             << ", \"frame_p50_us\": " << pt.p50 << ", \"frame_p95_us\": " << pt.p95
+             << ", \"frame_p99_us\": " << pt.p99;
+        if (pt.missesPerStep >= 0)
+            json << ", \"llc_miss_per_step\": " << pt.missesPerStep
+                 << ", \"l1d_miss_per_step\": " << pt.l1dMissesPerStep;
+        json << ", \"trials_us\": [" << join(pt.trialUs) << "]}";
     }
-
-    // Remove boids from the end of the list, keeping at least MIN_BOIDS
-    void removeBoids(int count) {
-        if (count <= 0 || birds.empty()) return;
-        const int remove = std::min(count, (int)birds.size() - MIN_BOIDS);
-        if (remove <= 0) return;
-        birds.erase(birds.end() - remove, birds.end());
+    json << "\n  ],\n  \"placement\": [";
+    for (size_t k = 0; k < placements.size(); ++k)
+        json << (k ? ",\n" : "\n") << "    {\"threads\": " << placements[k].first
+             << ", \"where\": \"" << placements[k].second << "\"}";
+    json << "\n  ],\n  \"strong_scaling\": [";
+    for (size_t k = 0; k < strong.size(); ++k) {
+        const auto& r = strong[k];
+        json << (k ? ",\n" : "\n") << "    {\"engine\": \"" << r.engine
+             << "\", \"schedule\": \"" << scheduleName(r.schedule) << "\", \"boids\": " << r.boids
+             << ", \"threads\": " << r.threads << ", \"mean_us\": " << r.mean
+             << ", \"speedup\": " << r.speedup << ", \"efficiency\": " << r.efficiency << "}";
     }
-
-    // Calculate average velocity magnitude for stats
-    float getAverageSpeed() const {
-        if (birds.empty()) return 0.0f;
-        double total = 0.0;
-        #pragma omp parallel for reduction(+:total) schedule(static)
-        for (size_t i = 0; i < birds.size(); ++i)
-            total += birds[i].velocity.magnitude();
-        return static_cast<float>(total / birds.size());
+    json << "\n  ],\n  \"weak_scaling\": [";
+    for (size_t k = 0; k < weak.size(); ++k) {
+        const auto& r = weak[k];
+        json << (k ? ",\n" : "\n") << "    {\"engine\": \"" << r.engine
+             << "\", \"schedule\": \"" << scheduleName(r.schedule) << "\", \"base_boids\": " << r.boids
+             << ", \"boids\": " << (long long)r.boids * r.threads / t0 << ", \"threads\": " << r.threads
+             << ", \"mean_us\": " << r.mean << ", \"efficiency\": " << r.efficiency << "}";
     }
-    
-    // Calculate flock coherence (how tightly grouped they are)
-    float getCoherence() const {
-        const size_t n = birds.size();
-        if (n < 2) return 0.0f;
-
-        // Center
-        double cx = 0.0, cy = 0.0;
-        #pragma omp parallel for reduction(+:cx,cy) schedule(static)
-        for (size_t i = 0; i < n; ++i) {
-            cx += birds[i].position.x;
-            cy += birds[i].position.y;
-        }
-        cx /= n; cy /= n;
-
-        // Average distance to center
-        double totalDist = 0.0;
-        #pragma omp parallel for reduction(+:totalDist) schedule(static)
-        for (size_t i = 0; i < n; ++i) {
-            const float dx = birds[i].position.x - static_cast<float>(cx);
-            const float dy = birds[i].position.y - static_cast<float>(cy);
-            totalDist += std::sqrt(dx*dx + dy*dy);
-        }
-        return static_cast<float>(totalDist / n);
-    }
-};
+    json << "\n  ]\n}\n";
+    std::cerr << "[bench] JSON escrito en: " << jsonPath << "\n";
+}
 
 // ==========================
-// Benchmark
+// Recording
 // ==========================
 
-#include <fstream>
-#include <random>
-
-// Ejecuta frames de update y devuelve tiempo total en microsegundos
-static long long run_simulation_once(bool parallel, int frames, int width, int height, int numBoids, unsigned seed) {
-    // Semilla fija por corrida para reproducibilidad
-    std::srand(seed);
-
-    FlockingSystem flock(width, height);
-    flock.initializeBirds(numBoids);
+// Records every step of 'flock' into opt.recordPath (no-op without --record).
+// The hook runs on whichever thread steps the flock, so it also works pipelined.
+static bool attach_recorder(FlockRecorder& recorder, FlockingSystem& flock, const CLI_Options& opt) {
+    if (opt.recordPath.empty()) return true;
+    RecordingHeader header;
+    header.width = flock.getWidth();
+    header.height = flock.getHeight();
+    header.simHz = (uint32_t)std::max(opt.simHz, 1);
+    header.keyInterval = (uint32_t)std::max(opt.keyInterval, 1);
+    header.seed = flock.getSeed();
+    // Velocities never exceed the fastest species' maxSpeed
+    header.speedRange = 0.f;
+    for (const BoidParams& p : flock.getSpecies().params) header.speedRange = std::max(header.speedRange, p.maxSpeed);
+    if (!recorder.open(opt.recordPath, header, opt.recordDelta)) return false;
+    // A re-sort moves every boid to another index, which would force a key frame each time
+    flock.setSortInterval(0);
+    flock.setStepHook([&recorder](const FlockingSystem& f) {
+        TRACE_SCOPE("record.frame");
+        recorder.append(f.state(), f.getColors().data(), f.getSpecies());
+    });
+    return true;
+}
 
-    // dt fijo para reducir varianza (no dependas del reloj real)
-    const float dt = 1.0f / 60.0f;
+static void report_recording(const FlockRecorder& recorder, const CLI_Options& opt) {
+    if (opt.recordPath.empty()) return;
+    std::cerr << "[record] " << recorder.frames() << " frames, " << recorder.bytes() / 1024
+              << " KB escritos en: " << opt.recordPath << "\n";
+}
 
-    auto t0 = std::chrono::high_resolution_clock::now();
-    for (int f = 0; f < frames; ++f) {
-        if (parallel) flock.updateParallel();
-        else          flock.updateSerial();
-        // No es necesario mover gato ni render, para medir cómputo puro
-        // Si quisieras medir “end-to-end” con render, init SDL y dibuja aquí.
+// Steps the flock --frames times without window or rendering (precomputing a --record log)
+static int run_headless(const CLI_Options& opt) {
+    FlockingSystem flock(opt.width, opt.height);
+    flock.setCapacity(opt.maxBoids);
+    flock.setEngine(opt.engines.empty() ? "grid" : opt.engines.front());
+    flock.setSimdLevel(opt.simd);
+    flock.setSchedule(opt.schedule);
+    flock.setSortInterval(opt.sortInterval);
+    if (opt.numa) flock.setSortOrder(SortOrder::Bands);
+    flock.setTheta(opt.theta);
+    flock.setSeed(opt.seed);
+    flock.setFlockParams(0, opt.flock);
+    if (opt.threads > 0) flock.setThreads(opt.threads);
+    flock.initializeBirds(opt.numBoids);
+    if (opt.predators > 0) flock.addBoids(opt.predators, flock.addSpecies(predatorParams()));
+
+    FlockRecorder recorder;
+    if (!attach_recorder(recorder, flock, opt)) return 1;
+    const perfCounters::CacheCounts cache0 = perfCounters::read();
+    const auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < opt.frames; ++f) flock.update();
+    const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "[headless] " << opt.frames << " pasos de " << flock.getBoidCount() << " boids en " << s << " s\n";
+    if (perfCounters::available() && opt.frames > 0) {
+        const perfCounters::CacheCounts c = perfCounters::read() - cache0;
+        std::cerr << "[headless] Fallos de caché por paso: " << c.misses / opt.frames << " LLC ("
+                  << (c.references ? 100.0 * c.misses / c.references : 0.0) << "% de los accesos), "
+                  << c.l1dMisses / opt.frames << " L1d\n";
     }
-    auto t1 = std::chrono::high_resolution_clock::now();
-    return std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    recorder.close();
+    report_recording(recorder, opt);
+    return 0;
 }
 
-static void run_benchmark(const CLI_Options& opt) {
-    // Config OMP
-    if (opt.threads > 0) omp_set_num_threads(opt.threads);
-    const int p = (opt.threads > 0) ? opt.threads : omp_get_max_threads();
+// Plays a .flk log in a window at its recorded rate, interpolating between frames.
+// Nothing is simulated: a weak machine only decodes and draws.
+static int run_replay(const CLI_Options& opt) {
+    FlockReplay replay;
+    if (!replay.open(opt.replayPath)) return 1;
+    const RecordingHeader& h = replay.header;
+    std::cout << "Reproduciendo " << opt.replayPath << ": " << replay.frameCount() << " frames de "
+              << h.width << "x" << h.height << " a " << h.simHz << " Hz\n";
 
-    const int W = (opt.width  > 0 ? opt.width  : 1280);
-    const int H = (opt.height > 0 ? opt.height : 720);
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) != 0) {
+        std::cerr << "[Error] SDL_Init: " << SDL_GetError() << std::endl;
+        return 1;
+    }
+    SDL_Window* window = SDL_CreateWindow("Flocking Birds Replay",
+        SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+        opt.width > 0 ? opt.width : h.width, opt.height > 0 ? opt.height : h.height,
+        SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
+    if (!window) {
+        std::cerr << "[Error] SDL_CreateWindow: " << SDL_GetError() << std::endl;
+        SDL_Quit();
+        return 1;
+    }
+    SDL_Renderer* renderer = nullptr;
+    if (opt.renderer == "accelerated")
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    if (!renderer) renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE);
+    if (!renderer) {
+        std::cerr << "[Error] SDL_CreateRenderer: " << SDL_GetError() << std::endl;
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return 1;
+    }
+    // Recorded coordinates are scaled to whatever size the window has
+    SDL_RenderSetLogicalSize(renderer, h.width, h.height);
+
+    SDL_RendererInfo rinfo{};
+    SDL_GetRendererInfo(renderer, &rinfo);
+    FramePacer pacer((rinfo.flags & SDL_RENDERER_PRESENTVSYNC) ? 0 : opt.maxFps);
+    SunsetBackground sunset;
+    BoidBatch batch;
+
+    BoidState cur, prev;
+    std::vector<ColorIndex> colors;
+    SpeciesTable species;
+    size_t frame = 0, prevCount = 0;
+    bool ok = replay.frame(0, cur, colors, species);
+
+    const double dt = 1.0 / std::max<uint32_t>(h.simHz, 1);
+    double accumulator = 0.0;
+    bool useSunset = opt.useSunset, darkBoids = opt.darkBoids, paused = false;
+    auto last = std::chrono::steady_clock::now();
+    while (ok) {
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_QUIT) ok = false;
+            else if (event.type == SDL_KEYDOWN) {
+                switch (event.key.keysym.sym) {
+                    case SDLK_ESCAPE: ok = false; break;
+                    case SDLK_SPACE:  paused = !paused; break;
+                    case SDLK_b:      useSunset = !useSunset; break;
+                    case SDLK_c:      darkBoids = !darkBoids; break;
+                    default: break;
+                }
+            }
+        }
+        if (!ok) break;
+
+        const auto now = std::chrono::steady_clock::now();
+        if (!paused) accumulator += std::chrono::duration<double>(now - last).count();
+        last = now;
+        for (int k = 0; accumulator >= dt && k < opt.maxSimSteps; ++k) {
+            accumulator -= dt;
+            std::swap(cur, prev);
+            frame = (frame + 1) % replay.frameCount();
+            if (!replay.frame(frame, cur, colors, species)) {
+                std::cerr << "[Error] Frame " << frame << " de " << opt.replayPath << " corrupto\n";
+                ok = false;
+                break;
+            }
+            // No interpolation across the loop point or a change in the flock
+            prevCount = (frame == 0 || prev.size() != cur.size()) ? 0 : cur.size();
+        }
+        accumulator = std::min(accumulator, dt);
 
-    // CSV
-    std::ofstream csv;
-    if (!opt.csvPath.empty()) {
-        csv.open(opt.csvPath);
+        if (useSunset) {
+            const float tsec = (float)frame / h.simHz;
+            sunset.draw(renderer, h.width, h.height, 0.45f + 0.1f * std::sin(tsec * 0.2f));
+        } else {
+            SDL_SetRenderDrawColor(renderer, 20, 25, 40, 255);
+            SDL_RenderClear(renderer);
+        }
+        batch.draw(renderer, cur, colors.data(), boidPalette(), species, darkBoids, &prev, prevCount,
+                   (float)(accumulator / dt), 0.5f * std::min(h.width, h.height));
+        SDL_RenderPresent(renderer);
+        pacer.wait();
     }
-    auto& out = opt.csvPath.empty() ? std::cout : csv;
 
-    out << "mode,boids,frames,trials,threads,seed,trial_idx,usec\n";
+    sunset.release();
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return 0;
+}
 
-    std::vector<long long> serial_us;
-    std::vector<long long> parallel_us;
+// ==========================
+// Verify
+// ==========================
 
-    // Estimate ETA
-    const int sampleFrames = 60;
-    auto ser_us = (opt.mode != "parallel") ? run_simulation_once(false, sampleFrames, W, H, opt.numBoids, opt.seed) : 0;
-    auto par_us = (opt.mode != "serial")   ? run_simulation_once(true,  sampleFrames, W, H, opt.numBoids, opt.seed) : 0;
+// Position divergence of one run from a reference (same boids, same order)
+struct Divergence { double max = 0, rms = 0; };
+
+// A boid that wrapped around a border in only one run is compared across the border
+// (births wrap from -r to width + r, so the period is width + 2r)
+static Divergence position_divergence(const BoidState& ref, const BoidState& run, const SpeciesTable& species,
+                                      int width, int height) {
+    Divergence d;
+    double sumSq = 0.0;
+    for (int s = 0; s < species.count(); ++s) {
+        const float r = species.params[s].r;
+        const float periodX = width + 2.f * r, periodY = height + 2.f * r;
+        for (size_t i = species.begin(s); i < species.end(s); ++i) {
+            float dx = std::abs(run.px[i] - ref.px[i]), dy = std::abs(run.py[i] - ref.py[i]);
+            dx = std::min(dx, std::abs(periodX - dx));
+            dy = std::min(dy, std::abs(periodY - dy));
+            const double e2 = (double)dx * dx + (double)dy * dy;
+            sumSq += e2;
+            d.max = std::max(d.max, std::sqrt(e2));
+        }
+    }
+    if (ref.size() > 0) d.rms = std::sqrt(sumSq / ref.size());
+    return d;
+}
 
-    double tpf_ser = (opt.mode != "parallel") ? (double)ser_us / sampleFrames : 0.0;
-    double tpf_par = (opt.mode != "serial")   ? (double)par_us / sampleFrames : 0.0;
-    double eta_sec = (opt.trials * opt.frames * (tpf_ser + tpf_par)) / 1e6;
+// Steps every engine from the same seed and compares positions frame by frame, against
+// the first engine or a golden trajectory (--load-states). Returns the process exit code:
+// 0 when every frame stays within --tolerance.
+static int run_verify(CLI_Options& opt) {
+    // Golden trajectory: an exact snapshot file, or a quantized .flk recording
+    SnapshotReader golden;
+    FlockReplay goldenLog;
+    const bool useGolden = !opt.loadStates.empty();
+    const bool goldenIsLog = useGolden && opt.loadStates.size() > 4 &&
+                             opt.loadStates.compare(opt.loadStates.size() - 4, 4, ".flk") == 0;
+    size_t goldenBoids = 0;
+    if (goldenIsLog) {
+        if (!goldenLog.open(opt.loadStates)) return 1;
+        // The golden run fixes the scenario; the flock parameters still come from the CLI
+        opt.seed = (unsigned)goldenLog.header.seed;
+        opt.width = goldenLog.header.width;
+        opt.height = goldenLog.header.height;
+        opt.frames = (int)goldenLog.frameCount();
+    } else if (useGolden) {
+        if (!golden.open(opt.loadStates)) return 1;
+        opt.seed = (unsigned)golden.header.seed;
+        opt.width = golden.header.width;
+        opt.height = golden.header.height;
+        opt.frames = (int)golden.header.frames;
+        goldenBoids = golden.header.boids;
+    }
 
-    std::cerr << "[bench] ETA aproximada: ~" << (long long)std::llround(eta_sec) << " s "
-            << "(mode=" << opt.mode
-            << ", boids=" << opt.numBoids
-            << ", trials=" << opt.trials
-            << ", frames=" << opt.frames
-            << ", threads=" << p << ")\n";
+    std::vector<std::string> engines = opt.engines;
+    if (engines.empty()) engines = useGolden ? std::vector<std::string>{"grid"} : std::vector<std::string>{"serial", "grid"};
+    if (!useGolden && engines.size() < 2 && opt.saveStates.empty()) {
+        std::cerr << "[Error] --verify necesita dos motores (--engine serial,grid), --load-states o --save-states\n";
+        return 1;
+    }
+    if (opt.threads > 0) omp_set_num_threads(opt.threads);
 
+    std::vector<std::unique_ptr<FlockingSystem>> flocks;
+    for (const auto& e : engines) {
+        auto flock = std::make_unique<FlockingSystem>(opt.width, opt.height);
+        flock->setCapacity((size_t)opt.numBoids + opt.predators);
+        flock->setSeed(opt.seed);
+        flock->setEngine(e);
+        flock->setSimdLevel(opt.simd);
+        flock->setSchedule(opt.schedule);
+        // Runs are compared boid by boid at the same index, so the arrays keep their order
+        flock->setSortInterval(0);
+        flock->setTheta(opt.theta);
+        flock->setFlockParams(0, opt.flock);
+        flock->initializeBirds(opt.numBoids);
+        if (opt.predators > 0) flock->addBoids(opt.predators, flock->addSpecies(predatorParams()));
+        flocks.push_back(std::move(flock));
+    }
+    const FlockingSystem& first = *flocks.front();
+    const size_t n = first.getBoidCount();
+    if (goldenIsLog) {
+        std::vector<ColorIndex> colors;
+        SpeciesTable species;
+        BoidState s0;
+        if (!goldenLog.frame(0, s0, colors, species)) return 1;
+        goldenBoids = s0.size();
+    }
+    if (useGolden && goldenBoids != n) {
+        std::cerr << "[Error] " << opt.loadStates << " tiene " << goldenBoids << " boids y la corrida "
+                  << n << " (revisa --boids y --predators)\n";
+        return 1;
+    }
 
-    if (opt.mode != "parallel") {
-        // SERIAL
-        serial_us.reserve(opt.trials);
-        for (int t = 0; t < opt.trials; ++t) {
-            long long us = run_simulation_once(false, opt.frames, W, H, opt.numBoids, opt.seed + t);
-            serial_us.push_back(us);
-            out << "serial," << opt.numBoids << "," << opt.frames << "," << opt.trials << ","
-                << p << "," << (opt.seed + t) << "," << (t+1) << "," << us << "\n";
-        }
+    SnapshotWriter writer;
+    if (!opt.saveStates.empty()) {
+        SnapshotHeader header;
+        header.boids = (uint32_t)n;
+        header.frames = (uint32_t)opt.frames;
+        header.width = opt.width;
+        header.height = opt.height;
+        header.seed = opt.seed;
+        if (!writer.open(opt.saveStates, header)) return 1;
     }
 
-    if (opt.mode != "serial") {
-        // PARALELO
-        parallel_us.reserve(opt.trials);
-        for (int t = 0; t < opt.trials; ++t) {
-            long long us = run_simulation_once(true, opt.frames, W, H, opt.numBoids, opt.seed + t);
-            parallel_us.push_back(us);
-            out << "parallel," << opt.numBoids << "," << opt.frames << "," << opt.trials << ","
-                << p << "," << (opt.seed + t) << "," << (t+1) << "," << us << "\n";
+    // Every engine is checked against the golden trajectory, or every other engine against the first one.
+    // Against an engine, each frame also steps a copy of the reference state with the other engine:
+    // trajectories of an approximate engine drift apart quickly, the one-step error is its accuracy.
+    struct Track {
+        size_t flock;
+        double max = 0, rms = 0;   // worst boid over all frames, RMS of the last frame
+        int firstOver = -1;        // first frame over the tolerance
+        std::unique_ptr<FlockEngine> probe;   // steps the reference state (null against a golden run)
+        BoidState probeState;
+        double stepMax = 0, stepRmsSum = 0;   // one-step error: worst boid, sum of the per-frame RMS
+    };
+    std::vector<Track> tracks;
+    for (size_t k = useGolden ? 0 : 1; k < flocks.size(); ++k) {
+        Track t;
+        t.flock = k;
+        if (!useGolden) {
+            t.probe = createEngine(engines[k]);
+            t.probe->reserve(n);
         }
+        tracks.push_back(std::move(t));
     }
+    const std::string refName = useGolden ? opt.loadStates : engines.front();
+
+    std::cerr << "[verify] " << opt.frames << " frames, " << n << " boids, seed " << opt.seed
+              << ", tolerancia " << opt.tolerance << " px, referencia " << refName << "\n";
+
+    BoidState goldenState;
+    std::vector<ColorIndex> goldenColors;
+    SpeciesTable goldenSpecies;
+    for (int f = 1; f <= opt.frames; ++f) {
+        for (Track& t : tracks)
+            if (t.probe) first.previewStep(*t.probe, t.probeState);
+        for (auto& flock : flocks) flock->update();
+        if (!opt.saveStates.empty() && !writer.write(first.state())) return 1;
+        if (goldenIsLog) {
+            if (!goldenLog.frame((size_t)f - 1, goldenState, goldenColors, goldenSpecies)) return 1;
+            if (goldenState.size() != n) {
+                std::cerr << "[Error] " << opt.loadStates << " cambia de boids en el frame " << f << "\n";
+                return 1;
+            }
+        } else if (useGolden && !golden.read(goldenState)) {
+            return 1;
+        }
 
-    auto stats = [](const std::vector<long long>& v) {
-        long double sum = 0.0L; for (auto x : v) sum += x;
-        long double mean = sum / v.size();
-        long double var = 0.0L; for (auto x : v) { long double d = x - mean; var += d*d; }
-        var /= (v.size() > 1 ? (v.size() - 1) : 1);
-        long double sd = std::sqrt(var);
-        return std::pair<long double,long double>(mean, sd);
-    };
+        const BoidState& ref = useGolden ? goldenState : first.state();
+        for (Track& t : tracks) {
+            const Divergence d = position_divergence(ref, flocks[t.flock]->state(), first.getSpecies(),
+                                                     opt.width, opt.height);
+            t.max = std::max(t.max, d.max);
+            t.rms = d.rms;
+            if (t.firstOver < 0 && d.max > opt.tolerance) t.firstOver = f;
+            if (t.probe) {
+                const Divergence e = position_divergence(ref, t.probeState, first.getSpecies(), opt.width, opt.height);
+                t.stepMax = std::max(t.stepMax, e.max);
+                t.stepRmsSum += e.rms;
+            }
+        }
+    }
 
-    auto [mean_ser, sd_ser] = stats(serial_us);
-    auto [mean_par, sd_par] = stats(parallel_us);
+    bool ok = true;
+    for (const Track& t : tracks) {
+        std::cout << engines[t.flock] << " vs " << refName << ": max " << t.max << " px, rms "
+                  << t.rms << " px (último frame), primer frame > " << opt.tolerance << " px: ";
+        if (t.firstOver < 0) std::cout << "ninguno\n";
+        else                 std::cout << t.firstOver << "\n";
+        if (t.probe && opt.frames > 0)
+            std::cout << "  un paso desde " << refName << ": max " << t.stepMax << " px, rms medio "
+                      << t.stepRmsSum / opt.frames << " px\n";
+        ok = ok && t.firstOver < 0;
+    }
+    if (!opt.saveStates.empty())
+        std::cerr << "[verify] Trayectoria de " << engines.front() << " escrita en: " << opt.saveStates << "\n";
+    return ok ? 0 : 1;
+}
 
-    long double speedup = mean_ser / mean_par;
-    long double efficiency = speedup / p;
+// ==========================
+// Offline render
+// ==========================
 
-    out << "# summary\n";
-    out << "# threads=" << p
-        << " mean_serial_us=" << (long long)mean_ser << " sd_serial_us=" << (long long)sd_ser
-        << " mean_parallel_us=" << (long long)mean_par << " sd_parallel_us=" << (long long)sd_par
-        << " speedup=" << (double)speedup << " efficiency=" << (double)efficiency << "\n";
+// Simulates and rasterizes --frames frames into an offscreen software surface (no window,
+// no video driver) and hands each one to a FrameWriter thread. Also serves as an end-to-end
+// render benchmark: per-phase times are reported on stderr.
+static int run_offline(const CLI_Options& opt) {
+    const int W = opt.width, H = opt.height;
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, W, H, 32, SDL_PIXELFORMAT_RGBA32);
+    SDL_Renderer* renderer = surface ? SDL_CreateSoftwareRenderer(surface) : nullptr;
+    if (!renderer) {
+        std::cerr << "[Error] Render offscreen: " << SDL_GetError() << "\n";
+        if (surface) SDL_FreeSurface(surface);
+        return 1;
+    }
 
-    if (&out == &std::cout) std::cout << std::flush;
+    FlockingSystem flock(W, H);
+    flock.setCapacity(opt.maxBoids);
+    flock.setEngine(opt.engines.empty() ? "grid" : opt.engines.front());
+    flock.setSimdLevel(opt.simd);
+    flock.setSchedule(opt.schedule);
+    flock.setSortInterval(opt.sortInterval);
+    if (opt.numa) flock.setSortOrder(SortOrder::Bands);
+    flock.setTheta(opt.theta);
+    flock.setSeed(opt.seed);
+    flock.setFlockParams(0, opt.flock);
+    if (opt.threads > 0) flock.setThreads(opt.threads);
+    flock.initializeBirds(opt.numBoids);
+    if (opt.predators > 0) flock.addBoids(opt.predators, flock.addSpecies(predatorParams()));
 
-    if (!opt.csvPath.empty()) {
-        std::cerr << "[bench] Resultados escritos en: " << opt.csvPath << "\n";
+    FlockRecorder recorder;
+    if (!attach_recorder(recorder, flock, opt)) {
+        SDL_DestroyRenderer(renderer);
+        SDL_FreeSurface(surface);
+        return 1;
     }
 
-}
-
+    FrameWriter writer;
+    if (!writer.start(opt.renderOut, W, H)) {
+        SDL_DestroyRenderer(renderer);
+        SDL_FreeSurface(surface);
+        return 1;
+    }
+    std::cerr << "[render] " << opt.frames << " frames de " << W << "x" << H << ", " << opt.numBoids
+              << " boids, motor " << flock.getEngineName() << " -> "
+              << (opt.renderOut == "-" ? "stdout (rgba)" : opt.renderOut) << "\n";
+
+    using clock = std::chrono::steady_clock;
+    SunsetBackground sunset;
+    long long simUs = 0, renderUs = 0, readUs = 0;
+    const auto start = clock::now();
+    for (int f = 0; f < opt.frames; ++f) {
+        auto t0 = clock::now();
+        flock.update();
+        auto t1 = clock::now();
+
+        {
+            TRACE_SCOPE("render.background");
+            if (opt.useSunset) {
+                // Simulated time, so the video loop does not depend on how fast it renders
+                const float tsec = (float)f / opt.simHz;
+                sunset.draw(renderer, W, H, 0.45f + 0.1f * std::sin(tsec * 0.2f));
+            } else {
+                SDL_SetRenderDrawColor(renderer, 20, 25, 40, 255);
+                SDL_RenderClear(renderer);
+            }
+        }
+        flock.render(renderer, opt.darkBoids);
+        auto t2 = clock::now();
 
+        // Waits only if the writer is a whole queue behind
+        uint8_t* pixels = writer.acquire();
+        {
+            TRACE_SCOPE("render.readback");
+            SDL_RenderReadPixels(renderer, nullptr, SDL_PIXELFORMAT_RGBA32, pixels, writer.pitch());
+        }
+        writer.submit();
+        auto t3 = clock::now();
 
+        simUs    += std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+        renderUs += std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+        readUs   += std::chrono::duration_cast<std::chrono::microseconds>(t3 - t2).count();
+    }
+    const bool ok = writer.finish();
+    const double totalS = std::chrono::duration<double>(clock::now() - start).count();
+    recorder.close();
+    report_recording(recorder, opt);
+
+    sunset.release();
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(surface);
+
+    const int n = std::max(opt.frames, 1);
+    std::cerr << "[render] " << opt.frames << " frames en " << totalS << " s (" << opt.frames / std::max(totalS, 1e-9)
+              << " fps) | por frame: sim " << simUs / n << " us, render " << renderUs / n
+              << " us, copia+cola " << readUs / n << " us (espera al escritor " << writer.stallUs() / n << " us)\n";
+    return ok ? 0 : 1;
+}
 
 // ==========================
 // MAIN
@@ -1011,23 +1357,103 @@ int main(int argc, char** argv) {
 
     CLI_Options opt = parseArgs(argc, argv);
 
+    // Thread binding has to be in the environment before the OpenMP runtime starts (may re-exec)
+    if (opt.numa) {
+        if (opt.procBind.empty()) opt.procBind = "close";
+        if (opt.places.empty()) opt.places = "cores";
+        if (opt.schedule != LoopSchedule::Static || !opt.benchSchedules.empty())
+            std::cerr << "[Advertencia] --numa: con un schedule distinto de static los hilos no procesan "
+                         "los boids cuyas páginas ubicaron\n";
+    }
+    // Low power: idle OpenMP threads block instead of spinning (unless the environment says otherwise)
+    const std::string waitPolicy = opt.frameBudget > 0.f && !std::getenv("OMP_WAIT_POLICY") ? "passive" : "";
+    numa::applyPlacement(opt.procBind, opt.places, argv, waitPolicy);
+
+    if (!opt.tracePath.empty()) {
+        trace::enable();
+        trace::setThreadName("main");
+    }
+    // Before any OpenMP region, so the worker threads inherit the counters
+    perfCounters::open();
+
+    if (opt.distributed) {
+#ifdef FLOCK_HAVE_MPI
+        DistributedConfig cfg;
+        if (opt.width > 0)  cfg.width = opt.width;
+        if (opt.height > 0) cfg.height = opt.height;
+        cfg.boidsPerRank = opt.numBoids;
+        cfg.predatorsPerRank = opt.predators;
+        cfg.frames = std::max(opt.frames, 1);
+        cfg.trials = std::max(opt.trials, 1);
+        cfg.warmup = opt.warmup;
+        cfg.threads = opt.threads;
+        cfg.seed = opt.seed;
+        if (!opt.engines.empty()) cfg.engine = opt.engines.front();
+        cfg.simd = opt.simd;
+        cfg.flock = opt.flock;
+        cfg.csvPath = opt.csvPath;
+        return opt.bench ? runDistributedBench(cfg, argc, argv) : runDistributed(cfg, argc, argv);
+#else
+        std::cerr << "[Error] --distributed necesita un build con MPI (cmake encuentra MPI)\n";
+        return 1;
+#endif
+    }
+
     if (opt.bench) {
         if (opt.width <= 0)  opt.width  = 1280;
         if (opt.height <= 0) opt.height = 720;
         if (opt.trials < 1)  opt.trials = 10;
         if (opt.frames < 1)  opt.frames = 600;
         run_benchmark(opt);
+        if (!opt.tracePath.empty()) trace::dump(opt.tracePath);
         return 0;
     }
 
+    if (!opt.replayPath.empty()) {
+        const int rc = run_replay(opt);
+        if (!opt.tracePath.empty()) trace::dump(opt.tracePath);
+        return rc;
+    }
+
+    if (opt.headless) {
+        if (opt.width <= 0)  opt.width  = 1280;
+        if (opt.height <= 0) opt.height = 720;
+        if (opt.frames < 1)  opt.frames = 600;
+        const int rc = run_headless(opt);
+        if (!opt.tracePath.empty()) trace::dump(opt.tracePath);
+        return rc;
+    }
+
+    if (!opt.renderOut.empty()) {
+        if (opt.width <= 0)  opt.width  = 1280;
+        if (opt.height <= 0) opt.height = 720;
+        if (opt.frames < 1)  opt.frames = 600;
+        if (opt.simHz < 1)   opt.simHz  = 60;
+        const int rc = run_offline(opt);
+        if (!opt.tracePath.empty()) trace::dump(opt.tracePath);
+        return rc;
+    }
+
+    if (opt.verify) {
+        if (opt.width <= 0)  opt.width  = 1280;
+        if (opt.height <= 0) opt.height = 720;
+        if (opt.frames < 1)  opt.frames = 600;
+        const int rc = run_verify(opt);
+        if (!opt.tracePath.empty()) trace::dump(opt.tracePath);
+        return rc;
+    }
+
     if (opt.width <= 0)  opt.width  = askInt("Ancho de la ventana", 640, 1280);
     if (opt.height <= 0) opt.height = askInt("Alto de la ventana",  480, 720);
 
+    if (opt.simHz < 1)       opt.simHz = 60;
+    if (opt.maxSimSteps < 1) opt.maxSimSteps = 1;
     if (opt.width  < 640) opt.width  = 640;
     if (opt.height < 480) opt.height = 480;
 
     std::cout << "Iniciando simulación de flocking con " << opt.numBoids << " boids...\n";
-    std::cout << "Modo: " << (opt.useParallel ? "Paralelo (OpenMP)" : "Serial") << "\n";
+    const std::string startEngine = opt.engines.empty() ? "grid" : opt.engines.front();
+    std::cout << "Motor: " << startEngine << "\n";
     if (opt.showTrails) std::cout << "Estelas activadas\n";
 
     // Initialize SDL
@@ -1052,8 +1478,16 @@ int main(int argc, char** argv) {
     }
 
     // Instantiation of the renderer, controller that let us interact with sdl window.
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, 
-        SDL_RENDERER_SOFTWARE);
+    // The accelerated one moves rasterization off the cores used by OpenMP.
+    SDL_Renderer* renderer = nullptr;
+    if (opt.renderer == "accelerated") {
+        renderer = SDL_CreateRenderer(window, -1,
+            SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+        if (!renderer)
+            std::cerr << "[Warn] Accelerated renderer unavailable (" << SDL_GetError()
+                      << "), falling back to software\n";
+    }
+    if (!renderer) renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE);
 
     if (!renderer) {
         std::cerr << "[Error] SDL_CreateRenderer: " << SDL_GetError() << std::endl;
@@ -1062,31 +1496,45 @@ int main(int argc, char** argv) {
         return 1;
     }
 
+    // Vsync already paces SDL_RenderPresent; otherwise sleep to --fps
+    SDL_RendererInfo rinfo{};
+    SDL_GetRendererInfo(renderer, &rinfo);
+    const bool vsync = (rinfo.flags & SDL_RENDERER_PRESENTVSYNC) != 0;
+    std::cout << "Renderer: " << (rinfo.name ? rinfo.name : "?")
+              << (vsync ? " (vsync)" : "") << "\n";
+    FramePacer pacer(vsync ? 0 : opt.maxFps);
+    SunsetBackground sunset;
+
     // Initialize SDL_image for PNG loading
     if ((IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG) == 0) {
         std::cerr << "[Warn] IMG_Init PNG: " << IMG_GetError() << "\n";
     }
 
-    // Load cat sprite strips
-    Cat cat;
-    cat.scale = 3.f;
-    cat.speed = 140.f;
+    // Load cat sprite strips, packed into one atlas texture
+    CatSprites catSprites;
 
     // Idle: 4 frames
-    cat.loadStrip(renderer, CatState::IdleBack,
+    catSprites.loadStrip(CatState::IdleBack,
                 "assets/cat_idle.png", 31, 36, /*frames=*/1, /*frameDur=*/0.35f);
 
     // Walk left: 4 frames
-    cat.loadStrip(renderer, CatState::WalkLeft,
+    catSprites.loadStrip(CatState::WalkLeft,
         "assets/cat_walk_left.png", 31, 36, /*frames=*/4, /*frameDur=*/0.10f,
         0, 0, 0);
 
     // Walk right: 4 frames
-    cat.loadStrip(renderer, CatState::WalkRight,
+    catSprites.loadStrip(CatState::WalkRight,
         "assets/cat_walk_right.png", 31, 36, /*frames=*/4, /*frameDur=*/0.10f,
         0, 0, 0);
 
-    cat.strips[CatState::WalkUp] = cat.strips[CatState::IdleBack]; // Reuse idle for up
+    catSprites.alias(CatState::WalkUp, CatState::IdleBack); // Reuse idle for up
+    catSprites.build(renderer);
+
+    // Every actor is queued into one batch and drawn with a single call per frame
+    SpriteBatch spriteBatch;
+    Cat cat(&catSprites);
+    cat.scale = 3.f;
+    cat.speed = 140.f;
 
     cat.placeAtBottom(opt.width, opt.height); // Start at bottom center
 
@@ -1105,13 +1553,78 @@ int main(int argc, char** argv) {
 
     // Initialize flocking system
     FlockingSystem flock(opt.width, opt.height);
+    flock.setCapacity(opt.maxBoids);
+    flock.setEngine(startEngine);
+    flock.setSimdLevel(opt.simd);
+    flock.setSchedule(opt.schedule);
+    flock.setSortInterval(opt.sortInterval);
+    if (opt.numa) flock.setSortOrder(SortOrder::Bands);
+    flock.setTheta(opt.theta);
+    flock.setSeed(opt.seed);
+    flock.setFlockParams(0, opt.flock);
     flock.initializeBirds(opt.numBoids);
+    if (opt.predators > 0) flock.addBoids(opt.predators, flock.addSpecies(predatorParams()));
+
+    // Declared before the pipeline, so the simulation thread stops before the recorder closes
+    FlockRecorder recorder;
+    if (!attach_recorder(recorder, flock, opt)) std::cerr << "[Warn] --record desactivado\n";
+
+    // Registry index of the running engine, for P and the ImGui combo
+    const auto& engines = engineRegistry();
+    int engineIdx = 0;
+    for (size_t k = 0; k < engines.size(); ++k)
+        if (std::string(flock.getEngineName()) == engines[k].name) engineIdx = (int)k;
+
+    // Pipelined mode: the flock steps on its own thread and is only touched
+    // through posted commands; the main thread renders published snapshots
+    SimPipeline pipeline;
+    BoidBatch snapshotBatch;
+    if (opt.pipeline) pipeline.start(flock, opt.simHz, opt.maxSimSteps);
+    auto withFlock = [&](SimPipeline::Command cmd) {
+        if (opt.pipeline) pipeline.post(std::move(cmd));
+        else cmd(flock);
+    };
     
     // Performance tracking
     auto lastTime = std::chrono::high_resolution_clock::now();
     auto lastFlockingTime = std::chrono::microseconds(0);
+
+    // Fixed simulation timestep (see the update below)
+    double simDt = 1.0 / opt.simHz;
+    double simAccumulator = 0.0;
+    int simStepsLastFrame = 0;
     auto lastUpdateTime = std::chrono::microseconds(0);
     auto lastRenderTime = std::chrono::microseconds(0);
+    auto lastPresentTime = std::chrono::microseconds(0);
+
+    // Performance panel and its live knobs
+    PerfDashboard dashboard;
+    DashboardKnobs knobs;
+    FlockParams flockKnobs = opt.flock;   // edited copy of species 0's FlockParams
+    knobs.threads = omp_get_max_threads();
+    knobs.schedule = opt.schedule;
+    knobs.sortInterval = flock.getSortInterval();   // 0 while recording
+    knobs.theta = flock.getTheta();
+
+    // Low-power mode: quality ladder against the frame budget, CPU use as the power proxy
+    const bool lowPower = opt.frameBudget > 0.f;
+    QualityGovernor governor;
+    governor.setBudget(opt.frameBudget);
+    CpuMeter cpuMeter;
+    const int numProcs = omp_get_num_procs();
+    int simHz = opt.simHz;      // current simulation rate (lowered by the governor)
+    bool occluded = false;      // hidden or minimized: nothing is stepped or drawn
+    bool resumed = false;       // first frame after being occluded (its dt is dropped)
+    auto applyQuality = [&]() {
+        simHz = governor.simHz(opt.simHz);
+        simDt = 1.0 / simHz;
+        if (opt.pipeline) pipeline.setSimHz(simHz);
+        snapshotBatch.setDetail(governor.detail());
+        withFlock([t = governor.threads(knobs.threads), d = governor.detail()](FlockingSystem& f) {
+            f.setThreads(t);
+            f.setRenderDetail(d);
+        });
+    };
     
     float fps = 0.0f; // Smoothed FPS
     int frameCount = 0; // Frames since last FPS update
@@ -1126,6 +1639,9 @@ int main(int argc, char** argv) {
 
         auto frameStartTime = std::chrono::high_resolution_clock::now();
 
+        // Nothing on screen: block on the event queue instead of stepping and presenting
+        if (occluded) SDL_WaitEventTimeout(nullptr, 250);
+
         // If there are unprocessed events, procces one at a time.
         SDL_Event event;
         while (SDL_PollEvent(&event)) {
@@ -1147,11 +1663,13 @@ int main(int argc, char** argv) {
                         break;
                     case SDLK_SPACE:
                         paused = !paused;
+                        pipeline.setPaused(paused);
                         std::cout << (paused ? "Paused" : "Resumed") << "\n";
                         break;
                     case SDLK_p:
-                        opt.useParallel = !opt.useParallel;
-                        std::cout << "Mode change to: " << (opt.useParallel ? "Paralell" : "Sequential") << "\n";
+                        engineIdx = (engineIdx + 1) % (int)engines.size();
+                        withFlock([name = engines[engineIdx].name](FlockingSystem& f) { f.setEngine(name); });
+                        std::cout << "Engine: " << engines[engineIdx].name << "\n";
                         break;
                     case SDLK_t:
                         opt.showTrails = !opt.showTrails;
@@ -1162,14 +1680,13 @@ int main(int argc, char** argv) {
                         break;
                     case SDLK_PLUS:
                     case SDLK_KP_PLUS:
-                        flock.addBoids(50);
+                        withFlock([](FlockingSystem& f) { f.addBoids(50); });
                         break;
                     case SDLK_MINUS:
-                    case SDLK_KP_MINUS: {
-                        int canRemove = (int)flock.getBoidCount() - MIN_BOIDS;
-                        if (canRemove > 0) flock.removeBoids(std::min(50, canRemove));
+                    case SDLK_KP_MINUS:
+                        // removeBoids keeps at least MIN_BOIDS
+                        withFlock([](FlockingSystem& f) { f.removeBoids(50); });
                         break;
-                    }
                     case SDLK_b:
                         opt.useSunset = !opt.useSunset;
                         std::cout << "Background: " << (opt.useSunset ? "Sunset" : "Dark") << "\n";
@@ -1186,7 +1703,17 @@ int main(int argc, char** argv) {
                 // Move cat to mouse position
                 cat.goTo((float)event.button.x, (float)event.button.y);
                 // Add boid at mouse position
-                flock.addBoid(static_cast<float>(event.button.x), static_cast<float>(event.button.y));
+                const float x = static_cast<float>(event.button.x), y = static_cast<float>(event.button.y);
+                withFlock([x, y](FlockingSystem& f) { f.addBoid(x, y); });
+            }
+
+            // Remove the boid under the mouse (swap-remove, O(1))
+            else if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_RIGHT) {
+                const float x = static_cast<float>(event.button.x), y = static_cast<float>(event.button.y);
+                withFlock([x, y](FlockingSystem& f) {
+                    size_t i;
+                    if (f.nearestBoid(x, y, 20.f, i)) f.removeBoid(f.handleAt(i));
+                });
             }
 
             // Handle window events gracefully
@@ -1194,78 +1721,192 @@ int main(int argc, char** argv) {
                 if (event.window.event == SDL_WINDOWEVENT_RESIZED) {
                     opt.width = event.window.data1;
                     opt.height = event.window.data2;
-                    flock.resize(opt.width, opt.height);
+                    withFlock([w = opt.width, h = opt.height](FlockingSystem& f) { f.resize(w, h); });
                     cat.placeAtBottom(opt.width, opt.height);
+                } else if (lowPower && (event.window.event == SDL_WINDOWEVENT_HIDDEN ||
+                                        event.window.event == SDL_WINDOWEVENT_MINIMIZED)) {
+                    occluded = true;
+                    pipeline.setPaused(true);
+                } else if (occluded && (event.window.event == SDL_WINDOWEVENT_SHOWN ||
+                                        event.window.event == SDL_WINDOWEVENT_RESTORED ||
+                                        event.window.event == SDL_WINDOWEVENT_EXPOSED)) {
+                    occluded = false;
+                    resumed = true;
+                    pipeline.setPaused(paused);
                 }
             }
         }
-
-        if (!paused) {
-            // Update flocking with timing
+        if (occluded) continue;
+
+        // Wall-clock time since the previous frame
+        static auto lastT = std::chrono::high_resolution_clock::now();
+        auto nowT = std::chrono::high_resolution_clock::now();
+        float dt = std::chrono::duration<float>(nowT - lastT).count();
+        lastT = nowT;
+        if (resumed) { dt = 0.f; resumed = false; }
+
+        if (!paused && !opt.pipeline) {
+            // Fixed-timestep flock: as many steps as the elapsed time covers, so boid
+            // speed does not depend on the render rate. Capped at maxSimSteps per frame;
+            // the remaining backlog is dropped (slow motion instead of a spiral of death).
             auto flockingStart = std::chrono::high_resolution_clock::now();
-            
-            if (opt.useParallel) {
-                flock.updateParallel();
-            } else {
-                flock.updateSerial();
+
+            simAccumulator += dt;
+            simStepsLastFrame = 0;
+            while (simAccumulator >= simDt && simStepsLastFrame < opt.maxSimSteps) {
+                flock.update();
+                simAccumulator -= simDt;
+                ++simStepsLastFrame;
             }
-            
+            if (simAccumulator >= simDt) simAccumulator = 0.0;
+
             auto flockingEnd = std::chrono::high_resolution_clock::now();
             lastFlockingTime = std::chrono::duration_cast<std::chrono::microseconds>(flockingEnd - flockingStart);
+        }
 
-            static auto lastT = std::chrono::high_resolution_clock::now();
-            auto nowT = std::chrono::high_resolution_clock::now();
-            float dt = std::chrono::duration<float>(nowT - lastT).count();
-            lastT = nowT;
-
+        if (!paused) {
             cat.update(dt);
             cat.clampToWindow(opt.width, opt.height);
         }
 
+        // What the overlay shows: the flock itself, or the latest snapshot when pipelined
+        const FrameSnapshot* snap = opt.pipeline ? &pipeline.acquire() : nullptr;
+        if (snap) {
+            lastFlockingTime = std::chrono::microseconds(snap->stepUs);
+            simStepsLastFrame = snap->steps;
+        }
+        const BoidState& shown = snap ? snap->cur : flock.state();
+        const char* engineName = snap ? snap->engine : flock.getEngineName();
+        const bool engineUsesKernel = snap ? snap->usesKernel : flock.usesKernel();
+
         // Render with timing
         auto lastTime = std::chrono::high_resolution_clock::now();
         const auto startTime = lastTime;
         auto renderStart = std::chrono::high_resolution_clock::now();
     
-        if (opt.useSunset) {
-            float tsec  = std::chrono::duration<float>(renderStart - startTime).count();
-            float split = 0.45f + 0.1f * std::sin(tsec * 0.2f);
-            drawSunsetGradient(renderer, opt.width, opt.height, split);
-        } else {
-            SDL_SetRenderDrawColor(renderer, 20, 25, 40, 255);
-            SDL_RenderClear(renderer);
+        {
+            TRACE_SCOPE("render.background");
+            if (opt.useSunset) {
+                float tsec  = std::chrono::duration<float>(renderStart - startTime).count();
+                float split = 0.45f + 0.1f * std::sin(tsec * 0.2f);
+                sunset.draw(renderer, opt.width, opt.height, split);
+            } else {
+                SDL_SetRenderDrawColor(renderer, 20, 25, 40, 255);
+                SDL_RenderClear(renderer);
+            }
         }
 
-        cat.render(renderer);
+        {
+            TRACE_SCOPE("render.cat");
+            spriteBatch.begin(catSprites.atlas);
+            cat.render(spriteBatch);
+            spriteBatch.draw(renderer);
+        }
 
-        flock.render(renderer, opt.darkBoids);
+        if (snap) renderSnapshot(renderer, snapshotBatch, *snap, opt.darkBoids, pipeline.alpha(*snap));
+        else      flock.render(renderer, opt.darkBoids, (float)(simAccumulator / simDt));
 
         // Render ImGui overlay
+        bool dashboardShown = false;
         if (opt.showStats) {
+            TRACE_SCOPE("render.imgui");
             ImGui_ImplSDLRenderer2_NewFrame();
             ImGui_ImplSDL2_NewFrame();
             ImGui::NewFrame();
 
             if (showDetailedStats) {
                 ImGui::Begin("Flocking Analysis", &showDetailedStats);
-                ImGui::Text("Boids: %zu", flock.getBoidCount());
+                ImGui::Text("Boids: %zu", shown.size());
+                const SpeciesTable& shownSpecies = snap ? snap->species : flock.getSpecies();
+                for (int s = 1; s < shownSpecies.count(); ++s)
+                    ImGui::Text("  species %d: %zu", s, shownSpecies.end(s) - shownSpecies.begin(s));
                 ImGui::Text("FPS: %.1f", fps);
-                ImGui::Text("Flocking: %ld μs", lastFlockingTime.count());
+                ImGui::Text("Flocking: %ld μs (%d steps @ %d Hz%s)", lastFlockingTime.count(),
+                            simStepsLastFrame, simHz, opt.pipeline ? ", pipelined" : "");
                 ImGui::Text("Render: %ld μs", lastRenderTime.count());
-                ImGui::Text("Mode: %s", opt.useParallel ? "Parallel" : "Serial");
-                ImGui::Text("Avg Speed: %.2f", flock.getAverageSpeed());
-                ImGui::Text("Coherence: %.1f", flock.getCoherence());
+                ImGui::Text("Renderer: %s%s", rinfo.name ? rinfo.name : "?", vsync ? " (vsync)" : "");
+                if (ImGui::BeginCombo("Engine", engines[engineIdx].name)) {
+                    for (size_t k = 0; k < engines.size(); ++k) {
+                        const bool selected = (int)k == engineIdx;
+                        if (ImGui::Selectable(engines[k].name, selected) && !selected) {
+                            engineIdx = (int)k;
+                            withFlock([name = engines[k].name](FlockingSystem& f) { f.setEngine(name); });
+                        }
+                        if (ImGui::IsItemHovered()) ImGui::SetTooltip("%s", engines[k].description);
+                    }
+                    ImGui::EndCombo();
+                }
+                ImGui::Text("Kernel: %s", engineUsesKernel ? simdLevelName(flock.getSimdLevel()) : "scalar (engine)");
+                const FlockStats& st = snap ? snap->stats : flock.getStats();
+                ImGui::Text("Avg Speed: %.2f | Max: %.2f", st.avgSpeed, st.maxSpeed);
+                ImGui::Text("Coherence: %.1f", st.coherence);
+                if (st.meanNeighbors >= 0.f) ImGui::Text("Neighbors: %.1f (mean)", st.meanNeighbors);
+                else                         ImGui::Text("Neighbors: n/a (%s)", engineName);
+                ImGui::Text("Bounds: (%.0f, %.0f) - (%.0f, %.0f)", st.minX, st.minY, st.maxX, st.maxY);
                 ImGui::Text("Status: %s", paused ? "PAUSED" : "Running");
                 ImGui::Text("Background: %s | Boids: %s",
                             opt.useSunset ? "Sunset" : "Plano",
                             opt.darkBoids ? "Oscuros" : "Originales");
                 ImGui::Text("B: change background | C: change color boids");
-                ImGui::Text("P: change parallel/secuencial mode");
+                ImGui::Text("P: next simulation engine");
+                if (ImGui::CollapsingHeader("Performance")) {
+                    const BoidParams& shownParams = snap ? snap->species.params[0] : flock.getParams();
+                    if (dashboard.draw(shown, shownParams, opt.width, opt.height, knobs)) {
+                        withFlock([k = knobs, t = governor.threads(knobs.threads)](FlockingSystem& f) {
+                            f.setThreads(t);
+                            f.setSchedule(k.schedule, k.chunk);
+                            f.setCellSize(k.cellSize);
+                            if (f.getSortInterval() != k.sortInterval) f.setSortInterval(k.sortInterval);
+                            f.setTheta(k.theta);
+                        });
+                    }
+                    dashboardShown = true;
+                }
+                if (ImGui::CollapsingHeader("Power")) {
+                    const float cpu = cpuMeter.last();
+                    ImGui::Text("CPU: %.2f cores (%.0f%% of %d)", cpu, 100.f * cpu / numProcs, numProcs);
+                    ImGui::Text("Quality: %d/%d (%d Hz, %d threads, %s)", governor.level(), QualityGovernor::LEVELS - 1,
+                                simHz, governor.threads(knobs.threads),
+                                governor.detail() == BoidDetail::Full ? "triangles" : "dots");
+                    ImGui::Text("Frame work: %.2f ms (smoothed)", governor.smoothedMs());
+                    float budget = governor.getBudget();
+                    if (ImGui::SliderFloat("Frame budget", &budget, 0.f, 33.f, budget <= 0.f ? "off" : "%.1f ms")) {
+                        governor.setBudget(budget);
+                        applyQuality();
+                    }
+                }
+                if (ImGui::CollapsingHeader("Flocking")) {
+                    FlockParams& f = flockKnobs;
+                    bool changed = false;
+                    bool sep = f.rules & RULE_SEPARATION, ali = f.rules & RULE_ALIGNMENT;
+                    bool coh = f.rules & RULE_COHESION, bias = f.rules & RULE_BIAS;
+                    changed |= ImGui::Checkbox("Separation", &sep); ImGui::SameLine();
+                    changed |= ImGui::Checkbox("Alignment", &ali);  ImGui::SameLine();
+                    changed |= ImGui::Checkbox("Cohesion", &coh);   ImGui::SameLine();
+                    changed |= ImGui::Checkbox("Bias", &bias);
+                    f.rules = (sep ? RULE_SEPARATION : 0u) | (ali ? RULE_ALIGNMENT : 0u) |
+                              (coh ? RULE_COHESION : 0u) | (bias ? RULE_BIAS : 0u);
+                    changed |= ImGui::SliderFloat("Separation weight", &f.separationWeight, 0.f, 5.f);
+                    changed |= ImGui::SliderFloat("Alignment weight", &f.alignmentWeight, 0.f, 5.f);
+                    changed |= ImGui::SliderFloat("Cohesion weight", &f.cohesionWeight, 0.f, 5.f);
+                    changed |= ImGui::SliderFloat("Bias weight", &f.biasWeight, 0.f, 5.f);
+                    changed |= ImGui::SliderFloat("Drift", &f.driftX, -1.f, 1.f);
+                    changed |= ImGui::SliderFloat("Corridor height", &f.corridorY, 0.f, 1.f);
+                    changed |= ImGui::SliderFloat("Climb band", &f.climbBand, 0.05f, 1.f);
+                    changed |= ImGui::SliderFloat("Climb", &f.climb, 0.f, 2.f);
+                    changed |= ImGui::SliderFloat("Sink", &f.sink, 0.f, 1.f);
+                    changed |= ImGui::SliderFloat("Bias speed", &f.biasSpeed, 0.f, 1.f);
+                    changed |= ImGui::SliderFloat("Corridor gain", &f.corridorGain, 0.f, 2.f);
+                    changed |= ImGui::SliderFloat("Bias force", &f.biasForce, 0.f, 1.f);
+                    if (ImGui::Button("Reset")) { f = FlockParams(); changed = true; }
+                    if (changed) withFlock([f](FlockingSystem& fs) { fs.setFlockParams(0, f); });
+                }
                 ImGui::Separator();
                 ImGui::Text("Controls:");
                 ImGui::Text("  SPACE: Pause/Resume");
-                ImGui::Text("  P: Toggle parallel mode");
+                ImGui::Text("  P: Cycle engines");
                 ImGui::Text("  Click: Add boid");
+                ImGui::Text("  Right click: Remove boid");
                 ImGui::Text("  +/-: Add/remove 50 boids");
                 ImGui::End();
             } else {
@@ -1275,9 +1916,11 @@ int main(int argc, char** argv) {
                     ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | 
                     ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoMove);
                 ImGui::Text("Boids: %zu | FPS: %.0f | %s", 
-                           flock.getBoidCount(), fps, 
-                           opt.useParallel ? "PAR" : "SER");
-                ImGui::Text("SPACE: pause | P: mode | S: stats");
+                           shown.size(), fps, 
+                           engineName);
+                ImGui::Text("SPACE: pause | P: engine | S: stats");
+                if (lowPower) ImGui::Text("Quality %d/%d | CPU %.0f%%", governor.level(), QualityGovernor::LEVELS - 1,
+                                          100.f * cpuMeter.last() / numProcs);
                 if (paused) ImGui::TextColored(ImVec4(1,1,0,1), "PAUSED");
                 ImGui::End();
             }
@@ -1288,10 +1931,32 @@ int main(int argc, char** argv) {
         }
 
         // FINALLY, SHOW CURRENT FRAMEBUFFER ON WINDOW!
-        SDL_RenderPresent(renderer);
+        auto presentStart = std::chrono::high_resolution_clock::now();
+        {
+            TRACE_SCOPE("render.present");
+            SDL_RenderPresent(renderer);
+        }
         
         auto renderEnd = std::chrono::high_resolution_clock::now();
         lastRenderTime = std::chrono::duration_cast<std::chrono::microseconds>(renderEnd - renderStart);
+        lastPresentTime = std::chrono::duration_cast<std::chrono::microseconds>(renderEnd - presentStart);
+
+        if (!dashboardShown) dashboard.hide();
+        dashboard.addFrame(lastFlockingTime.count() / 1000.f,
+                           (lastRenderTime - lastPresentTime).count() / 1000.f,
+                           lastPresentTime.count() / 1000.f);
+
+        // Work of this frame without pacing and vsync waits (the simulation thread's, when pipelined)
+        const float workMs = (lastFlockingTime + lastRenderTime - lastPresentTime).count() / 1000.f;
+        cpuMeter.sample();
+        if (governor.addFrame(workMs)) {
+            applyQuality();
+            std::cout << "Quality: " << governor.level() << " (" << simHz << " Hz, "
+                      << governor.threads(knobs.threads) << " threads, "
+                      << (governor.detail() == BoidDetail::Full ? "triangles" : "dots") << ")\n";
+        }
+
+        pacer.wait();
 
         // Calculate FPS
         frameCount++;
@@ -1307,7 +1972,7 @@ int main(int argc, char** argv) {
             //     std::cout << "\rBoids: " << flock.getBoidCount() 
             //              << " | FPS: " << static_cast<int>(fps)
             //              << " | Flocking: " << lastFlockingTime.count() << "μs"
-            //              << " | " << (opt.useParallel ? "PAR" : "SER")
+            //              << " | " << flock.getEngineName()
             //              << " | " << (paused ? "PAUSED" : "Running")
             //              << std::flush;
             // }
@@ -1317,6 +1982,11 @@ int main(int argc, char** argv) {
 
     }
 
+    pipeline.stop();
+    recorder.close();
+    report_recording(recorder, opt);
+    if (!opt.tracePath.empty()) trace::dump(opt.tracePath);
+
     // Resources cleanup
     if (opt.showStats) {
         ImGui_ImplSDLRenderer2_Shutdown();
@@ -1324,6 +1994,7 @@ int main(int argc, char** argv) {
         ImGui::DestroyContext();
     }
 
+    sunset.release();
     SDL_DestroyRenderer(renderer); // This also destroys any associated textures
     SDL_DestroyWindow(window); // This also destroys the renderer
     IMG_Quit(); // Quit SDL_image
@@ -0,0 +1,102 @@
+#include "numa.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <omp.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace numa {
+
+namespace {
+
+// Sets 'name' to 'value'; true if that changed it
+bool setEnv(const char* name, const std::string& value) {
+    if (value.empty()) return false;
+    const char* old = std::getenv(name);
+    if (old && value == old) return false;
+#ifdef _WIN32
+    _putenv_s(name, value.c_str());
+#else
+    setenv(name, value.c_str(), 1);
+#endif
+    return true;
+}
+
+const char* bindName(omp_proc_bind_t b) {
+    switch (b) {
+        case omp_proc_bind_false:  return "false";
+        case omp_proc_bind_true:   return "true";
+        case omp_proc_bind_master: return "master";
+        case omp_proc_bind_close:  return "close";
+        case omp_proc_bind_spread: return "spread";
+    }
+    return "?";
+}
+
+} // namespace
+
+void applyPlacement(const std::string& bind, const std::string& places, char** argv,
+                    const std::string& waitPolicy) {
+    bool changed = setEnv("OMP_PROC_BIND", bind);
+    changed |= setEnv("OMP_PLACES", places);
+    changed |= setEnv("OMP_WAIT_POLICY", waitPolicy);
+    if (!changed) return;
+#ifdef __linux__
+    // Same binary and arguments; this time the environment already matches, so no loop
+    execv("/proc/self/exe", argv);
+    std::cerr << "[Warn] No se pudo reiniciar con OMP_PROC_BIND/OMP_PLACES/OMP_WAIT_POLICY; exporta las variables antes de lanzar\n";
+#else
+    (void)argv;
+#endif
+}
+
+int nodeCount() {
+#ifdef __linux__
+    // "0" or "0-1" or "0-1,4-5"
+    std::ifstream in("/sys/devices/system/node/online");
+    std::string list;
+    if (!(in >> list)) return 1;
+    int count = 0;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        const size_t dash = range.find('-');
+        const int a = std::atoi(range.c_str());
+        const int b = dash == std::string::npos ? a : std::atoi(range.c_str() + dash + 1);
+        count += b - a + 1;
+    }
+    return count > 0 ? count : 1;
+#else
+    return 1;
+#endif
+}
+
+std::string describePlacement(int threads) {
+    std::vector<int> cpu(threads, -1), node(threads, -1);
+    #pragma omp parallel num_threads(threads)
+    {
+        const int t = omp_get_thread_num();
+#ifdef __linux__
+        unsigned c = 0, n = 0;
+        if (syscall(SYS_getcpu, &c, &n, nullptr) == 0) { cpu[t] = (int)c; node[t] = (int)n; }
+#endif
+    }
+
+    std::ostringstream out;
+    const char* places = std::getenv("OMP_PLACES");
+    out << "proc_bind=" << bindName(omp_get_proc_bind()) << " places=" << (places ? places : "-")
+        << " (" << omp_get_num_places() << ") nodos=" << nodeCount() << ":";
+    for (int t = 0; t < threads; ++t) {
+        out << " t" << t << " ";
+        if (cpu[t] < 0) out << "?";
+        else out << "cpu" << cpu[t] << "/n" << node[t];
+    }
+    return out.str();
+}
+
+} // namespace numa
@@ -0,0 +1,23 @@
+#pragma once
+#include <string>
+
+// Thread placement on NUMA machines. OpenMP binds its threads from OMP_PROC_BIND
+// and OMP_PLACES, which the runtime reads once when it starts (libgomp: when the
+// program is loaded), so they have to be in the environment before main().
+namespace numa {
+
+// Sets OMP_PROC_BIND, OMP_PLACES and OMP_WAIT_POLICY (empty = leave as is). When that
+// changes the environment, the process re-executes itself so the runtime starts with
+// the new values; it only returns (with a warning) if re-executing is not possible.
+// Call it first thing in main(), before any OpenMP call.
+void applyPlacement(const std::string& bind, const std::string& places, char** argv,
+                    const std::string& waitPolicy = "");
+
+// NUMA nodes of this machine (1 when unknown)
+int nodeCount();
+
+// Where 'threads' OpenMP threads run: binding policy, places, and the CPU and
+// NUMA node of every thread ("t0 cpu0/n0 t1 cpu1/n0 ...")
+std::string describePlacement(int threads);
+
+} // namespace numa
@@ -0,0 +1,69 @@
+#include "perf_counters.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace perfCounters {
+
+namespace {
+
+enum Counter { REFERENCES, MISSES, L1D_MISSES, COUNTERS };
+int gFd[COUNTERS] = {-1, -1, -1};
+bool gOpened = false;
+
+#ifdef __linux__
+int openCounter(uint32_t type, uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.inherit = 1;          // threads spawned later (OpenMP pool, pipeline) add to the totals
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // This process on any CPU
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+uint64_t readCounter(int fd) {
+    uint64_t v = 0;
+    if (fd < 0 || ::read(fd, &v, sizeof(v)) != (ssize_t)sizeof(v)) return 0;
+    return v;
+}
+#endif
+
+} // namespace
+
+bool open() {
+#ifdef __linux__
+    if (!gOpened) {
+        gOpened = true;
+        gFd[REFERENCES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES);
+        gFd[MISSES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        gFd[L1D_MISSES] = openCounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                                      (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    }
+#endif
+    return available();
+}
+
+bool available() {
+    return gFd[MISSES] >= 0;
+}
+
+CacheCounts read() {
+    CacheCounts c;
+#ifdef __linux__
+    c.references = readCounter(gFd[REFERENCES]);
+    c.misses = readCounter(gFd[MISSES]);
+    c.l1dMisses = readCounter(gFd[L1D_MISSES]);
+#endif
+    return c;
+}
+
+} // namespace perfCounters
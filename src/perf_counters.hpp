@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+
+// Hardware cache counters of the whole process (Linux perf_event_open). The
+// counters are inherited by threads created after open(), so call it before the
+// first OpenMP region and the worker pool is counted too. Where the kernel
+// refuses (perf_event_paranoid, containers, other systems) available() stays
+// false and read() returns zeros.
+namespace perfCounters {
+
+struct CacheCounts {
+    uint64_t references = 0;   // last-level cache accesses
+    uint64_t misses = 0;       // last-level cache misses
+    uint64_t l1dMisses = 0;    // L1 data cache read misses (0 where the CPU has no such event)
+
+    CacheCounts operator-(const CacheCounts& o) const {
+        return { references - o.references, misses - o.misses, l1dMisses - o.l1dMisses };
+    }
+};
+
+// Opens the counters once; true when at least the cache-miss counter works
+bool open();
+bool available();
+
+// Totals since open()
+CacheCounts read();
+
+} // namespace perfCounters
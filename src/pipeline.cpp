@@ -0,0 +1,125 @@
+#include "pipeline.hpp"
+#include <algorithm>
+#include "trace.hpp"
+
+void SimPipeline::start(FlockingSystem& f, int simHz, int steps) {
+    stop();
+    flock = &f;
+    setSimHz(simHz);
+    maxSteps = std::max(steps, 1);
+
+    // Seed all slots so acquire() is valid before the first step
+    for (auto& s : slots) {
+        fill(s);
+        s.stamp = std::chrono::steady_clock::now();
+    }
+    back = 0; front = 1; middle.store(2);
+
+    running.store(true);
+    worker = std::thread(&SimPipeline::run, this);
+}
+
+void SimPipeline::stop() {
+    if (!running.exchange(false)) return;
+    if (worker.joinable()) worker.join();
+}
+
+void SimPipeline::setSimHz(int simHz) {
+    dtTicks.store(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                      std::chrono::duration<double>(1.0 / std::max(simHz, 1))).count(),
+                  std::memory_order_relaxed);
+}
+
+void SimPipeline::post(Command cmd) {
+    std::lock_guard<std::mutex> lock(cmdMutex);
+    commands.push_back(std::move(cmd));
+}
+
+// Copies what rendering needs from the flock
+void SimPipeline::fill(FrameSnapshot& s) const {
+    s.cur = flock->state();
+    s.prevCount = flock->previousCount();
+    if (s.prevCount > 0) s.prev = flock->previousState();
+    s.colors = flock->getColors();
+    s.drawOrder = flock->getDrawOrder();
+    s.species = flock->getSpecies();
+    s.stats = flock->getStats();
+    s.width = flock->getWidth();
+    s.height = flock->getHeight();
+    s.engine = flock->getEngineName();
+    s.usesKernel = flock->usesKernel();
+}
+
+// Fills the back slot and swaps it into the middle
+void SimPipeline::publish() {
+    TRACE_SCOPE("pipeline.publish");
+    fill(slots[back]);
+    back = middle.exchange(back | NEW_BIT, std::memory_order_acq_rel) & ~NEW_BIT;
+}
+
+const FrameSnapshot& SimPipeline::acquire() {
+    if (middle.load(std::memory_order_relaxed) & NEW_BIT)
+        front = middle.exchange(front, std::memory_order_acq_rel) & ~NEW_BIT;
+    return slots[front];
+}
+
+float SimPipeline::alpha(const FrameSnapshot& snap) const {
+    const auto since = std::chrono::steady_clock::now() - snap.stamp;
+    return std::clamp((float)since.count() / (float)period().count(), 0.f, 1.f);
+}
+
+void SimPipeline::run() {
+    using clock = std::chrono::steady_clock;
+    trace::setThreadName("sim");
+    std::vector<Command> pending;
+    auto next = clock::now();
+
+    while (running.load(std::memory_order_relaxed)) {
+        {
+            std::lock_guard<std::mutex> lock(cmdMutex);
+            pending.swap(commands);
+        }
+        for (auto& cmd : pending) cmd(*flock);
+        const bool changed = !pending.empty();
+        pending.clear();
+
+        if (paused.load(std::memory_order_relaxed)) {
+            if (changed) publish();
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            next = clock::now();
+            continue;
+        }
+
+        if (clock::now() < next) {
+            std::this_thread::sleep_until(next);
+            continue;
+        }
+
+        // Same fixed-timestep rules as the sequential loop: at most maxSteps to
+        // catch up, then the backlog is dropped
+        const auto dt = period();
+        const auto t0 = clock::now();
+        int steps = 0;
+        while (next <= clock::now() && steps < maxSteps) {
+            flock->update();
+            next += dt;
+            ++steps;
+        }
+        if (next <= clock::now()) next = clock::now() + dt;
+        const auto t1 = clock::now();
+
+        FrameSnapshot& s = slots[back];
+        s.steps = steps;
+        s.stepUs = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+        s.stamp = next - dt;
+        publish();
+    }
+}
+
+void renderSnapshot(SDL_Renderer* renderer, BoidBatch& batch, const FrameSnapshot& snap,
+                    bool darkBoids, float alpha) {
+    // Same wrap threshold as FlockingSystem::render
+    const float maxJump = 0.5f * std::min(snap.width, snap.height);
+    batch.draw(renderer, snap.cur, snap.colors.data(), boidPalette(), snap.species, darkBoids,
+               &snap.prev, snap.prevCount, alpha, maxJump, snap.drawOrder.data());
+}
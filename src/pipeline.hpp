@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "flock.hpp"
+
+// Everything the render thread needs from one simulation step
+struct FrameSnapshot {
+    BoidState cur, prev;           // last step and the one before it (for interpolation)
+    size_t prevCount = 0;          // leading boids valid in 'prev'
+    std::vector<ColorIndex> colors; // palette indices (see boidPalette)
+    std::vector<uint32_t> drawOrder; // position of every boid in the draw order
+    SpeciesTable species;          // parameters and buckets of 'cur'
+    FlockStats stats;
+    int width = 0, height = 0;
+    const char* engine = "";
+    bool usesKernel = true;
+    int steps = 0;                 // steps run since the previous snapshot
+    long long stepUs = 0;          // time spent in those steps
+    std::chrono::steady_clock::time_point stamp; // simulated time of 'cur'
+};
+
+// Runs FlockingSystem::update on its own thread at a fixed rate while the main
+// thread renders. Snapshots are handed over through a triple buffer: the
+// simulation writes the back slot, the renderer reads the front slot and they
+// swap through an atomic middle slot, so neither side ever waits for the other.
+// Any change to the flock must go through post() once the pipeline is started.
+class SimPipeline {
+public:
+    using Command = std::function<void(FlockingSystem&)>;
+
+    ~SimPipeline() { stop(); }
+
+    void start(FlockingSystem& flock, int simHz, int maxSteps);
+    void stop();
+
+    // Queues a change to run on the simulation thread before its next step
+    void post(Command cmd);
+
+    void setPaused(bool p) { paused.store(p, std::memory_order_relaxed); }
+    // Changes the step rate while running (takes effect from the next step)
+    void setSimHz(int simHz);
+
+    // Latest published snapshot (the same one until a newer step is published)
+    const FrameSnapshot& acquire();
+
+    // Interpolation factor of 'snap' at the current time, in [0, 1]
+    float alpha(const FrameSnapshot& snap) const;
+
+private:
+    void run();
+    void fill(FrameSnapshot& s) const;
+    void publish();
+
+    static constexpr int NEW_BIT = 4;  // set in 'middle' when it holds an unread snapshot
+
+    FlockingSystem* flock = nullptr;
+    std::atomic<std::chrono::steady_clock::rep> dtTicks{1};  // step period, steady_clock ticks
+    std::chrono::steady_clock::duration period() const {
+        return std::chrono::steady_clock::duration(dtTicks.load(std::memory_order_relaxed));
+    }
+    int maxSteps = 1;
+
+    FrameSnapshot slots[3];
+    int back = 0, front = 1;           // owned by the simulation / render thread
+    std::atomic<int> middle{2};
+
+    std::mutex cmdMutex;
+    std::vector<Command> commands;
+
+    std::atomic<bool> running{false};
+    std::atomic<bool> paused{false};
+    std::thread worker;
+};
+
+// Draws a snapshot's boids, interpolated by alpha
+void renderSnapshot(SDL_Renderer* renderer, BoidBatch& batch, const FrameSnapshot& snap,
+                    bool darkBoids, float alpha);
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Handle to one boid that survives removals of other boids. The boids themselves
+// stay densely packed (engines and SIMD kernels stream the SoA arrays), so a
+// removal moves another boid into the hole and only the handle table changes.
+struct BoidHandle {
+    uint32_t slot = UINT32_MAX;
+    uint32_t generation = 0;   // bumped on every removal, so stale handles never alias
+
+    bool valid() const { return slot != UINT32_MAX; }
+};
+
+// Slot <-> dense index map with a free list: every operation is O(1).
+class HandleTable {
+    std::vector<uint32_t> denseOf;     // slot -> dense index
+    std::vector<uint32_t> generation;  // slot -> current generation
+    std::vector<uint32_t> slotOf;      // dense index -> slot
+    std::vector<uint32_t> freeSlots;
+
+public:
+    void reserve(size_t n) {
+        denseOf.reserve(n); generation.reserve(n); slotOf.reserve(n); freeSlots.reserve(n);
+    }
+
+    void clear() { denseOf.clear(); generation.clear(); slotOf.clear(); freeSlots.clear(); }
+
+    size_t size() const { return slotOf.size(); }
+
+    // Grows or shrinks the dense range; new indices have no handle until bind()
+    void resize(size_t n) { slotOf.resize(n, UINT32_MAX); }
+
+    // New handle for the boid at dense index 'index'
+    BoidHandle bind(size_t index) {
+        uint32_t slot;
+        if (!freeSlots.empty()) { slot = freeSlots.back(); freeSlots.pop_back(); }
+        else { slot = (uint32_t)denseOf.size(); denseOf.push_back(0); generation.push_back(0); }
+        denseOf[slot] = (uint32_t)index;
+        slotOf[index] = slot;
+        return { slot, generation[slot] };
+    }
+
+    // Dense index of a live handle; false if it was removed
+    bool find(BoidHandle h, size_t& index) const {
+        if (h.slot >= denseOf.size() || generation[h.slot] != h.generation) return false;
+        index = denseOf[h.slot];
+        return true;
+    }
+
+    BoidHandle handleAt(size_t index) const {
+        const uint32_t slot = slotOf[index];
+        return { slot, generation[slot] };
+    }
+
+    // The boid at 'from' now lives at 'to' (whatever was at 'to' must be released or moved)
+    void move(size_t from, size_t to) {
+        const uint32_t slot = slotOf[from];
+        slotOf[to] = slot;
+        denseOf[slot] = (uint32_t)to;
+    }
+
+    // The boids were reordered: new dense index i holds the boid that was at from[i]
+    void permute(const uint32_t* from, std::vector<uint32_t>& scratch) {
+        const size_t n = slotOf.size();
+        scratch.resize(n);
+        for (size_t i = 0; i < n; ++i) scratch[i] = slotOf[from[i]];
+        slotOf.swap(scratch);
+        for (size_t i = 0; i < n; ++i)
+            if (slotOf[i] != UINT32_MAX) denseOf[slotOf[i]] = (uint32_t)i;
+    }
+
+    // Invalidates the handle of the boid at 'index'
+    void release(size_t index) {
+        const uint32_t slot = slotOf[index];
+        ++generation[slot];
+        freeSlots.push_back(slot);
+        slotOf[index] = UINT32_MAX;
+    }
+};
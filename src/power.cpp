@@ -0,0 +1,72 @@
+#include "power.hpp"
+#include <algorithm>
+#include <ctime>
+#ifdef __unix__
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// Best quality first; detail goes first since it only costs looks
+const QualityGovernor::Level LADDER[QualityGovernor::LEVELS] = {
+    {1, 1, BoidDetail::Full},
+    {1, 1, BoidDetail::Dots},
+    {2, 1, BoidDetail::Dots},
+    {2, 2, BoidDetail::Dots},
+    {4, 2, BoidDetail::Dots},
+    {4, 4, BoidDetail::Dots},
+};
+
+constexpr float EMA_WEIGHT = 0.1f;     // of the newest frame
+constexpr int SETTLE_DOWN = 30;        // frames at a level before stepping down again
+constexpr int SETTLE_UP = 180;         // frames well under the budget before stepping up
+constexpr float HEADROOM = 0.5f;       // "well under": below this fraction of the budget
+
+// Seconds of CPU time of every thread of the process
+double processCpuSeconds() {
+#ifdef __unix__
+    rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0)
+        return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1e-6;
+#endif
+    return (double)std::clock() / CLOCKS_PER_SEC;
+}
+
+} // namespace
+
+void QualityGovernor::setBudget(float ms) {
+    budgetMs = std::max(ms, 0.f);
+    if (!enabled()) current = 0;
+    framesAtLevel = 0;
+}
+
+const QualityGovernor::Level& QualityGovernor::settings() const {
+    return LADDER[current];
+}
+
+bool QualityGovernor::addFrame(float workMs) {
+    emaMs = emaMs == 0.f ? workMs : emaMs + EMA_WEIGHT * (workMs - emaMs);
+    if (!enabled()) return false;
+    ++framesAtLevel;
+
+    int next = current;
+    if (emaMs > budgetMs && framesAtLevel >= SETTLE_DOWN && current + 1 < LEVELS) next = current + 1;
+    else if (emaMs < budgetMs * HEADROOM && framesAtLevel >= SETTLE_UP && current > 0) next = current - 1;
+    if (next == current) return false;
+    current = next;
+    framesAtLevel = 0;
+    return true;
+}
+
+CpuMeter::CpuMeter() : wallStart(clock::now()), cpuStart(processCpuSeconds()) {}
+
+float CpuMeter::sample() {
+    const clock::time_point now = clock::now();
+    const double wall = std::chrono::duration<double>(now - wallStart).count();
+    if (wall < 1.0) return cores;
+    const double cpu = processCpuSeconds();
+    cores = (float)((cpu - cpuStart) / wall);
+    wallStart = now;
+    cpuStart = cpu;
+    return cores;
+}
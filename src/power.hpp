@@ -0,0 +1,60 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include "batch.hpp"
+
+// Low-power mode (--low-power, --frame-budget): a quality ladder driven by the
+// measured work time of each frame, and the process CPU utilization as a power proxy.
+//
+// Level 0 is full quality; every level down gives up one more of boid detail,
+// simulation rate and threads. The governor steps down when the smoothed frame
+// time stays over the budget and back up only after a longer stretch well under
+// it, so it does not oscillate around the budget.
+class QualityGovernor {
+public:
+    struct Level {
+        int simHzDiv;        // simulation rate = full rate / simHzDiv
+        int threadDiv;       // OpenMP threads = full threads / threadDiv (at least 1)
+        BoidDetail detail;
+    };
+    static constexpr int LEVELS = 6;
+
+    // Frame budget in milliseconds (0 = off: always level 0)
+    void setBudget(float ms);
+    float getBudget() const { return budgetMs; }
+    bool enabled() const { return budgetMs > 0.f; }
+
+    // Work time of the last frame (simulation + rendering, without pacing or vsync
+    // waits); true when the level changed
+    bool addFrame(float workMs);
+
+    int level() const { return current; }
+    float smoothedMs() const { return emaMs; }
+    const Level& settings() const;
+
+    int simHz(int fullHz) const { return std::max(fullHz / settings().simHzDiv, 1); }
+    int threads(int fullThreads) const { return std::max(fullThreads / settings().threadDiv, 1); }
+    BoidDetail detail() const { return settings().detail; }
+
+private:
+    float budgetMs = 0.f;
+    float emaMs = 0.f;
+    int current = 0;
+    int framesAtLevel = 0;   // frames since the last change (settling time)
+};
+
+// CPU time used by the whole process (every thread) per second of wall time
+class CpuMeter {
+public:
+    CpuMeter();
+    // Utilization since the previous sample() in cores (1 = one core fully busy);
+    // refreshed at most once per second, the last value is returned in between
+    float sample();
+    float last() const { return cores; }
+
+private:
+    using clock = std::chrono::steady_clock;
+    clock::time_point wallStart;
+    double cpuStart = 0.0;
+    float cores = 0.f;
+};
@@ -0,0 +1,336 @@
+#include "recording.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Frame payloads (every array padded to 4 bytes):
+//   key:   start[species + 1] (u32), r[species] (f32), colors[count] (u8),
+//          qx[count], qy[count] (u16), qvx[count], qvy[count] (i16)
+//   delta: dx[count], dy[count] (i8, ESCAPE = stored in full below),
+//          qvx[count], qvy[count] (i16), escapes[escapes] (u32 index, u16 qx, u16 qy)
+enum : uint32_t { FRAME_KEY = 0, FRAME_DELTA = 1 };
+constexpr int8_t ESCAPE = -128;
+
+static size_t align4(size_t n) { return (n + 3) & ~(size_t)3; }
+
+// Appends n values and pads to 4 bytes
+template <class T>
+static void put(std::vector<uint8_t>& out, const T* src, size_t n) {
+    const size_t at = out.size();
+    out.resize(align4(at + n * sizeof(T)), 0);
+    std::memcpy(out.data() + at, src, n * sizeof(T));
+}
+
+// Reads n values at 'at' (advanced past the padding); false past 'end'
+template <class T>
+static bool get(const uint8_t* base, size_t& at, size_t end, T* dst, size_t n) {
+    const size_t bytes = n * sizeof(T);
+    if (at + bytes > end) return false;
+    std::memcpy(dst, base + at, bytes);
+    at = align4(at + bytes);
+    return true;
+}
+
+// Position scale: quanta per pixel over [-margin, extent + margin]
+static float positionScale(float extent, float margin) { return 65535.f / (extent + 2.f * margin); }
+
+static uint16_t quantizePosition(float x, float scale, float margin) {
+    return (uint16_t)std::clamp(std::lround((x + margin) * scale), 0L, 65535L);
+}
+
+static int16_t quantizeVelocity(float v, float range) {
+    return (int16_t)std::clamp(std::lround(v / range * 32767.f), -32767L, 32767L);
+}
+
+bool FlockRecorder::open(const std::string& filePath, const RecordingHeader& h, bool useDelta) {
+    close();
+    path = filePath;
+    header = h;
+    header.keyInterval = std::max<uint32_t>(header.keyInterval, 1);
+    header.speedRange = std::max(header.speedRange, 1e-3f);
+    delta = useDelta;
+    written = 0;
+    qx.clear(); qy.clear(); lastColors.clear(); lastStart.clear();
+
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "[Error] No se pudo crear " << path << "\n";
+        return false;
+    }
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+        std::cerr << "[Error] Escritura fallida en " << path << "\n";
+        close();
+        return false;
+    }
+    totalBytes = sizeof(header);
+    return true;
+}
+
+void FlockRecorder::close() {
+    if (file) std::fclose(file);
+    file = nullptr;
+}
+
+bool FlockRecorder::append(const BoidState& state, const uint8_t* colors, const SpeciesTable& species) {
+    if (!file) return false;
+    const size_t n = state.size();
+    const int numSpecies = species.count();
+    const float sx = positionScale((float)header.width, header.margin);
+    const float sy = positionScale((float)header.height, header.margin);
+
+    const bool key = !delta || written % header.keyInterval == 0 || n != qx.size() ||
+                     species.start != lastStart || std::memcmp(colors, lastColors.data(), n) != 0;
+
+    RecordingFrameHeader fh{key ? FRAME_KEY : FRAME_DELTA, (uint32_t)n, (uint32_t)numSpecies, 0, 0};
+    out.assign(sizeof(fh), 0);
+
+    if (key) {
+        const std::vector<uint32_t> start(species.start.begin(), species.start.end());
+        std::vector<float> r(numSpecies);
+        for (int s = 0; s < numSpecies; ++s) r[s] = species.params[s].r;
+        put(out, start.data(), start.size());
+        put(out, r.data(), r.size());
+        put(out, colors, n);
+
+        qx.resize(n); qy.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            qx[i] = quantizePosition(state.px[i], sx, header.margin);
+            qy[i] = quantizePosition(state.py[i], sy, header.margin);
+        }
+        put(out, qx.data(), n);
+        put(out, qy.data(), n);
+        lastColors.assign(colors, colors + n);
+        lastStart = species.start;
+    } else {
+        // Deltas against the previous quantized frame (updated in place), so the
+        // reader reconstructs exactly what was quantized and errors never accumulate
+        dx.resize(n); dy.resize(n);
+        escapes.clear();
+        for (size_t i = 0; i < n; ++i) {
+            const uint16_t nx = quantizePosition(state.px[i], sx, header.margin);
+            const uint16_t ny = quantizePosition(state.py[i], sy, header.margin);
+            const int ddx = (int)nx - (int)qx[i], ddy = (int)ny - (int)qy[i];
+            if (ddx > ESCAPE && ddx < 128 && ddy > ESCAPE && ddy < 128) {
+                dx[i] = (int8_t)ddx; dy[i] = (int8_t)ddy;
+            } else {
+                dx[i] = ESCAPE; dy[i] = 0;
+                escapes.push_back({(uint32_t)i, nx, ny});
+            }
+            qx[i] = nx; qy[i] = ny;
+        }
+        put(out, dx.data(), n);
+        put(out, dy.data(), n);
+        fh.escapes = (uint32_t)escapes.size();
+    }
+
+    qv.resize(n);
+    for (size_t i = 0; i < n; ++i) qv[i] = quantizeVelocity(state.vx[i], header.speedRange);
+    put(out, qv.data(), n);
+    for (size_t i = 0; i < n; ++i) qv[i] = quantizeVelocity(state.vy[i], header.speedRange);
+    put(out, qv.data(), n);
+    if (!key) put(out, escapes.data(), escapes.size());
+
+    fh.bytes = out.size();
+    std::memcpy(out.data(), &fh, sizeof(fh));
+    if (std::fwrite(out.data(), 1, out.size(), file) != out.size()) {
+        std::cerr << "[Error] Escritura fallida en " << path << "\n";
+        close();
+        return false;
+    }
+    ++written;
+    totalBytes += out.size();
+    return true;
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+#ifdef _WIN32
+    HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (f == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(f, &size) || size.QuadPart == 0) { CloseHandle(f); return false; }
+    HANDLE m = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* view = m ? MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (m) CloseHandle(m);
+        CloseHandle(f);
+        return false;
+    }
+    fileHandle = f;
+    mapping = m;
+    base = static_cast<const uint8_t*>(view);
+    length = (size_t)size.QuadPart;
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) { ::close(fd); return false; }
+    void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // the mapping keeps the file alive
+    if (view == MAP_FAILED) return false;
+    // Replay walks the file front to back
+    madvise(view, (size_t)st.st_size, MADV_SEQUENTIAL);
+    base = static_cast<const uint8_t*>(view);
+    length = (size_t)st.st_size;
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+    if (!base) return;
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+    CloseHandle(mapping);
+    CloseHandle(fileHandle);
+    mapping = fileHandle = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(base), length);
+#endif
+    base = nullptr;
+    length = 0;
+}
+
+bool FlockReplay::open(const std::string& path) {
+    frameOffsets.clear();
+    keyFrames.clear();
+    current = SIZE_MAX;
+    if (!map.open(path)) {
+        std::cerr << "[Error] No se pudo abrir " << path << "\n";
+        return false;
+    }
+    const RecordingHeader expected;
+    if (map.size() < sizeof(header)) {
+        std::cerr << "[Error] " << path << " no es una grabación de flock\n";
+        return false;
+    }
+    std::memcpy(&header, map.data(), sizeof(header));
+    if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0) {
+        std::cerr << "[Error] " << path << " no es una grabación de flock\n";
+        return false;
+    }
+    if (header.version != expected.version) {
+        std::cerr << "[Error] " << path << ": versión de grabación " << header.version
+                  << " no soportada (se espera " << expected.version << ")\n";
+        return false;
+    }
+
+    // Index the complete frames; a truncated last frame (recording interrupted) is dropped
+    size_t at = sizeof(header);
+    while (at + sizeof(RecordingFrameHeader) <= map.size()) {
+        RecordingFrameHeader fh;
+        std::memcpy(&fh, map.data() + at, sizeof(fh));
+        if (fh.bytes < sizeof(fh) || fh.bytes > map.size() - at) break;
+        // The counts size decode()'s buffers, so they must fit in the payload first (64-bit math:
+        // no wrap-around for any 32-bit value)
+        const uint64_t payload = fh.bytes - sizeof(fh);
+        if (fh.kind == FRAME_KEY) {
+            // Bucket offsets and radii, then color, position and velocity of every boid
+            const uint64_t need = ((uint64_t)fh.species + 1) * sizeof(uint32_t) + (uint64_t)fh.species * sizeof(float) +
+                                  (uint64_t)fh.count * (1 + 2 + 2 + 2 + 2);
+            if (fh.species == 0 || need > payload) break;
+            keyFrames.push_back(frameOffsets.size());
+        } else if (fh.kind == FRAME_DELTA) {
+            // 8-bit position deltas and velocities of every boid, then the escapes
+            const uint64_t need = (uint64_t)fh.count * 6 + (uint64_t)fh.escapes * sizeof(RecordingEscape);
+            if (need > payload) break;
+        } else {
+            break;
+        }
+        frameOffsets.push_back(at);
+        at += fh.bytes;
+    }
+    if (frameOffsets.empty() || keyFrames.front() != 0) {
+        std::cerr << "[Error] " << path << " no tiene frames válidos\n";
+        return false;
+    }
+    return true;
+}
+
+bool FlockReplay::decode(size_t k) {
+    const uint8_t* base = map.data();
+    size_t at = frameOffsets[k];
+    RecordingFrameHeader fh;
+    std::memcpy(&fh, base + at, sizeof(fh));
+    const size_t end = at + fh.bytes;
+    const size_t n = fh.count;
+    at += sizeof(fh);
+
+    if (fh.kind == FRAME_KEY) {
+        keyStart.resize((size_t)fh.species + 1);
+        radius.resize(fh.species);
+        colors.resize(n); qx.resize(n); qy.resize(n);
+        if (!get(base, at, end, keyStart.data(), keyStart.size()) || !get(base, at, end, radius.data(), radius.size()) ||
+            !get(base, at, end, colors.data(), n) ||
+            !get(base, at, end, qx.data(), n) || !get(base, at, end, qy.data(), n))
+            return false;
+        if (fh.species == 0 || keyStart.front() != 0 || keyStart.back() != n ||
+            !std::is_sorted(keyStart.begin(), keyStart.end()))
+            return false;
+        start.assign(keyStart.begin(), keyStart.end());
+    } else {
+        // Deltas apply to frame k - 1
+        if (current + 1 != k || n != qx.size()) return false;
+        dx.resize(n); dy.resize(n);
+        if (!get(base, at, end, dx.data(), n) || !get(base, at, end, dy.data(), n)) return false;
+        for (size_t i = 0; i < n; ++i) {
+            if (dx[i] == ESCAPE) continue;
+            qx[i] = (uint16_t)(qx[i] + dx[i]);
+            qy[i] = (uint16_t)(qy[i] + dy[i]);
+        }
+    }
+
+    qvx.resize(n); qvy.resize(n);
+    if (!get(base, at, end, qvx.data(), n) || !get(base, at, end, qvy.data(), n)) return false;
+    if (fh.kind == FRAME_DELTA) {
+        escapes.resize(fh.escapes);
+        if (!get(base, at, end, escapes.data(), escapes.size())) return false;
+        for (const RecordingEscape& e : escapes) {
+            if (e.index >= n) return false;
+            qx[e.index] = e.qx;
+            qy[e.index] = e.qy;
+        }
+    }
+    current = k;
+    return true;
+}
+
+bool FlockReplay::frame(size_t k, BoidState& state, std::vector<uint8_t>& outColors, SpeciesTable& species) {
+    if (k >= frameCount()) return false;
+    if (current == SIZE_MAX || k != current + 1 || std::binary_search(keyFrames.begin(), keyFrames.end(), k)) {
+        // Seek: decode forward from the key frame at or before k
+        const size_t key = *(std::upper_bound(keyFrames.begin(), keyFrames.end(), k) - 1);
+        current = SIZE_MAX;
+        for (size_t f = key; f < k; ++f)
+            if (!decode(f)) { current = SIZE_MAX; return false; }
+    }
+    if (!decode(k)) { current = SIZE_MAX; return false; }
+
+    const size_t n = qx.size();
+    const float sx = 1.f / positionScale((float)header.width, header.margin);
+    const float sy = 1.f / positionScale((float)header.height, header.margin);
+    const float sv = header.speedRange / 32767.f;
+    state.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        state.px[i] = qx[i] * sx - header.margin;
+        state.py[i] = qy[i] * sy - header.margin;
+        state.vx[i] = qvx[i] * sv;
+        state.vy[i] = qvy[i] * sv;
+    }
+    outColors = colors;
+    species.params.resize(radius.size());
+    for (size_t s = 0; s < radius.size(); ++s) species.params[s].r = radius[s];
+    species.start = start;
+    species.updateRadii();
+    return true;
+}
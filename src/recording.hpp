@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "engine.hpp"
+
+// Compact flock recordings (.flk): each frame's positions and velocities quantized to
+// 16-bit fixed point (positions relative to the window, velocities to the fastest
+// species). Key frames store every value; delta frames store 8-bit position deltas
+// against the previous frame, with the boids that moved further (wraps) listed apart.
+// A key frame is forced whenever the boids, buckets or colors change, and every
+// keyInterval frames so replay can seek.
+struct RecordingHeader {
+    char magic[4] = {'F', 'L', 'K', 'R'};
+    uint32_t version = 1;
+    int32_t width = 0, height = 0;
+    uint32_t simHz = 60;
+    uint32_t keyInterval = 60;
+    float margin = 32.f;       // quantized x range is [-margin, width + margin] (same for y)
+    float speedRange = 1.f;    // quantized velocity range is [-speedRange, speedRange]
+    uint64_t seed = 0;
+};
+
+// Per frame: RecordingFrameHeader, then the payload described in recording.cpp (4-byte aligned)
+struct RecordingFrameHeader {
+    uint32_t kind;             // FRAME_KEY | FRAME_DELTA
+    uint32_t count;            // boids
+    uint32_t species;          // buckets (key frames)
+    uint32_t escapes;          // boids stored in full in a delta frame
+    uint64_t bytes;            // whole frame, header included
+};
+
+// Boid of a delta frame that moved too far (or wrapped) for an 8-bit delta
+struct RecordingEscape {
+    uint32_t index;
+    uint16_t qx, qy;
+};
+
+class FlockRecorder {
+public:
+    ~FlockRecorder() { close(); }
+
+    // header.width/height/speedRange describe the flock being recorded; delta = false writes only key frames
+    bool open(const std::string& path, const RecordingHeader& header, bool delta = true);
+    // Appends the current state (call once per simulation step)
+    bool append(const BoidState& state, const uint8_t* colors, const SpeciesTable& species);
+    void close();
+
+    bool isOpen() const { return file != nullptr; }
+    uint64_t frames() const { return written; }
+    uint64_t bytes() const { return totalBytes; }
+
+private:
+    FILE* file = nullptr;
+    std::string path;
+    RecordingHeader header;
+    bool delta = true;
+    uint64_t written = 0, totalBytes = 0;
+
+    // Last frame as decoded by a reader, so deltas never drift
+    std::vector<uint16_t> qx, qy;
+    std::vector<uint8_t> lastColors;
+    std::vector<size_t> lastStart;
+    std::vector<uint8_t> out;           // frame being encoded, reused
+    std::vector<int8_t> dx, dy;
+    std::vector<int16_t> qv;
+    std::vector<RecordingEscape> escapes;
+};
+
+// Read-only memory map of a whole file
+class MappedFile {
+public:
+    ~MappedFile() { close(); }
+    bool open(const std::string& path);
+    void close();
+    const uint8_t* data() const { return base; }
+    size_t size() const { return length; }
+
+private:
+    const uint8_t* base = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mapping = nullptr;
+#endif
+};
+
+// Plays a recording back from a memory map. Sequential frames decode in O(boids);
+// any other frame is decoded from the key frame before it.
+class FlockReplay {
+public:
+    RecordingHeader header;
+
+    bool open(const std::string& path);
+    size_t frameCount() const { return frameOffsets.size(); }
+
+    // Decodes frame k into state (positions and velocities), colors and the species buckets
+    // (species parameters only carry the size r); false for a corrupt frame
+    bool frame(size_t k, BoidState& state, std::vector<uint8_t>& colors, SpeciesTable& species);
+
+private:
+    bool decode(size_t k);
+
+    MappedFile map;
+    std::vector<size_t> frameOffsets;   // byte offset of every complete frame
+    std::vector<size_t> keyFrames;      // indices of key frames, ascending
+
+    // Decoded state of frame 'current'
+    size_t current = SIZE_MAX;
+    std::vector<uint16_t> qx, qy;
+    std::vector<int16_t> qvx, qvy;
+    std::vector<uint8_t> colors;
+    std::vector<size_t> start;
+    std::vector<float> radius;
+
+    // Scratch of decode(), reused between frames
+    std::vector<uint32_t> keyStart;
+    std::vector<int8_t> dx, dy;
+    std::vector<RecordingEscape> escapes;
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+
+// Counter-based random numbers: every value is a pure function of
+// (seed, key, stream), so boids can be spawned in any order or in parallel
+// and still get bit-identical results. The mixer is the SplitMix64 finalizer.
+inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+struct CounterRng {
+    uint64_t seed = 0;
+
+    // 64 random bits for value 'stream' of item 'key'
+    uint64_t bits(uint64_t key, uint32_t stream) const {
+        return splitmix64(splitmix64(seed) ^ splitmix64((key << 8) | stream));
+    }
+
+    // Uniform float in [0, 1) (24 bits, exactly representable)
+    float uniform(uint64_t key, uint32_t stream) const {
+        return (float)(bits(key, stream) >> 40) * (1.0f / 16777216.0f);
+    }
+
+    // Uniform integer in [0, n)
+    uint32_t below(uint64_t key, uint32_t stream, uint32_t n) const {
+        return (uint32_t)(((bits(key, stream) >> 32) * n) >> 32);
+    }
+};
@@ -0,0 +1,61 @@
+#include "snapshot.hpp"
+#include <cstring>
+#include <iostream>
+
+bool SnapshotWriter::open(const std::string& file, const SnapshotHeader& header) {
+    path = file;
+    out.open(file, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "[Error] No se pudo crear " << file << "\n";
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return (bool)out;
+}
+
+bool SnapshotWriter::write(const BoidState& state) {
+    const std::streamsize bytes = (std::streamsize)(state.size() * sizeof(float));
+    for (const auto* a : {&state.px, &state.py, &state.vx, &state.vy})
+        out.write(reinterpret_cast<const char*>(a->data()), bytes);
+    if (!out) {
+        std::cerr << "[Error] Escritura fallida en " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool SnapshotReader::open(const std::string& file) {
+    path = file;
+    framesRead = 0;
+    in.open(file, std::ios::binary);
+    if (!in) {
+        std::cerr << "[Error] No se pudo abrir " << file << "\n";
+        return false;
+    }
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    const SnapshotHeader expected;
+    if (!in || std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0) {
+        std::cerr << "[Error] " << file << " no es un snapshot de flock\n";
+        return false;
+    }
+    if (header.version != expected.version) {
+        std::cerr << "[Error] " << file << ": versión de snapshot " << header.version
+                  << " no soportada (se espera " << expected.version << ")\n";
+        return false;
+    }
+    return true;
+}
+
+bool SnapshotReader::read(BoidState& state) {
+    if (framesRead >= header.frames) return false;
+    state.resize(header.boids);
+    const std::streamsize bytes = (std::streamsize)(header.boids * sizeof(float));
+    for (auto* a : {&state.px, &state.py, &state.vx, &state.vy})
+        in.read(reinterpret_cast<char*>(a->data()), bytes);
+    if (!in) {
+        std::cerr << "[Error] " << path << " termina en el frame " << framesRead << " de " << header.frames << "\n";
+        return false;
+    }
+    ++framesRead;
+    return true;
+}
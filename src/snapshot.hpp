@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "engine.hpp"
+
+// Binary state snapshots: a header, then the SoA state (px, py, vx, vy) of each
+// recorded frame. A file with several frames is a trajectory; --verify saves one
+// to compare later runs against (a golden trajectory kept by CI).
+// Floats are stored in native byte order (little endian on every supported target).
+struct SnapshotHeader {
+    char magic[4] = {'F', 'L', 'K', 'S'};
+    uint32_t version = 1;
+    uint32_t boids = 0;        // boids per frame
+    uint32_t frames = 0;       // frames in the file
+    int32_t width = 0, height = 0;
+    uint64_t seed = 0;
+};
+
+class SnapshotWriter {
+    std::ofstream out;
+    std::string path;
+
+public:
+    // Creates the file; header.frames must be the number of write() calls that follow
+    bool open(const std::string& file, const SnapshotHeader& header);
+    bool write(const BoidState& state);
+};
+
+class SnapshotReader {
+    std::ifstream in;
+    std::string path;
+    uint32_t framesRead = 0;
+
+public:
+    SnapshotHeader header;
+
+    bool open(const std::string& file);
+    // Next frame into state (resized to header.boids); false at the end or on a short file
+    bool read(BoidState& state);
+};
@@ -0,0 +1,113 @@
+#include "sprites.hpp"
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <iostream>
+#include "trace.hpp"
+
+// Empty pixels around every sheet, so filtered frames do not bleed into their neighbors
+static constexpr int ATLAS_PADDING = 1;
+// Sheets wrap to a new row past this width (well within any renderer's texture limit)
+static constexpr int ATLAS_MAX_WIDTH = 2048;
+
+SpriteAtlas::~SpriteAtlas() {
+    for (SDL_Surface* s : surfaces) if (s) SDL_FreeSurface(s);
+    if (tex) SDL_DestroyTexture(tex);
+}
+
+int SpriteAtlas::addSheet(const char* path) {
+    for (size_t k = 0; k < paths.size(); ++k)
+        if (paths[k] == path) return (int)k;
+    if (tex) { std::cerr << "[Warn] SpriteAtlas: " << path << " agregado después de build()\n"; return -1; }
+
+    SDL_Surface* s = IMG_Load(path);
+    if (!s) { std::cerr << "IMG_Load(" << path << "): " << IMG_GetError() << "\n"; return -1; }
+    paths.push_back(path);
+    surfaces.push_back(s);
+    rects.push_back({0, 0, s->w, s->h});
+    return (int)surfaces.size() - 1;
+}
+
+bool SpriteAtlas::build(SDL_Renderer* renderer) {
+    if (tex || surfaces.empty()) return tex != nullptr;
+
+    // Shelf packing: tallest sheets first, left to right, a new row when the width runs out
+    std::vector<size_t> order(surfaces.size());
+    for (size_t k = 0; k < order.size(); ++k) order[k] = k;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return rects[a].h > rects[b].h; });
+    int x = ATLAS_PADDING, y = ATLAS_PADDING, rowH = 0;
+    w = h = 0;
+    for (size_t k : order) {
+        SDL_Rect& r = rects[k];
+        if (x > ATLAS_PADDING && x + r.w + ATLAS_PADDING > ATLAS_MAX_WIDTH) {
+            x = ATLAS_PADDING;
+            y += rowH + ATLAS_PADDING;
+            rowH = 0;
+        }
+        r.x = x; r.y = y;
+        x += r.w + ATLAS_PADDING;
+        rowH = std::max(rowH, r.h);
+        w = std::max(w, x);
+        h = std::max(h, y + r.h + ATLAS_PADDING);
+    }
+
+    SDL_Surface* packed = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!packed) { std::cerr << "SDL_CreateRGBSurfaceWithFormat: " << SDL_GetError() << "\n"; return false; }
+    SDL_FillRect(packed, nullptr, SDL_MapRGBA(packed->format, 0, 0, 0, 0));
+    for (size_t k = 0; k < surfaces.size(); ++k) {
+        // Copy the pixels as they are (alpha included) instead of blending them over the empty atlas
+        SDL_SetSurfaceBlendMode(surfaces[k], SDL_BLENDMODE_NONE);
+        SDL_Rect dst = rects[k];
+        SDL_BlitSurface(surfaces[k], nullptr, packed, &dst);
+    }
+
+    tex = SDL_CreateTextureFromSurface(renderer, packed);
+    SDL_FreeSurface(packed);
+    if (!tex) { std::cerr << "SDL_CreateTextureFromSurface: " << SDL_GetError() << "\n"; return false; }
+    SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+    for (SDL_Surface* s : surfaces) SDL_FreeSurface(s);
+    surfaces.clear();
+    return true;
+}
+
+void SpriteStrip::resolve(const SpriteAtlas& atlas) {
+    if (!loaded()) return;
+    const SDL_Rect& r = atlas.sheet(sheet);
+    texW = r.w; texH = r.h;
+    x = r.x + marginX;
+    y = r.y + marginY;
+    if (frames <= 0) {
+        const int usableW = texW - marginX;
+        const int perRow  = std::max(0, usableW + spacingX) / (fw + spacingX);
+        frames = std::max(1, perRow);
+    }
+}
+
+void SpriteBatch::begin(const SpriteAtlas& a) {
+    atlas = &a;
+    invW = a.width() > 0 ? 1.f / a.width() : 0.f;
+    invH = a.height() > 0 ? 1.f / a.height() : 0.f;
+    vertices.clear();
+}
+
+void SpriteBatch::add(const SDL_Rect& src, const SDL_FRect& dst, SDL_Color tint) {
+    const float u0 = src.x * invW, v0 = src.y * invH;
+    const float u1 = (src.x + src.w) * invW, v1 = (src.y + src.h) * invH;
+    const float x0 = dst.x, y0 = dst.y, x1 = dst.x + dst.w, y1 = dst.y + dst.h;
+    vertices.push_back({{x0, y0}, tint, {u0, v0}});
+    vertices.push_back({{x1, y0}, tint, {u1, v0}});
+    vertices.push_back({{x1, y1}, tint, {u1, v1}});
+    vertices.push_back({{x0, y1}, tint, {u0, v1}});
+}
+
+void SpriteBatch::draw(SDL_Renderer* renderer) {
+    TRACE_SCOPE("render.sprites");
+    const size_t sprites = spriteCount();
+    if (sprites == 0 || !atlas || !atlas->texture()) return;
+    // Two triangles per quad; the pattern only depends on the sprite index, so it is kept
+    for (size_t q = indices.size() / 6; q < sprites; ++q) {
+        const int b = (int)(4 * q);
+        indices.insert(indices.end(), {b, b + 1, b + 2, b, b + 2, b + 3});
+    }
+    SDL_RenderGeometry(renderer, atlas->texture(), vertices.data(), (int)vertices.size(),
+                       indices.data(), (int)(6 * sprites));
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <string>
+#include <vector>
+
+// Sprite sheets packed into one texture. Sheets are loaded with IMG_Load (each path
+// once) and kept as surfaces until build() blits them side by side into a single
+// atlas and uploads it, so every sprite of every actor samples the same texture.
+class SpriteAtlas {
+public:
+    SpriteAtlas() = default;
+    ~SpriteAtlas();
+    SpriteAtlas(const SpriteAtlas&) = delete;
+    SpriteAtlas& operator=(const SpriteAtlas&) = delete;
+
+    // Adds a sheet image; returns its id (the same for a path added before), -1 on error.
+    // Only valid before build().
+    int addSheet(const char* path);
+
+    // Packs the sheets and creates the texture; false (and no texture) on error
+    bool build(SDL_Renderer* renderer);
+
+    // Where sheet 'id' ended up in the atlas (its size before build())
+    const SDL_Rect& sheet(int id) const { return rects[id]; }
+    SDL_Texture* texture() const { return tex; }
+    int width() const { return w; }
+    int height() const { return h; }
+
+private:
+    std::vector<std::string> paths;
+    std::vector<SDL_Surface*> surfaces;   // until build()
+    std::vector<SDL_Rect> rects;
+    SDL_Texture* tex = nullptr;
+    int w = 0, h = 0;
+};
+
+// One animation: a row of equally sized frames inside an atlas sheet
+struct SpriteStrip {
+    int sheet = -1;           // atlas sheet (-1 = not loaded)
+    int x = 0, y = 0;         // first frame in the atlas (set by resolve())
+    int texW = 0, texH = 0;   // sheet size
+    int fw = 31, fh = 36;     // frame size
+    int frames = -1;          // number of frames (-1 = as many as fit in the sheet)
+    float frameDur = 0.05f;   // seg x frame
+    int marginX = 0, marginY = 0; // margin in sheet
+    int spacingX = 0;         // horizontal spacing between frames
+
+    bool loaded() const { return sheet >= 0; }
+
+    // Locates the strip in the built atlas and fixes the frame count
+    void resolve(const SpriteAtlas& atlas);
+
+    // Source rectangle of frame f (wraps around)
+    SDL_Rect frame(int f) const {
+        const int col = f % frames;
+        return { x + col * (fw + spacingX), y, fw, fh };
+    }
+};
+
+// Textured quads of one atlas, submitted with a single SDL_RenderGeometry call.
+// Like BoidBatch, the buffers persist between frames and only grow.
+class SpriteBatch {
+public:
+    // Starts a new batch of sprites from 'atlas'
+    void begin(const SpriteAtlas& atlas);
+    // Queues the 'src' rectangle of the atlas drawn at 'dst'; later sprites draw on top
+    void add(const SDL_Rect& src, const SDL_FRect& dst, SDL_Color tint = {255, 255, 255, 255});
+    // Draws every queued sprite (nothing when empty or the atlas has no texture)
+    void draw(SDL_Renderer* renderer);
+
+    size_t spriteCount() const { return vertices.size() / 4; }
+
+private:
+    const SpriteAtlas* atlas = nullptr;
+    float invW = 0.f, invH = 0.f;   // pixels to texture coordinates
+    std::vector<SDL_Vertex> vertices; // 4 per sprite
+    std::vector<int> indices;         // 6 per sprite, same pattern for every quad
+};
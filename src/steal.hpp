@@ -0,0 +1,77 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Work-stealing over weighted work items (e.g. cell ranges of a grid, weighted
+// by occupancy^2). partition() gives every thread one contiguous run of items of
+// about the same total weight; next() pops from the front of the caller's own
+// run and, once it is empty, steals single items from the back of the others'.
+// A run is a packed (head, tail) pair updated by CAS, so nobody ever locks and
+// the owner keeps walking its items in order (neighboring cells stay in cache).
+class WorkStealing {
+    struct alignas(64) Run {
+        std::atomic<uint64_t> bounds{0};   // head << 32 | tail
+    };
+    std::unique_ptr<Run[]> runs;
+    int numRuns = 0, allocated = 0;
+    std::atomic<uint32_t> steals{0};
+
+    static uint64_t pack(uint32_t head, uint32_t tail) { return (uint64_t)head << 32 | tail; }
+    static uint32_t headOf(uint64_t b) { return (uint32_t)(b >> 32); }
+    static uint32_t tailOf(uint64_t b) { return (uint32_t)b; }
+
+public:
+    // Splits items [0, count) among 'threads' runs; call from one thread before any next()
+    void partition(const float* weights, size_t count, int threads) {
+        if (threads > allocated) {
+            runs.reset(new Run[threads]);
+            allocated = threads;
+        }
+        numRuns = threads;
+        steals.store(0, std::memory_order_relaxed);
+
+        double total = 0.0;
+        for (size_t i = 0; i < count; ++i) total += weights[i];
+        // An item goes to the run that holds the midpoint of its weight
+        double acc = 0.0;
+        size_t item = 0;
+        for (int t = 0; t < threads; ++t) {
+            const size_t begin = item;
+            const double limit = total * (t + 1) / threads;
+            while (item < count && (t == threads - 1 || acc + 0.5 * weights[item] < limit)) {
+                acc += weights[item];
+                ++item;
+            }
+            runs[t].bounds.store(pack((uint32_t)begin, (uint32_t)item), std::memory_order_relaxed);
+        }
+    }
+
+    // Next item for 'thread'; false once every run is empty
+    bool next(int thread, uint32_t& item) {
+        std::atomic<uint64_t>& own = runs[thread].bounds;
+        uint64_t b = own.load(std::memory_order_acquire);
+        while (headOf(b) < tailOf(b)) {
+            if (own.compare_exchange_weak(b, pack(headOf(b) + 1, tailOf(b)), std::memory_order_acq_rel)) {
+                item = headOf(b);
+                return true;
+            }
+        }
+        for (int v = 1; v < numRuns; ++v) {
+            std::atomic<uint64_t>& victim = runs[(thread + v) % numRuns].bounds;
+            b = victim.load(std::memory_order_acquire);
+            while (headOf(b) < tailOf(b)) {
+                if (victim.compare_exchange_weak(b, pack(headOf(b), tailOf(b) - 1), std::memory_order_acq_rel)) {
+                    item = tailOf(b) - 1;
+                    steals.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Items taken from another thread's run since partition()
+    uint32_t stolen() const { return steals.load(std::memory_order_relaxed); }
+};
@@ -0,0 +1,145 @@
+#include "trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <omp.h>
+
+namespace trace {
+
+std::atomic<bool> gEnabled{false};
+std::atomic<bool> gBusy{false};
+
+namespace {
+
+struct Event {
+    const char* name;
+    uint64_t beginNs, endNs;
+    double value;   // counter sample when endNs == COUNTER
+};
+
+constexpr uint64_t COUNTER = UINT64_MAX;
+
+// Single-producer ring: only the owning thread writes, dump() reads at the end.
+// When full the oldest events are overwritten.
+struct ThreadBuffer {
+    static constexpr size_t CAPACITY = 1 << 16;
+    std::vector<Event> ring;
+    std::atomic<uint64_t> head{0};  // total events ever written
+    int tid = 0;
+    std::string name;
+};
+
+const std::chrono::steady_clock::time_point gBase = std::chrono::steady_clock::now();
+
+constexpr int MAX_BUSY_THREADS = 256;
+std::atomic<uint64_t> gBusyNs[MAX_BUSY_THREADS];
+
+// Buffers outlive their threads so late dumps still see OpenMP workers' events
+std::mutex gRegistryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> gBuffers;
+
+thread_local ThreadBuffer* tBuffer = nullptr;
+
+ThreadBuffer& localBuffer() {
+    if (!tBuffer) {
+        auto buf = std::make_unique<ThreadBuffer>();
+        buf->ring.resize(ThreadBuffer::CAPACITY);
+        std::lock_guard<std::mutex> lock(gRegistryMutex);
+        buf->tid = (int)gBuffers.size();
+        buf->name = "thread " + std::to_string(buf->tid);
+        tBuffer = buf.get();
+        gBuffers.push_back(std::move(buf));
+    }
+    return *tBuffer;
+}
+
+} // namespace
+
+void enable() {
+    gEnabled.store(true, std::memory_order_relaxed);
+}
+
+void collectBusy(bool on) {
+    gBusy.store(on, std::memory_order_relaxed);
+}
+
+void addBusy(uint64_t ns) {
+    const int t = std::min(omp_get_thread_num(), MAX_BUSY_THREADS - 1);
+    gBusyNs[t].fetch_add(ns, std::memory_order_relaxed);
+}
+
+void takeBusy(std::vector<double>& msPerThread, int threads) {
+    threads = std::clamp(threads, 0, MAX_BUSY_THREADS);
+    msPerThread.resize(threads);
+    for (int t = 0; t < threads; ++t)
+        msPerThread[t] = gBusyNs[t].exchange(0, std::memory_order_relaxed) / 1e6;
+}
+
+uint64_t now() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - gBase).count();
+}
+
+void record(const char* name, uint64_t beginNs, uint64_t endNs) {
+    ThreadBuffer& b = localBuffer();
+    const uint64_t h = b.head.load(std::memory_order_relaxed);
+    b.ring[h % ThreadBuffer::CAPACITY] = {name, beginNs, endNs, 0.0};
+    b.head.store(h + 1, std::memory_order_release);
+}
+
+void counter(const char* name, double value) {
+    ThreadBuffer& b = localBuffer();
+    const uint64_t h = b.head.load(std::memory_order_relaxed);
+    b.ring[h % ThreadBuffer::CAPACITY] = {name, now(), COUNTER, value};
+    b.head.store(h + 1, std::memory_order_release);
+}
+
+void setThreadName(const char* name) {
+    ThreadBuffer& b = localBuffer();
+    std::lock_guard<std::mutex> lock(gRegistryMutex);
+    b.name = name;
+}
+
+bool dump(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "[Error] trace: no se pudo abrir " << path << "\n";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(gRegistryMutex);
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    size_t total = 0;
+    for (const auto& b : gBuffers) {
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->tid
+            << ",\"args\":{\"name\":\"" << b->name << "\"}}";
+        first = false;
+
+        const uint64_t head = b->head.load(std::memory_order_acquire);
+        const uint64_t count = std::min<uint64_t>(head, ThreadBuffer::CAPACITY);
+        for (uint64_t k = head - count; k < head; ++k) {
+            const Event& e = b->ring[k % ThreadBuffer::CAPACITY];
+            // Chrome expects microseconds
+            if (e.endNs == COUNTER) {
+                out << ",\n{\"name\":\"" << e.name << "\",\"ph\":\"C\",\"pid\":1,\"ts\":" << e.beginNs / 1000.0
+                    << ",\"args\":{\"value\":" << e.value << "}}";
+                continue;
+            }
+            out << ",\n{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->tid
+                << ",\"ts\":" << e.beginNs / 1000.0 << ",\"dur\":" << (e.endNs - e.beginNs) / 1000.0 << "}";
+        }
+        total += count;
+    }
+    out << "\n]}\n";
+    std::cerr << "[trace] " << total << " eventos escritos en " << path << "\n";
+    return true;
+}
+
+} // namespace trace
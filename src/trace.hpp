@@ -0,0 +1,90 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Lightweight phase tracing. Each thread records (name, begin, end) events into
+// its own ring buffer with no locks on the hot path; dump() writes everything as
+// Chrome trace_event JSON (open in chrome://tracing or https://ui.perfetto.dev).
+// When tracing is off a TRACE_SCOPE costs one relaxed load and a branch
+// (TRACE_WORK two loads).
+namespace trace {
+
+extern std::atomic<bool> gEnabled;
+extern std::atomic<bool> gBusy;
+
+inline bool enabled() { return gEnabled.load(std::memory_order_relaxed); }
+inline bool busyEnabled() { return gBusy.load(std::memory_order_relaxed); }
+
+// Starts recording events
+void enable();
+
+// Per-OpenMP-thread busy totals for TRACE_WORK scopes (independent of event recording)
+void collectBusy(bool on);
+void addBusy(uint64_t ns);   // adds to the calling thread's omp_get_thread_num() slot
+// Busy milliseconds per thread since the previous call, then resets the counters
+void takeBusy(std::vector<double>& msPerThread, int threads);
+
+// Nanoseconds since the trace time base
+uint64_t now();
+
+// Appends a finished event to the calling thread's ring buffer.
+// 'name' must outlive the trace (use string literals).
+void record(const char* name, uint64_t beginNs, uint64_t endNs);
+
+// Appends a sample of a counter track (e.g. cache misses per step), drawn as a graph
+void counter(const char* name, double value);
+
+// Labels the calling thread in the trace viewer
+void setThreadName(const char* name);
+
+// Writes every buffered event; false (and a message on stderr) if the file can't be written.
+// Call it once recording threads are idle.
+bool dump(const std::string& path);
+
+// Records the enclosing scope as one event
+class ScopedTimer {
+public:
+    explicit ScopedTimer(const char* n) : name(enabled() ? n : nullptr) {
+        if (name) begin = now();
+    }
+    ~ScopedTimer() {
+        if (name) record(name, begin, now());
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    const char* name;
+    uint64_t begin = 0;
+};
+
+// Like ScopedTimer, and also counted as busy time of the current OpenMP thread.
+// Use it for the per-thread share of a worksharing loop (before its barrier).
+class WorkTimer {
+public:
+    explicit WorkTimer(const char* n) : name(n), active(enabled() || busyEnabled()) {
+        if (active) begin = now();
+    }
+    ~WorkTimer() {
+        if (!active) return;
+        const uint64_t end = now();
+        if (enabled()) record(name, begin, end);
+        if (busyEnabled()) addBusy(end - begin);
+    }
+    WorkTimer(const WorkTimer&) = delete;
+    WorkTimer& operator=(const WorkTimer&) = delete;
+
+private:
+    const char* name;
+    bool active;
+    uint64_t begin = 0;
+};
+
+} // namespace trace
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) ::trace::ScopedTimer TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define TRACE_WORK(name)  ::trace::WorkTimer   TRACE_CONCAT(traceWork_, __LINE__)(name)